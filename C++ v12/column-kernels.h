@@ -0,0 +1,56 @@
+#include <stdint.h>
+#include "math-utils.h"
+
+#ifndef COLUMN_KERNELS_H
+#define COLUMN_KERNELS_H
+
+// The per-chunk operations of the single-column sieve, shared by two-three-decisions.cpp
+// and roofline-benchmark.cpp so that the benchmark times exactly what the engine runs.
+
+const int CHUNK_BITS = 64;
+
+// These are accurate when the first bit represents the value 1.
+// Otherwise, you need to adjust the input/output (TODO: Detail how)
+//	#define numToBitPos(number) \
+//		((number) - ((number) / 3) - 1)
+//	#define bitPosToNum(bitPos) \
+//		((bitPos) + ((bitPos) / 2) + 1)
+inline uint64_t numToBitPos(uint64_t number) {
+	return number - (uint64_t)(number/3) - 1;
+}
+inline uint64_t bitPosToNum(uint64_t bitPos) {
+	return bitPos + (uint64_t)(bitPos/2) + 1;
+}
+
+#define copyAlongToDoubleCurrentPos_macro(expRegCol, sourceChunkNum, chunksAdjustment) { \
+	uint64_t spread1 = 0; \
+	uint64_t spread2 = 0; \
+	\
+	spreadBitsPaired_macro((expRegCol)[sourceChunkNum], spread1, spread2); \
+	\
+	spread1 <<= 1; \
+	spread2 <<= 1; \
+	\
+	uint64_t destChunksPos = ((sourceChunkNum) << 1) + (chunksAdjustment); \
+	(expRegCol)[destChunksPos] |= spread1; \
+	(expRegCol)[destChunksPos + 1] |= spread2; \
+}
+
+#define copyAlongToDoubleCurrentPos_macroBitAdjusted(expRegCol, sourceChunkNum, chunksAdjustment, bitsAdjustment, bitsAdjustmentComplement) { \
+	uint64_t spread1 = 0; \
+	uint64_t spread2 = 0; \
+	\
+	spreadBitsPaired_macro((expRegCol)[sourceChunkNum], spread1, spread2); \
+	\
+	spread1 <<= 1; \
+	spread2 <<= 1; \
+	\
+	uint64_t destChunksPos = ((sourceChunkNum) << 1) + (chunksAdjustment); \
+	(expRegCol)[destChunksPos] |= spread1 << (bitsAdjustment); \
+	\
+	(expRegCol)[destChunksPos + 1] |= (spread2 << (bitsAdjustment)) | (spread1 >> (bitsAdjustmentComplement)); \
+	\
+	(expRegCol)[destChunksPos + 2] |= spread2 >> (bitsAdjustmentComplement); \
+}
+
+#endif
\ No newline at end of file
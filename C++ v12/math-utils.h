@@ -3,38 +3,36 @@
 #ifndef MATH_UTILS_H
 #define MATH_UTILS_H
 
-extern int math_power_copy;
-extern uint64_t math_n_copy;
-
-extern uint64_t threePowers[40];
-extern char floorLog2Lookup_64bit[64];
-
 void spreadAndOrBits(uint64_t x, uint64_t *low, uint64_t *high);
 void spreadAndOrBits_noMult3(uint64_t x, uint64_t *low, uint64_t *high);
 void spreadBitsPaired(uint64_t x, uint64_t *low, uint64_t *high);
 
-#define threeToThe(power) ( \
-	math_power_copy = (power), \
-	math_power_copy >= 40 \
-	? (cout << "Error: overflow in 3^n function" << endl, exit(-1), 0) \
-	: \
-	threePowers[math_power_copy] \
-)
-
-#define floorLog2_64bit(n) ( \
-	math_n_copy = (n), \
-	math_n_copy |= math_n_copy >> 1, \
-	math_n_copy |= math_n_copy >> 2, \
-	math_n_copy |= math_n_copy >> 4, \
-	math_n_copy |= math_n_copy >> 8, \
-	math_n_copy |= math_n_copy >> 16, \
-	math_n_copy |= math_n_copy >> 32, \
-	floorLog2Lookup_64bit[(math_n_copy * 0x03f6eaf2cd271461) >> 58] \
-)
+// Compile-time table, so threeToThe() is a single load (or folds away for a constant power)
+constexpr uint64_t threePowers[40] = {
+	1ull, 3ull, 9ull, 27ull, 81ull, 243ull, 729ull, 2187ull, 6561ull, 19683ull, 59049ull, 177147ull,
+	531441ull, 1594323ull, 4782969ull, 14348907ull, 43046721ull, 129140163ull, 387420489ull, 1162261467ull,
+	3486784401ull, 10460353203ull, 31381059609ull, 94143178827ull, 282429536481ull, 847288609443ull,
+	2541865828329ull, 7625597484987ull, 22876792454961ull, 68630377364883ull, 205891132094649ull,
+	617673396283947ull, 1853020188851841ull, 5559060566555523ull, 16677181699666569ull, 50031545098999707ull,
+	150094635296999121ull, 450283905890997363ull, 1350851717672992089ull, 4052555153018976267ull
+};
+
+// Unchecked: power must be < 40. Anything that could ask for more checks once up front
+// (e.g. against the max value), rather than on every call
+constexpr uint64_t threeToThe(int power) {
+	return threePowers[power];
+}
+
+//Note: returns 0 for n == 0, same as the De Bruijn lookup this replaces
+constexpr int floorLog2_64bit(uint64_t n) {
+	return n == 0 ? 0 : 63 - __builtin_clzll(n);
+}
 
 //Note: returns true for n == 0
 //Source: http://www.graphics.stanford.edu/~seander/bithacks.html#DetermineIfPowerOf2
-#define isPowerOf2(n) (math_n_copy = (n), (math_n_copy & (math_n_copy - 1)) == 0)
+constexpr bool isPowerOf2(uint64_t n) {
+	return (n & (n - 1)) == 0;
+}
 
 // input:   1  2  4  5  7  8  10 11 13 14 16 17 19 20 22 23 25 26 28 29 31 ...
 // maps to: 0  1  2  3  4  5  6  7  8  9  10 11 12 13 14 15 16 17 18 19 20 ...
@@ -0,0 +1,300 @@
+// Measures how close the doubling+aggregate pass of the single-column sieve gets to the memory
+// bandwidth of the machine it's running on. For each array size, this times a STREAM-style copy
+// and scale (taking the faster as the "peak" for that size), then times the real pass from
+// column-kernels.h along with variants that carry the spill word in a register and/or prefetch
+// the 2c+adj destination stream. If the pass is already close to the peak, there's not much point
+// shaving more ALU work off the spread kernels.
+//
+// There are no non-temporal store variants: every 2c+adj destination chunk already holds bits from
+// earlier columns that the doubling ORs into, so it has to be read before it's written, and
+// streaming a store to a line that's just been loaded only forces it back out of the cache. Timing
+// that measures the cache-line thrash, not the cost of bypassing the cache.
+//
+// Everything here is single threaded, as is the engine, so the peak is the single core peak.
+//
+// Usage: a.out [--reps=N] [--prefetch=D] [sizeInChunks ...]
+
+#include "math-utils.h"
+#include "column-kernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Bytes each kernel actually needs to move per element/chunk, not counting write-allocate traffic
+// (the same convention STREAM uses):
+// copy:  8 read + 8 written
+// scale: 8 read + 8 written
+// pass:  8 read from the source chunk, 16 read + 16 written at 2c+adj, 8 read + 8 written in the aggregate
+const uint64_t STREAM_BYTES_PER_ELEMENT = 16;
+const uint64_t PASS_BYTES_PER_CHUNK = 56;
+
+// Offset of the first bit from column 3^5 onwards, so the bit-adjusted kernel is used, as it is for most real columns.
+const uint64_t BENCH_FIRST_BIT_VALUE = 1 + 3 + 9 + 27 + 81 + 243;
+
+// Aim for each timed trial to touch at least this many chunks, so small (in-cache) sizes
+// still take long enough to time accurately.
+const uint64_t MIN_CHUNKS_PER_TRIAL = 1ULL << 24;
+
+void fillPseudoRandom(uint64_t *arr, uint64_t length, uint64_t seed) {
+	// xorshift64, just needs to not be all zeros/ones - the kernels are branchless anyway
+	uint64_t x = seed | 1;
+	for (uint64_t i = 0; i < length; i++) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		arr[i] = x;
+	}
+}
+
+// Stops the compiler from merging or skipping repeated stream loops over the same arrays
+inline void clobberMemory() {
+	asm volatile("" : : : "memory");
+}
+
+void streamCopy(const uint64_t *a, uint64_t *b, uint64_t length) {
+	for (uint64_t i = 0; i < length; i++) {
+		b[i] = a[i];
+	}
+}
+
+void streamScale(const uint64_t *a, uint64_t *b, uint64_t length) {
+	for (uint64_t i = 0; i < length; i++) {
+		b[i] = 3 * a[i];
+	}
+}
+
+uint64_t getLastChunkToDouble(uint64_t colLength, uint64_t chunksAdjustment) {
+	return (colLength - chunksAdjustment - 1) / 2;
+}
+
+// The real doubling+aggregate pass, as run by findAndPrintZeros() when bitsAdjustment != 0
+void doublingAggregatePass(uint64_t *expRegCol, uint64_t *colsAggregate, uint64_t colLength, uint64_t chunksAdjustment, uint64_t bitsAdjustment) {
+	uint64_t bitsAdjustmentComplement = CHUNK_BITS - bitsAdjustment;
+	uint64_t lastChunkToDouble = getLastChunkToDouble(colLength, chunksAdjustment);
+	
+	for (uint64_t chunk = 0; chunk < lastChunkToDouble; chunk++) {
+		copyAlongToDoubleCurrentPos_macroBitAdjusted(expRegCol, chunk, chunksAdjustment, bitsAdjustment, bitsAdjustmentComplement);
+		
+		uint64_t* aggChunks = colsAggregate + chunk + chunksAdjustment;
+		aggChunks[0] |= expRegCol[chunk] << bitsAdjustment;
+		aggChunks[1] |= expRegCol[chunk] >> bitsAdjustmentComplement;
+	}
+}
+
+// Same result as doublingAggregatePass(), but the word that spills into 2c+adj+2 is carried in a
+// register and merged into the next iteration's first word, so each destination chunk is loaded
+// and stored exactly once, in order, where the reference pass ORs into 2c+adj+2 and then reads it
+// straight back on the next iteration.
+// Requires chunksAdjustment > 0, so that a source chunk is never also the destination of its own doubling.
+template <bool prefetch>
+void doublingAggregatePass_streaming(uint64_t *expRegCol, uint64_t *colsAggregate, uint64_t colLength, uint64_t chunksAdjustment, uint64_t bitsAdjustment, uint64_t prefetchDistance) {
+	uint64_t bitsAdjustmentComplement = CHUNK_BITS - bitsAdjustment;
+	uint64_t lastChunkToDouble = getLastChunkToDouble(colLength, chunksAdjustment);
+	
+	uint64_t destCarry = 0;
+	uint64_t aggCarry = 0;
+	uint64_t chunk = 0;
+	for (; chunk < lastChunkToDouble; chunk++) {
+		uint64_t source = expRegCol[chunk];
+		uint64_t destChunksPos = (chunk << 1) + chunksAdjustment;
+		
+		if (prefetch) {
+			// prefetching past the end of the array is harmless, prefetches never fault
+			__builtin_prefetch(expRegCol + destChunksPos + prefetchDistance, 1, 0);
+		}
+		
+		uint64_t spread1;
+		uint64_t spread2;
+		spreadBitsPaired_macro(source, spread1, spread2);
+		spread1 <<= 1;
+		spread2 <<= 1;
+		
+		uint64_t dest0 = expRegCol[destChunksPos] | (spread1 << bitsAdjustment) | destCarry;
+		uint64_t dest1 = expRegCol[destChunksPos + 1] | (spread2 << bitsAdjustment) | (spread1 >> bitsAdjustmentComplement);
+		destCarry = spread2 >> bitsAdjustmentComplement;
+		expRegCol[destChunksPos] = dest0;
+		expRegCol[destChunksPos + 1] = dest1;
+		
+		uint64_t* aggChunk = colsAggregate + chunk + chunksAdjustment;
+		*aggChunk |= (source << bitsAdjustment) | aggCarry;
+		aggCarry = source >> bitsAdjustmentComplement;
+	}
+	
+	if (chunk > 0) {
+		expRegCol[(chunk << 1) + chunksAdjustment] |= destCarry;
+		colsAggregate[chunk + chunksAdjustment] |= aggCarry;
+	}
+}
+
+struct benchResult {
+	double bestSeconds;
+	uint64_t bytesPerTrial;
+};
+
+double gbPerSec(struct benchResult result) {
+	return result.bytesPerTrial / result.bestSeconds / 1e9;
+}
+
+// Times `trial` `reps` times and keeps the fastest, like STREAM does
+template <typename Trial>
+struct benchResult timeBest(int reps, uint64_t bytesPerTrial, Trial trial) {
+	struct benchResult result;
+	result.bestSeconds = 1e300;
+	result.bytesPerTrial = bytesPerTrial;
+	
+	for (int rep = 0; rep < reps; rep++) {
+		auto start = chrono::steady_clock::now();
+		trial();
+		auto end = chrono::steady_clock::now();
+		
+		chrono::duration<double> elapsed = end - start;
+		result.bestSeconds = min(result.bestSeconds, elapsed.count());
+	}
+	return result;
+}
+
+bool passVariantsAgree(uint64_t colLength, uint64_t chunksAdjustment, uint64_t bitsAdjustment, uint64_t prefetchDistance) {
+	vector<uint64_t> initialCol(colLength + 2);
+	vector<uint64_t> initialAgg(colLength + 1);
+	fillPseudoRandom(initialCol.data(), colLength, 0x9E3779B97F4A7C15ULL);
+	fillPseudoRandom(initialAgg.data(), colLength, 0xC2B2AE3D27D4EB4FULL);
+	// make the values sparse-ish so ORing doesn't just saturate everything
+	for (uint64_t i = 0; i < colLength; i++) {
+		initialCol[i] &= initialAgg[i];
+		initialAgg[i] &= initialAgg[i] >> 7;
+	}
+	
+	vector<uint64_t> refCol = initialCol;
+	vector<uint64_t> refAgg = initialAgg;
+	doublingAggregatePass(refCol.data(), refAgg.data(), colLength, chunksAdjustment, bitsAdjustment);
+	
+	#define checkVariant(prefetch) { \
+		vector<uint64_t> col = initialCol; \
+		vector<uint64_t> agg = initialAgg; \
+		doublingAggregatePass_streaming<prefetch>(col.data(), agg.data(), colLength, chunksAdjustment, bitsAdjustment, prefetchDistance); \
+		if (col != refCol || agg != refAgg) { \
+			cout << "Error: streaming pass (prefetch = " << prefetch \
+				<< ") disagrees with the reference pass for colLength = " << colLength << endl; \
+			return false; \
+		} \
+	}
+	
+	checkVariant(false);
+	checkVariant(true);
+	
+	#undef checkVariant
+	
+	return true;
+}
+
+void printRow(string name, struct benchResult result, double peak) {
+	double rate = gbPerSec(result);
+	cout << "  " << left << setw(26) << name << right
+		<< setw(10) << fixed << setprecision(2) << rate << " GB/s"
+		<< setw(9) << setprecision(1) << (100 * rate / peak) << "% of peak"
+		<< endl;
+}
+
+void benchmarkSize(uint64_t colLength, int reps, uint64_t prefetchDistance) {
+	uint64_t adjustment = numToBitPos(BENCH_FIRST_BIT_VALUE);
+	uint64_t chunksAdjustment = adjustment / CHUNK_BITS;
+	uint64_t bitsAdjustment = adjustment % CHUNK_BITS;
+	
+	if (colLength <= chunksAdjustment * 2 + 2) {
+		cout << "Skipping colLength = " << colLength << ", too small" << endl;
+		return;
+	}
+	
+	if (!passVariantsAgree(min(colLength, (uint64_t)1 << 16), chunksAdjustment, bitsAdjustment, prefetchDistance)) {
+		exit(-1);
+	}
+	
+	uint64_t innerLoops = max((uint64_t)1, MIN_CHUNKS_PER_TRIAL / colLength);
+	
+	uint64_t *a = new uint64_t[colLength + 2]();
+	uint64_t *b = new uint64_t[colLength + 2]();
+	fillPseudoRandom(a, colLength + 2, 1);
+	fillPseudoRandom(b, colLength + 2, 2);
+	
+	uint64_t streamBytes = STREAM_BYTES_PER_ELEMENT * colLength * innerLoops;
+	struct benchResult copyResult = timeBest(reps, streamBytes, [&]() {
+		for (uint64_t i = 0; i < innerLoops; i++) {
+			streamCopy(a, b, colLength);
+			clobberMemory();
+		}
+	});
+	struct benchResult scaleResult = timeBest(reps, streamBytes, [&]() {
+		for (uint64_t i = 0; i < innerLoops; i++) {
+			streamScale(b, a, colLength);
+			clobberMemory();
+		}
+	});
+	double peak = max(gbPerSec(copyResult), gbPerSec(scaleResult));
+	
+	// a is the column, b is the aggregate from here on
+	uint64_t passBytes = PASS_BYTES_PER_CHUNK * getLastChunkToDouble(colLength, chunksAdjustment) * innerLoops;
+	
+	#define timePass(passCall) timeBest(reps, passBytes, [&]() { \
+		for (uint64_t i = 0; i < innerLoops; i++) passCall; \
+	})
+	
+	struct benchResult reference = timePass(doublingAggregatePass(a, b, colLength, chunksAdjustment, bitsAdjustment));
+	struct benchResult carried = timePass(doublingAggregatePass_streaming<false>(a, b, colLength, chunksAdjustment, bitsAdjustment, prefetchDistance));
+	struct benchResult prefetched = timePass(doublingAggregatePass_streaming<true>(a, b, colLength, chunksAdjustment, bitsAdjustment, prefetchDistance));
+	
+	#undef timePass
+	
+	cout << "colLength = " << colLength << " chunks (" << (colLength * sizeof(uint64_t) / 1024) << " KiB per array)" << endl;
+	printRow("stream copy", copyResult, peak);
+	printRow("stream scale", scaleResult, peak);
+	printRow("pass (as in engine)", reference, peak);
+	printRow("pass, carried spill", carried, peak);
+	printRow("pass, prefetch", prefetched, peak);
+	cout << endl;
+	
+	delete[] a;
+	delete[] b;
+}
+
+int main(int argc, char *argv[]) {
+	
+	if (sizeof(uint64_t) != 8) {
+		cout << "Error: unexpected uint64_t size '" << sizeof(uint64_t) << "', must be 8 bytes" << endl;
+		return -1;
+	}
+	
+	int reps = 5;
+	uint64_t prefetchDistance = 64; // in chunks, i.e. 8 cache lines ahead of the destination
+	vector<uint64_t> sizes;
+	
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--reps=", 7) == 0) {
+			reps = max(1, atoi(argv[i] + 7));
+		} else if (strncmp(argv[i], "--prefetch=", 11) == 0) {
+			prefetchDistance = strtoull(argv[i] + 11, nullptr, 10);
+		} else {
+			sizes.push_back(strtoull(argv[i], nullptr, 10));
+		}
+	}
+	
+	if (sizes.empty()) {
+		// roughly: L1, L2, L3, and well out into main memory
+		sizes = { 1ULL << 11, 1ULL << 15, 1ULL << 19, 1ULL << 24 };
+	}
+	
+	cout << "Repetitions: " << reps << ", prefetch distance: " << prefetchDistance << " chunks" << endl;
+	cout << "Peak for each size = faster of stream copy/scale at that size" << endl;
+	cout << "No non-temporal stores: every 2c+adj destination is read before it's written (ORed into), so streaming it would just evict a line that's in use" << endl << endl;
+	
+	for (uint64_t colLength : sizes) {
+		benchmarkSize(colLength, reps, prefetchDistance);
+	}
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "math-utils.h"
+#include "column-kernels.h"
 #include <atomic>
 #include <algorithm>
 #include <bitset>
@@ -18,8 +19,6 @@
 
 using namespace std;
 
-const int CHUNK_BITS = 64;
-
 void printTime() {
 	time_t time_now = chrono::system_clock::to_time_t(chrono::system_clock::now());
 	
@@ -67,19 +66,6 @@ void printUInt64Bits_cpu_reverse(uint64_t x) {
 	}
 }
 
-// These are accurate when the first bit represents the value 1.
-// Otherwise, you need to adjust the input/output (TODO: Detail how)
-//	#define numToBitPos(number) \
-//		((number) - ((number) / 3) - 1)
-//	#define bitPosToNum(bitPos) \
-//		((bitPos) + ((bitPos) / 2) + 1)
-uint64_t numToBitPos(uint64_t number) {
-	return number - (uint64_t)(number/3) - 1;
-}
-uint64_t bitPosToNum(uint64_t bitPos) {
-	return bitPos + (uint64_t)(bitPos/2) + 1;
-}
-
 // the process is more complex for first chunk (as doubling
 // can leave you in the same chunk; in later chunks it never does)
 void initialiseColFirstChunk(uint64_t* chunk, uint64_t firstBitValueRepresented) {
@@ -190,37 +176,6 @@ void copyAlongToDoubleCurrentPos(uint64_t* expRegCol, uint64_t sourceChunkNum, u
 	expRegCol[destChunksPos + 2] |= spread2 >> (CHUNK_BITS - bitsAdjustment);
 }
 
-#define copyAlongToDoubleCurrentPos_macro(expRegCol, sourceChunkNum, chunksAdjustment) { \
-	uint64_t spread1 = 0; \
-	uint64_t spread2 = 0; \
-	\
-	spreadBitsPaired_macro((expRegCol)[sourceChunkNum], spread1, spread2); \
-	\
-	spread1 <<= 1; \
-	spread2 <<= 1; \
-	\
-	uint64_t destChunksPos = ((sourceChunkNum) << 1) + (chunksAdjustment); \
-	(expRegCol)[destChunksPos] |= spread1; \
-	(expRegCol)[destChunksPos + 1] |= spread2; \
-}
-
-#define copyAlongToDoubleCurrentPos_macroBitAdjusted(expRegCol, sourceChunkNum, chunksAdjustment, bitsAdjustment, bitsAdjustmentComplement) { \
-	uint64_t spread1 = 0; \
-	uint64_t spread2 = 0; \
-	\
-	spreadBitsPaired_macro((expRegCol)[sourceChunkNum], spread1, spread2); \
-	\
-	spread1 <<= 1; \
-	spread2 <<= 1; \
-	\
-	uint64_t destChunksPos = ((sourceChunkNum) << 1) + (chunksAdjustment); \
-	(expRegCol)[destChunksPos] |= spread1 << (bitsAdjustment); \
-	\
-	(expRegCol)[destChunksPos + 1] |= (spread2 << (bitsAdjustment)) | (spread1 >> (bitsAdjustmentComplement)); \
-	\
-	(expRegCol)[destChunksPos + 2] |= spread2 >> (bitsAdjustmentComplement); \
-}
-
 // Based on https://stackoverflow.com/a/26639774/4149474
 // and https://stackoverflow.com/a/239307/4149474
 // Easier to just do this than keep reallocating the arrays etc. That approach may also limit how much of the
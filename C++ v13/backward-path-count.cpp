@@ -0,0 +1,317 @@
+#include "math-utils.h"
+#include "backward-path-count.h"
+#include "backward-search.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Frontier states per thread, so threads that get cheap states aren't left idle at the end
+const uint64_t FRONTIER_STATES_PER_THREAD = 64;
+
+// States with 3^k as the last power for k up to this are counted by countLowState() without the memo.
+// 8 or 14 were both about 1.3x slower from 10^14 to 10^17.
+const int MAX_LOW_POW_OF_3 = 11;
+
+struct countFrame {
+	uint128_t value;
+	int lastPowOf3;
+	int nextStep; // 0 = subtract 3^lastPowOf3 next, 1 = halve next, 2 = both done
+	uint128_t count; // over the steps done so far
+};
+
+static uint128_t addCounts(uint128_t a, uint128_t b) {
+	uint128_t sum = a + b;
+	if (sum < a) {
+		throw overflow_error("Error: path count doesn't fit in 128 bits");
+	}
+	return sum;
+}
+
+static uint128_t multiplyCounts(uint128_t a, uint128_t b) {
+	if (b != 0 && a > (~(uint128_t)0) / b) {
+		throw overflow_error("Error: path count doesn't fit in 128 bits");
+	}
+	return a * b;
+}
+
+static struct pathCountMemoShard &shardOf(struct backwardPathCounter *counter, const struct backwardState &state) {
+	return counter->shards[backwardStateHash()(state) % BACKWARD_MEMO_SHARDS];
+}
+
+// Drops the states not used since the last time this shard filled up, then arbitrary ones if that
+// didn't free a quarter of it
+static uint64_t evictColdStates(struct backwardPathCounter *counter, struct pathCountMemoShard &shard) {
+	uint64_t sizeBefore = shard.counts.size();
+	for (auto it = shard.counts.begin(); it != shard.counts.end();) {
+		if (it->second.recentlyUsed) {
+			it->second.recentlyUsed = false;
+			++it;
+		} else {
+			it = shard.counts.erase(it);
+		}
+	}
+	
+	uint64_t target = counter->maxEntriesPerShard - counter->maxEntriesPerShard / 4;
+	for (auto it = shard.counts.begin(); it != shard.counts.end() && shard.counts.size() > target;) {
+		it = shard.counts.erase(it);
+	}
+	
+	return sizeBefore - shard.counts.size();
+}
+
+static void rememberCount(struct backwardPathCounter *counter, uint128_t value, int lastPowOf3, uint128_t count, uint64_t &evictions) {
+	struct backwardState state = { value, lastPowOf3 };
+	struct pathCountMemoShard &shard = shardOf(counter, state);
+	
+	lock_guard<mutex> guard(shard.lock);
+	if (shard.counts.size() >= counter->maxEntriesPerShard) {
+		evictions += evictColdStates(counter, shard);
+	}
+	shard.counts[state] = { count, false };
+}
+
+struct countStats {
+	uint64_t statesVisited = 0;
+	uint64_t memoHits = 0;
+	uint64_t memoEvictions = 0;
+};
+
+// Most states are near the bottom, where the memo is rarely hit & locking it costs far more than it
+// saves (10^14 took 117s memoising every state, 1s with this). With 3^k as the last power, the value
+// is 2^c * w for some c <= ctz(value), where w - 3^k has 3^(k-1) as the last power, so low states are
+// counted straight from that, without visiting each halving separately.
+static uint128_t countLowState(uint128_t value, int lastPowOf3) {
+	if (value < pow3_128.minSums[lastPowOf3] || value % 3 == 0) return 0;
+	if (lastPowOf3 <= 1) return isReachableLeaf(value, lastPowOf3) ? 1 : 0;
+	
+	uint128_t count = 0;
+	int maxHalvings = countTrailingZeros128(value);
+	for (int halvings = 0; halvings <= maxHalvings; halvings++) {
+		uint128_t w = value >> halvings;
+		if (w < pow3_128.minSums[lastPowOf3]) break;
+		count = addCounts(count, countLowState(w - pow3_128.powers[lastPowOf3], lastPowOf3 - 1));
+	}
+	return count;
+}
+
+// Sets count if (value, lastPowOf3) can be counted without recursing: pruned, a leaf, or memoised
+static bool tryCountDirectly(struct backwardPathCounter *counter, uint128_t value, int lastPowOf3, uint128_t *count, struct countStats &stats) {
+	if (value < pow3_128.minSums[lastPowOf3] || value % 3 == 0) {
+		*count = 0;
+		return true;
+	}
+	
+	if (lastPowOf3 <= MAX_LOW_POW_OF_3) {
+		*count = countLowState(value, lastPowOf3);
+		return true;
+	}
+	
+	if (counter->config.maxMemoEntries == 0) return false;
+	
+	struct backwardState state = { value, lastPowOf3 };
+	struct pathCountMemoShard &shard = shardOf(counter, state);
+	lock_guard<mutex> guard(shard.lock);
+	auto it = shard.counts.find(state);
+	if (it == shard.counts.end()) return false;
+	
+	it->second.recentlyUsed = true;
+	*count = it->second.count;
+	stats.memoHits++;
+	return true;
+}
+
+static uint128_t countFrom(struct backwardPathCounter *counter, uint128_t value, int lastPowOf3, vector<struct countFrame> &stack, struct countStats &stats) {
+	uint128_t count;
+	if (tryCountDirectly(counter, value, lastPowOf3, &count, stats)) return count;
+	
+	stack.clear();
+	stack.push_back({ value, lastPowOf3, 0, 0 });
+	stats.statesVisited++;
+	
+	while (true) {
+		struct countFrame &frame = stack.back();
+		uint128_t childValue;
+		int childPow;
+		
+		if (frame.nextStep == 0) {
+			frame.nextStep = 1;
+			childValue = frame.value - pow3_128.powers[frame.lastPowOf3];
+			childPow = frame.lastPowOf3 - 1;
+		} else if (frame.nextStep == 1) {
+			frame.nextStep = 2;
+			if (frame.value % 2 != 0) continue;
+			childValue = frame.value / 2;
+			childPow = frame.lastPowOf3;
+		} else {
+			count = frame.count;
+			if (counter->config.maxMemoEntries != 0) {
+				rememberCount(counter, frame.value, frame.lastPowOf3, count, stats.memoEvictions);
+			}
+			stack.pop_back();
+			
+			if (stack.empty()) return count;
+			stack.back().count = addCounts(stack.back().count, count);
+			continue;
+		}
+		
+		if (tryCountDirectly(counter, childValue, childPow, &count, stats)) {
+			frame.count = addCounts(frame.count, count);
+		} else {
+			stats.statesVisited++;
+			stack.push_back({ childValue, childPow, 0, 0 });
+		}
+	}
+}
+
+// Frontier states in value order, so the largest (whose routes from the target are then all known,
+// as every step back makes the value smaller) can be expanded next
+struct frontierOrder {
+	bool operator()(const struct backwardState &a, const struct backwardState &b) const {
+		return a.value != b.value ? a.value < b.value : a.lastPowOf3 < b.lastPowOf3;
+	}
+};
+
+typedef map<struct backwardState, uint128_t, struct frontierOrder> frontierMap;
+
+// Adds routes * paths(value, lastPowOf3) to the total if it's known, or adds it to the frontier otherwise.
+// countLowState() isn't used here, as its subtree could be big, & it should be counted in parallel.
+static void addToFrontier(struct backwardPathCounter *counter, uint128_t value, int lastPowOf3, uint128_t routes, frontierMap &frontier, uint128_t *total, struct countStats &stats) {
+	if (value < pow3_128.minSums[lastPowOf3] || value % 3 == 0) return;
+	
+	if (lastPowOf3 <= 1) {
+		if (isReachableLeaf(value, lastPowOf3)) *total = addCounts(*total, routes);
+		return;
+	}
+	
+	uint128_t count;
+	if (lastPowOf3 > MAX_LOW_POW_OF_3 && tryCountDirectly(counter, value, lastPowOf3, &count, stats)) {
+		*total = addCounts(*total, multiplyCounts(count, routes));
+		return;
+	}
+	
+	uint128_t &existing = frontier[{ value, lastPowOf3 }];
+	existing = addCounts(existing, routes);
+}
+
+struct frontierRun {
+	vector<pair<struct backwardState, uint128_t>> states; // with the routes to each
+	atomic<uint64_t> next;
+	
+	mutex lock; // for everything below
+	uint128_t total;
+	struct countStats stats;
+	exception_ptr error;
+};
+
+static void runFrontierWorker(struct backwardPathCounter *counter, struct frontierRun *run) {
+	struct countStats stats;
+	uint128_t total = 0;
+	exception_ptr error;
+	
+	try {
+		vector<struct countFrame> stack;
+		for (uint64_t i = run->next++; i < run->states.size(); i = run->next++) {
+			const struct backwardState &state = run->states[i].first;
+			uint128_t count = countFrom(counter, state.value, state.lastPowOf3, stack, stats);
+			total = addCounts(total, multiplyCounts(count, run->states[i].second));
+		}
+	} catch (...) {
+		error = current_exception();
+		run->next = run->states.size();
+	}
+	
+	lock_guard<mutex> guard(run->lock);
+	try {
+		run->total = addCounts(run->total, total);
+	} catch (...) {
+		error = current_exception();
+	}
+	if (error && !run->error) run->error = error;
+	run->stats.statesVisited += stats.statesVisited;
+	run->stats.memoHits += stats.memoHits;
+	run->stats.memoEvictions += stats.memoEvictions;
+}
+
+struct backwardPathCounterConfig defaultBackwardPathCounterConfig() {
+	struct backwardPathCounterConfig config;
+	config.threads = max(1u, thread::hardware_concurrency());
+	config.maxMemoEntries = 8000000; // about 700MB
+	return config;
+}
+
+struct backwardPathCounter *createBackwardPathCounter(struct backwardPathCounterConfig config) {
+	if (config.threads < 1) {
+		throw out_of_range("threads < 1");
+	}
+	
+	struct backwardPathCounter *counter = new struct backwardPathCounter;
+	counter->config = config;
+	counter->maxEntriesPerShard = max((uint64_t)4, config.maxMemoEntries / BACKWARD_MEMO_SHARDS);
+	counter->statesVisited = 0;
+	counter->memoHits = 0;
+	counter->memoEvictions = 0;
+	
+	return counter;
+}
+
+void destroyBackwardPathCounter(struct backwardPathCounter *counter) {
+	delete counter;
+}
+
+uint128_t countPathsBackward(struct backwardPathCounter *counter, uint128_t value) {
+	if (value == 0) return 0;
+	
+	struct frontierRun run;
+	run.next = 0;
+	run.total = 0;
+	
+	uint128_t total = 0;
+	frontierMap frontier;
+	for (int lastPowOf3 = maxLastPowOf3(value); lastPowOf3 >= 0; lastPowOf3--) {
+		addToFrontier(counter, value, lastPowOf3, 1, frontier, &total, run.stats);
+	}
+	
+	// Expand the largest state until there are enough to go round. The states expanded here aren't
+	// memoised, so for a small tree that never gets that wide, stop after as many steps.
+	int threads = counter->config.threads;
+	uint64_t target = threads > 1 ? threads * FRONTIER_STATES_PER_THREAD : 0;
+	for (uint64_t step = 0; step < target && !frontier.empty() && frontier.size() < target; step++) {
+		auto largest = prev(frontier.end());
+		struct backwardState state = largest->first;
+		uint128_t routes = largest->second;
+		frontier.erase(largest);
+		
+		run.stats.statesVisited++;
+		addToFrontier(counter, state.value - pow3_128.powers[state.lastPowOf3], state.lastPowOf3 - 1, routes, frontier, &total, run.stats);
+		if (state.value % 2 == 0) {
+			addToFrontier(counter, state.value / 2, state.lastPowOf3, routes, frontier, &total, run.stats);
+		}
+	}
+	
+	// Largest first, as those are likely the slowest
+	run.states.assign(frontier.rbegin(), frontier.rend());
+	
+	vector<thread> workers;
+	for (uint64_t i = 1; i < (uint64_t)threads && i < run.states.size(); i++) {
+		workers.emplace_back(runFrontierWorker, counter, &run);
+	}
+	runFrontierWorker(counter, &run);
+	for (thread &worker : workers) {
+		worker.join();
+	}
+	
+	counter->statesVisited += run.stats.statesVisited;
+	counter->memoHits += run.stats.memoHits;
+	counter->memoEvictions += run.stats.memoEvictions;
+	
+	if (run.error) rethrow_exception(run.error);
+	return addCounts(total, run.total);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <stdint.h>
+#include <mutex>
+#include <unordered_map>
+#include "backward-search.h"
+#include "math-utils.h"
+
+#ifndef BACKWARD_PATH_COUNT_H
+#define BACKWARD_PATH_COUNT_H
+
+// Counts the paths to one value, like OptionsMatrixZFinder.IterateExpansionCounts does for every
+// value up to maxZ, but for a single value far beyond what any sieve could cover (10^15 and up).
+// Works backwards over the same (value, 3^k being the last power added) states as backward-search.h,
+// with paths(v, k) = paths(v / 2, k) (if v is even) + paths(v - 3^k, k - 1), and the total being the
+// sum over every k. The same pruning applies, and with k = 0 or 1 there's at most 1 path.
+//
+// Different routes back from the value can meet at the same state, so the count of every state with
+// 3^k as the last power, for k above a dozen or so, is memoised. Below that, states are counted by
+// recursing straight over the number of halvings before each subtraction, which is far cheaper than
+// going through the memo. When a shard of the memo fills up, states that haven't been used since the
+// last time it filled up are evicted (and if that doesn't free enough, arbitrary ones), so the states
+// that keep being hit survive.
+//
+// The first few levels of the recursion are expanded into a frontier of distinct states, each with
+// the number of routes from the value down to it; the frontier states are then counted in parallel,
+// sharing the memo.
+//
+// 10^15 takes about 5s on one thread, 10^17 about a minute. Counts are 128 bits, and
+// std::overflow_error is thrown if one doesn't fit.
+
+struct backwardPathCounterConfig {
+	int threads;
+	uint64_t maxMemoEntries; // over all threads
+};
+
+struct pathCountMemoEntry {
+	uint128_t count;
+	bool recentlyUsed;
+};
+
+struct pathCountMemoShard {
+	std::mutex lock;
+	std::unordered_map<struct backwardState, struct pathCountMemoEntry, struct backwardStateHash> counts;
+};
+
+struct backwardPathCounter {
+	struct backwardPathCounterConfig config;
+	uint64_t maxEntriesPerShard;
+	
+	// Shared by every thread & kept between calls
+	struct pathCountMemoShard shards[BACKWARD_MEMO_SHARDS];
+	
+	// Totals over every call so far
+	uint64_t statesVisited;
+	uint64_t memoHits;
+	uint64_t memoEvictions;
+};
+
+struct backwardPathCounterConfig defaultBackwardPathCounterConfig();
+
+struct backwardPathCounter *createBackwardPathCounter(struct backwardPathCounterConfig config);
+void destroyBackwardPathCounter(struct backwardPathCounter *counter);
+
+// The number of paths from 1 to value (1 for value 1 itself, and 0 for a zero)
+uint128_t countPathsBackward(struct backwardPathCounter *counter, uint128_t value);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "math-utils.h"
+#include "backward-search.h"
+#include <algorithm>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+struct backwardFrame {
+	uint128_t value;
+	int lastPowOf3;
+	int nextStep; // 0 = subtract 3^lastPowOf3 next, 1 = halve next, 2 = both done
+};
+
+// With 3^0 or 3^1 as the last power, the value must be 2^a or 2^a + 3 * 2^b (a >= b) respectively,
+// i.e. 2^b * (2^(a - b) + 3). This is 2^b * 4 when a == b, or 2^b times an odd number 3 more than a
+// power of 2 otherwise.
+bool isReachableLeaf(uint128_t value, int lastPowOf3) {
+	if (lastPowOf3 == 0) return isPowerOf2_128(value);
+	
+	if (value < 4) return false;
+	uint128_t odd = value >> countTrailingZeros128(value);
+	return odd == 1 || (odd > 3 && isPowerOf2_128(odd - 3));
+}
+
+// The values from 1 to a leaf that isReachableLeaf() said yes to
+static void appendLeafPath(uint128_t value, int lastPowOf3, vector<uint128_t> *path) {
+	if (lastPowOf3 == 0) {
+		for (uint128_t n = 1; n <= value; n *= 2) path->push_back(n);
+		return;
+	}
+	
+	uint128_t odd = value >> countTrailingZeros128(value);
+	int doublingsBefore3 = odd == 1 ? 0 : floorLog2_128(odd - 3);
+	int doublingsAfter3 = odd == 1 ? countTrailingZeros128(value) - 2 : countTrailingZeros128(value);
+	
+	uint128_t n = 1;
+	path->push_back(n);
+	for (int i = 0; i < doublingsBefore3; i++) path->push_back(n *= 2);
+	path->push_back(n += 3);
+	for (int i = 0; i < doublingsAfter3; i++) path->push_back(n *= 2);
+}
+
+static bool isRememberedDead(struct backwardSearch *search, uint128_t value, int lastPowOf3) {
+	struct backwardState state = { value, lastPowOf3 };
+	
+	struct sharedBackwardMemo *memo = search->config.sharedMemo;
+	if (memo != nullptr) {
+		struct backwardMemoShard &shard = memo->shards[backwardStateHash()(state) % BACKWARD_MEMO_SHARDS];
+		lock_guard<mutex> guard(shard.lock);
+		return shard.deadStates.count(state) != 0;
+	}
+	
+	return search->config.maxMemoEntries != 0 && search->deadStates.count(state) != 0;
+}
+
+const int STATE_DEAD = 0;
+const int STATE_PUSHED = 1;
+const int STATE_FOUND = 2;
+
+// Decides what it can about (value, lastPowOf3) straight away, and otherwise pushes it to be searched
+static int tryState(struct backwardSearch *search, uint128_t value, int lastPowOf3, vector<struct backwardFrame> &stack) {
+	if (value < pow3_128.minSums[lastPowOf3] || value % 3 == 0) return STATE_DEAD;
+	
+	if (lastPowOf3 <= 1) {
+		if (!isReachableLeaf(value, lastPowOf3)) return STATE_DEAD;
+		
+		stack.push_back({ value, lastPowOf3, 2 });
+		return STATE_FOUND;
+	}
+	
+	if (isRememberedDead(search, value, lastPowOf3)) {
+		search->memoHits++;
+		return STATE_DEAD;
+	}
+	
+	search->statesVisited++;
+	stack.push_back({ value, lastPowOf3, 0 });
+	return STATE_PUSHED;
+}
+
+static void rememberDead(struct backwardSearch *search, uint128_t value, int lastPowOf3) {
+	struct backwardState state = { value, lastPowOf3 };
+	
+	struct sharedBackwardMemo *memo = search->config.sharedMemo;
+	if (memo != nullptr) {
+		struct backwardMemoShard &shard = memo->shards[backwardStateHash()(state) % BACKWARD_MEMO_SHARDS];
+		lock_guard<mutex> guard(shard.lock);
+		if (shard.deadStates.size() >= memo->maxEntriesPerShard) {
+			shard.deadStates.clear();
+		}
+		shard.deadStates.insert(state);
+		return;
+	}
+	
+	if (search->config.maxMemoEntries == 0) return;
+	
+	if (search->deadStates.size() >= search->config.maxMemoEntries) {
+		search->deadStates.clear();
+	}
+	search->deadStates.insert(state);
+}
+
+// Leaves the path to the state found on the stack (target first) if it returns true
+static bool searchFrom(struct backwardSearch *search, uint128_t value, int lastPowOf3, vector<struct backwardFrame> &stack) {
+	stack.clear();
+	
+	int result = tryState(search, value, lastPowOf3, stack);
+	if (result != STATE_PUSHED) return result == STATE_FOUND;
+	
+	while (!stack.empty()) {
+		struct backwardFrame &frame = stack.back();
+		uint128_t current = frame.value;
+		int pow = frame.lastPowOf3;
+		
+		if (frame.nextStep == 0) {
+			// tryState() only pushes values >= minSums[pow], so this never goes below minSums[pow - 1]
+			frame.nextStep = 1;
+			result = tryState(search, current - pow3_128.powers[pow], pow - 1, stack);
+		} else if (frame.nextStep == 1) {
+			frame.nextStep = 2;
+			if (current % 2 != 0) continue;
+			result = tryState(search, current / 2, pow, stack);
+		} else {
+			rememberDead(search, current, pow);
+			stack.pop_back();
+			continue;
+		}
+		
+		if (result == STATE_FOUND) return true;
+	}
+	
+	return false;
+}
+
+struct backwardSearchConfig defaultBackwardSearchConfig() {
+	struct backwardSearchConfig config;
+	config.maxMemoEntries = 2000000; // about 100MB
+	config.sharedMemo = nullptr;
+	return config;
+}
+
+struct sharedBackwardMemo *createSharedBackwardMemo(uint64_t maxEntries) {
+	struct sharedBackwardMemo *memo = new struct sharedBackwardMemo;
+	memo->maxEntriesPerShard = max((uint64_t)1, maxEntries / BACKWARD_MEMO_SHARDS);
+	return memo;
+}
+
+void destroySharedBackwardMemo(struct sharedBackwardMemo *memo) {
+	delete memo;
+}
+
+struct backwardSearch *createBackwardSearch(struct backwardSearchConfig config) {
+	struct backwardSearch *search = new struct backwardSearch;
+	search->config = config;
+	search->statesVisited = 0;
+	search->memoHits = 0;
+	
+	return search;
+}
+
+void destroyBackwardSearch(struct backwardSearch *search) {
+	delete search;
+}
+
+bool isReachableBackward(struct backwardSearch *search, uint128_t value, vector<uint128_t> *path) {
+	if (value == 0) return false;
+	
+	vector<struct backwardFrame> stack;
+	for (int lastPowOf3 = maxLastPowOf3(value); lastPowOf3 >= 0; lastPowOf3--) {
+		if (!searchFrom(search, value, lastPowOf3, stack)) continue;
+		
+		if (path != nullptr) {
+			path->clear();
+			appendLeafPath(stack.back().value, stack.back().lastPowOf3, path);
+			for (int64_t i = (int64_t)stack.size() - 2; i >= 0; i--) {
+				path->push_back(stack[i].value);
+			}
+		}
+		return true;
+	}
+	
+	return false;
+}
\ No newline at end of file
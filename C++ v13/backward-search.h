@@ -0,0 +1,122 @@
+#include <stdint.h>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "math-utils.h"
+
+#ifndef BACKWARD_SEARCH_H
+#define BACKWARD_SEARCH_H
+
+// Decides whether one value is reachable by working backwards from it, like reachable/reachableFrom
+// in the Prolog and the unfinished ZeroTester.RouteFrom1Exists_TopDown: from (value, 3^k being
+// the last power added), either halve it (if even) or subtract 3^k and go on with 3^(k-1), until
+// reaching 1 with no powers added. Works for any value below 2^128, far beyond the sieves. A path
+// to a reachable value usually turns up quickly, but showing a value is a zero means exhausting
+// every state, which takes about a second around 10^11 and grows from there.
+//
+// Pruning:
+//  - every value with 3^k as the last power is at least 1 + 3 + ... + 3^k, so a state below that
+//    is dead, and k only goes up to the largest power where that's still <= the target
+//  - reachable values are never multiples of 3
+//  - with k = 0 or 1, whether the value has the form 2^a or 2^a + 3 * 2^b (a >= b) is checked directly
+// States found to be dead are remembered (across calls too), so they're never searched twice.
+
+// 3^80 is the largest power of 3 below 2^128
+const int MAX_POW_OF_3_128 = 80;
+
+struct powersOf3_128 {
+	uint128_t powers[MAX_POW_OF_3_128 + 1];
+	uint128_t minSums[MAX_POW_OF_3_128 + 1]; // 1 + 3 + ... + 3^k, the smallest value with 3^k as the last power added
+};
+
+constexpr struct powersOf3_128 makePowersOf3_128() {
+	struct powersOf3_128 t = {};
+	t.powers[0] = 1;
+	t.minSums[0] = 1;
+	for (int k = 1; k <= MAX_POW_OF_3_128; k++) {
+		t.powers[k] = t.powers[k - 1] * 3;
+		t.minSums[k] = t.minSums[k - 1] + t.powers[k];
+	}
+	return t;
+}
+
+constexpr struct powersOf3_128 pow3_128 = makePowersOf3_128();
+
+// The largest k where a value with 3^k as the last power added can be <= value
+inline int maxLastPowOf3(uint128_t value) {
+	int k = 0;
+	while (k < MAX_POW_OF_3_128 && pow3_128.minSums[k + 1] <= value) k++;
+	return k;
+}
+
+struct sharedBackwardMemo;
+
+struct backwardSearchConfig {
+	// The memo is cleared when it gets this big. 0 turns it off.
+	uint64_t maxMemoEntries;
+	
+	// If not null, this is used instead of the search's own memo (and maxMemoEntries is ignored), so
+	// several searches can share what they've found, e.g. from different threads
+	struct sharedBackwardMemo *sharedMemo;
+};
+
+struct backwardState {
+	uint128_t value;
+	int lastPowOf3;
+	
+	bool operator==(const struct backwardState &other) const {
+		return value == other.value && lastPowOf3 == other.lastPowOf3;
+	}
+};
+
+struct backwardStateHash {
+	size_t operator()(const struct backwardState &state) const {
+		uint64_t x = (uint64_t)state.value ^ ((uint64_t)(state.value >> 64) * 0x9E3779B97F4A7C15ULL) ^ (uint64_t)state.lastPowOf3;
+		
+		// splitmix64 finaliser
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+};
+
+// Dead states, split into shards by hash each with its own lock, so threads rarely wait on each
+// other. A shard is cleared when it fills up.
+const int BACKWARD_MEMO_SHARDS = 64;
+
+struct backwardMemoShard {
+	std::mutex lock;
+	std::unordered_set<struct backwardState, struct backwardStateHash> deadStates;
+};
+
+struct sharedBackwardMemo {
+	uint64_t maxEntriesPerShard;
+	struct backwardMemoShard shards[BACKWARD_MEMO_SHARDS];
+};
+
+struct sharedBackwardMemo *createSharedBackwardMemo(uint64_t maxEntries);
+void destroySharedBackwardMemo(struct sharedBackwardMemo *memo);
+
+struct backwardSearch {
+	struct backwardSearchConfig config;
+	std::unordered_set<struct backwardState, struct backwardStateHash> deadStates;
+	
+	// Totals over every call so far
+	uint64_t statesVisited;
+	uint64_t memoHits;
+};
+
+struct backwardSearchConfig defaultBackwardSearchConfig();
+
+struct backwardSearch *createBackwardSearch(struct backwardSearchConfig config);
+void destroyBackwardSearch(struct backwardSearch *search);
+
+// If path isn't null and the value is reachable, it's filled with the values along one way of
+// reaching it, from 1 to value inclusive.
+bool isReachableBackward(struct backwardSearch *search, uint128_t value, std::vector<uint128_t> *path = nullptr);
+
+// Whether value can be reached with 3^lastPowOf3 as the last power added, for lastPowOf3 = 0 or 1
+// only, where that's decided directly. There's never more than one path to such a state.
+bool isReachableLeaf(uint128_t value, int lastPowOf3);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "math-utils.h"
+#include "backward-search.h"
+#include "batch-verifier.h"
+#include "work-queue.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Candidates per block. Small, so that results come out steadily in order.
+const uint64_t BATCH_BLOCK_SIZE = 16;
+
+const uint8_t RESULT_PENDING = 0;
+const uint8_t RESULT_REACHABLE = 1;
+const uint8_t RESULT_UNREACHABLE = 2;
+
+struct batchRun {
+	const vector<uint128_t> *candidates;
+	vector<struct workQueue> queues; // of blocks
+	vector<atomic<uint8_t>> results;
+	
+	// Signalled each time a block is finished
+	mutex resultsLock;
+	condition_variable resultsReady;
+	
+	atomic<uint64_t> statesVisited;
+	atomic<uint64_t> memoHits;
+	
+	batchRun(const vector<uint128_t> *candidates, int threads) : candidates(candidates), queues(threads), results(candidates->size()), statesVisited(0), memoHits(0) {}
+};
+
+static void runBatchWorker(struct batchRun *run, struct sharedBackwardMemo *memo, int thread) {
+	struct backwardSearchConfig config = defaultBackwardSearchConfig();
+	config.sharedMemo = memo;
+	struct backwardSearch *search = createBackwardSearch(config);
+	
+	const vector<uint128_t> &candidates = *run->candidates;
+	uint64_t block;
+	while (takeWork(run->queues, thread, &block)) {
+		uint64_t end = min((uint64_t)candidates.size(), (block + 1) * BATCH_BLOCK_SIZE);
+		for (uint64_t i = block * BATCH_BLOCK_SIZE; i < end; i++) {
+			bool reachable = isReachableBackward(search, candidates[i]);
+			run->results[i].store(reachable ? RESULT_REACHABLE : RESULT_UNREACHABLE, memory_order_release);
+		}
+		
+		lock_guard<mutex> guard(run->resultsLock);
+		run->resultsReady.notify_all();
+	}
+	
+	run->statesVisited += search->statesVisited;
+	run->memoHits += search->memoHits;
+	destroyBackwardSearch(search);
+}
+
+struct batchVerifierConfig defaultBatchVerifierConfig() {
+	struct batchVerifierConfig config;
+	config.threads = max(1u, thread::hardware_concurrency());
+	config.maxMemoEntries = 8000000; // about 400MB
+	return config;
+}
+
+struct batchVerifier *createBatchVerifier(struct batchVerifierConfig config) {
+	if (config.threads < 1) {
+		throw out_of_range("threads < 1");
+	}
+	
+	struct batchVerifier *verifier = new struct batchVerifier;
+	verifier->config = config;
+	verifier->memo = createSharedBackwardMemo(config.maxMemoEntries);
+	verifier->statesVisited = 0;
+	verifier->memoHits = 0;
+	
+	return verifier;
+}
+
+void destroyBatchVerifier(struct batchVerifier *verifier) {
+	if (verifier == nullptr) return;
+	
+	destroySharedBackwardMemo(verifier->memo);
+	delete verifier;
+}
+
+void runBatchVerifier(struct batchVerifier *verifier, const vector<uint128_t> &candidates, const struct batchVerifierCallbacks &callbacks) {
+	int threads = verifier->config.threads;
+	struct batchRun run(&candidates, threads);
+	
+	// Deal the blocks out in turn, so every thread starts near the front & results can be reported early
+	dealWork(run.queues, (candidates.size() + BATCH_BLOCK_SIZE - 1) / BATCH_BLOCK_SIZE);
+	
+	vector<thread> workers;
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back(runBatchWorker, &run, verifier->memo, i);
+	}
+	
+	// Report each result as soon as everything before it has been reported
+	for (uint64_t i = 0; i < candidates.size(); i++) {
+		uint8_t result = run.results[i].load(memory_order_acquire);
+		if (result == RESULT_PENDING) {
+			unique_lock<mutex> guard(run.resultsLock);
+			run.resultsReady.wait(guard, [&run, i]() {
+				return run.results[i].load(memory_order_acquire) != RESULT_PENDING;
+			});
+			result = run.results[i].load(memory_order_acquire);
+		}
+		
+		if (callbacks.result) {
+			callbacks.result(i, candidates[i], result == RESULT_REACHABLE);
+		}
+	}
+	
+	for (thread &worker : workers) {
+		worker.join();
+	}
+	
+	verifier->statesVisited += run.statesVisited;
+	verifier->memoHits += run.memoHits;
+}
+
+vector<uint128_t> readCandidateFile(const string &path) {
+	ifstream file(path);
+	if (!file.is_open()) {
+		throw runtime_error("Error: couldn't open '" + path + "'");
+	}
+	
+	vector<uint128_t> candidates;
+	string line;
+	for (uint64_t lineNumber = 1; getline(file, line); lineNumber++) {
+		// Trim surrounding whitespace, including the \r of \r\n line endings
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == string::npos || line[first] == '#') continue;
+		line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+		
+		uint128_t value;
+		if (!parseUInt128(line.c_str(), &value)) {
+			throw runtime_error("Error: line " + to_string(lineNumber) + " of '" + path + "' isn't a whole number below 2^128: '" + line + "'");
+		}
+		candidates.push_back(value);
+	}
+	
+	return candidates;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "backward-search.h"
+#include "math-utils.h"
+
+#ifndef BATCH_VERIFIER_H
+#define BATCH_VERIFIER_H
+
+// Decides the reachability of a whole list of candidates with isReachableBackward(), e.g. to check
+// that 2z is a zero for every known zero z. The candidates are split into small blocks dealt out
+// to a queue per thread; a thread that runs out steals from the far end of another's queue, so a
+// few slow candidates (zeros take far longer to rule out than reachable values do to find) don't
+// leave the other threads idle. All the threads share one memo, which is kept between runs.
+
+struct batchVerifierConfig {
+	int threads;
+	uint64_t maxMemoEntries; // over all threads
+};
+
+// Any of these can be left empty
+struct batchVerifierCallbacks {
+	// Called once per candidate, in input order, from the thread that called runBatchVerifier()
+	std::function<void(uint64_t index, uint128_t value, bool reachable)> result;
+};
+
+struct batchVerifier {
+	struct batchVerifierConfig config;
+	struct sharedBackwardMemo *memo;
+	
+	// Totals over every run so far
+	uint64_t statesVisited;
+	uint64_t memoHits;
+};
+
+struct batchVerifierConfig defaultBatchVerifierConfig();
+
+struct batchVerifier *createBatchVerifier(struct batchVerifierConfig config);
+void runBatchVerifier(struct batchVerifier *verifier, const std::vector<uint128_t> &candidates, const struct batchVerifierCallbacks &callbacks);
+void destroyBatchVerifier(struct batchVerifier *verifier);
+
+// One decimal value per line. Blank lines & lines starting with # are skipped. Throws
+// std::runtime_error if the file can't be read or a line isn't a value below 2^128.
+std::vector<uint128_t> readCandidateFile(const std::string &path);
+
+#endif
\ No newline at end of file
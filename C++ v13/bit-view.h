@@ -0,0 +1,35 @@
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+#include "column-kernels.h"
+
+#ifndef BIT_VIEW_H
+#define BIT_VIEW_H
+
+// Read-only view of a final reachability bitmap, in the same layout the sieve uses internally:
+// multiples of 3 are omitted, so bit i represents the value bitPosToNum(i), and an ON bit means
+// the value is reachable. The view doesn't own the memory - it's only valid while the engine
+// that produced it is alive.
+struct reachabilityBitView {
+	const uint64_t *chunks;
+	uint64_t chunkCount;
+	uint64_t maxValue; // largest value whose bit is meaningful
+};
+
+inline bool isReachable(const struct reachabilityBitView *view, uint64_t value) {
+	if (value > view->maxValue) {
+		throw std::out_of_range(
+			std::string("Error: value '")
+			+ std::to_string(value)
+			+ "' is beyond the max value stored '"
+			+ std::to_string(view->maxValue)
+			+ "'."
+		);
+	}
+	if (value % 3 == 0) return false;
+	
+	uint64_t bitPos = numToBitPos(value);
+	return (view->chunks[bitPos / CHUNK_BITS] >> (bitPos % CHUNK_BITS)) & 1;
+}
+
+#endif
\ No newline at end of file
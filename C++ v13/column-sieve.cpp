@@ -0,0 +1,285 @@
+#include "math-utils.h"
+#include "column-kernels.h"
+#include "column-sieve.h"
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+
+using namespace std;
+
+// the process is more complex for first chunk (as doubling
+// can leave you in the same chunk; in later chunks it never does)
+static void initialiseColFirstChunk(uint64_t* chunk, uint64_t firstBitValueRepresented) {
+	
+	// Note: must never shift too far (i.e. >= 64 bits), as that's undefined behaviour and e.g. may wrap around.
+	// To avoid this, just make sure that the destination to copy to is inside the first chunk.
+	
+	// For each ON bit at some position j, representing value n,
+	// in the first chunk, turn the bit representing 2*n ON.
+	for (int j = 0; true; j++) {
+		uint64_t n = bitPosToNum(j) - 1 + firstBitValueRepresented;
+		
+		uint64_t doubleN = n * 2; // number to mark as ON
+		uint64_t doubleNBit = numToBitPos(doubleN - firstBitValueRepresented + 1); // position of bit representing that number
+		
+		if (doubleNBit >= CHUNK_BITS) break;
+		
+		if ((*chunk & (1ULL << j)) != 0) {
+			*chunk |= (1ULL << doubleNBit);
+		}
+	}
+}
+
+static void reportZeros(uint64_t chunk, uint64_t bitOffset, const struct columnSieveCallbacks &callbacks) {
+	if (!callbacks.zeroFound) return;
+	
+	// Find & report the position of the OFF bits, offset by bitOffset
+	for (uint64_t i = 0; i < CHUNK_BITS; i++) {
+		if ((~chunk) & (1ULL << i)) {
+			callbacks.zeroFound(bitPosToNum(bitOffset + i));
+		}
+	}
+}
+
+struct columnSieveConfig defaultColumnSieveConfig() {
+	return columnSieveConfigForMemory(100000000L);
+}
+
+struct columnSieveConfig columnSieveConfigForMemory(uint64_t uint64sAvailable) {
+	// Use 90% of the approx. available memory, rounded down to a multiple of 2
+	// as there's 2 equal length arrays in use at any time.
+	uint64_t memToUse = uint64sAvailable * 9 / 10;
+	memToUse -= memToUse % 2;
+	
+	struct columnSieveConfig config;
+	config.colLength = memToUse / 2;
+	config.buildRankIndex = false;
+	return config;
+}
+
+struct columnSieve *createColumnSieve(struct columnSieveConfig config) {
+	if (config.colLength < 1) {
+		throw out_of_range("colLength < 1");
+	}
+	
+	struct columnSieve *sieve = new struct columnSieve;
+	sieve->config = config;
+	sieve->maxValueRepresentable = bitPosToNum(config.colLength * CHUNK_BITS - 1);
+	sieve->expRegCol = new uint64_t[config.colLength + 2](); // 2 chunks of overflow so doubling method can be branchless
+	sieve->colsAggregate = new uint64_t[config.colLength + 1](); // 1 chunk of overflow, as the bit-adjusted aggregating can spill one past the end
+	sieve->rankIndex = config.buildRankIndex ? createRankIndex(sieve->maxValueRepresentable) : nullptr;
+	sieve->finished = false;
+	
+	return sieve;
+}
+
+void destroyColumnSieve(struct columnSieve *sieve) {
+	if (sieve == nullptr) return;
+	
+	delete[] sieve->expRegCol;
+	delete[] sieve->colsAggregate;
+	destroyRankIndex(sieve->rankIndex);
+	delete sieve;
+}
+
+struct reachabilityBitView getAggregateView(const struct columnSieve *sieve) {
+	if (!sieve->finished) {
+		throw logic_error("Error: the aggregate isn't final until runColumnSieve() has returned");
+	}
+	
+	struct reachabilityBitView view;
+	view.chunks = sieve->colsAggregate;
+	view.chunkCount = sieve->config.colLength;
+	view.maxValue = sieve->maxValueRepresentable;
+	return view;
+}
+
+void runColumnSieve(struct columnSieve *sieve, const struct columnSieveCallbacks &callbacks) {
+	if (sieve->finished) {
+		throw logic_error("Error: runColumnSieve() has already been run on this sieve");
+	}
+	
+	uint64_t colLength = sieve->config.colLength;
+	uint64_t maxValueRepresentable = sieve->maxValueRepresentable;
+	uint64_t *expRegCol = sieve->expRegCol;
+	uint64_t *colsAggregate = sieve->colsAggregate;
+	struct rankIndex *rankIndex = sieve->rankIndex;
+	
+	// Setup column 0, i.e. ON at every power of 2, adjusted for missing multiples of 3. (Up to the max
+	// value, not colLength * CHUNK_BITS, which is a count of bits, so would miss the top power of 2
+	// whenever there's one between the two)
+	for (uint64_t i = 1; i <= maxValueRepresentable; i *= 2) {
+		uint64_t bitPos = numToBitPos(i);
+		expRegCol[bitPos / CHUNK_BITS] |= 1ULL << (bitPos % CHUNK_BITS);
+		
+		if (i > maxValueRepresentable / 2) break;
+	}
+	
+	// Overlay column 0 onto the aggregate
+	for (uint64_t i = 0; i < colLength; i++) {
+		colsAggregate[i] |= expRegCol[i];
+	}
+	
+	// chunks of the aggregate before this have had their zeros reported
+	uint64_t zerosReportedUpToChunk = 0;
+	
+	uint64_t firstBitValueRepresented = 1;
+	for (int powOf3 = 1; true; powOf3++) {
+		firstBitValueRepresented += threeToThe(powOf3);
+		
+		uint64_t nextRoundFirstBitValueRepresented = firstBitValueRepresented + threeToThe(powOf3 + 1);
+		uint64_t nextRoundAdjustment = numToBitPos(nextRoundFirstBitValueRepresented);
+		
+		if (firstBitValueRepresented > maxValueRepresentable) break;
+		
+		initialiseColFirstChunk(expRegCol, firstBitValueRepresented);
+		
+		uint64_t adjustment = numToBitPos(firstBitValueRepresented);
+		uint64_t chunksAdjustment = adjustment / CHUNK_BITS;
+		uint64_t bitsAdjustment = adjustment % CHUNK_BITS;
+		uint64_t bitsAdjustmentComplement = CHUNK_BITS - bitsAdjustment;
+		
+		uint64_t lastBitToAggregate = numToBitPos(maxValueRepresentable - firstBitValueRepresented + 1);
+		// bits beyond this are redundant - they don't overlap with the aggregate column
+		
+		uint64_t lastChunkToAggregate = lastBitToAggregate / CHUNK_BITS + 1; // not sure why +1 but it fixes it
+		uint64_t lastChunkToDouble = (colLength - chunksAdjustment - 1) / 2;
+		uint64_t lastChunkToCheckZeros = min((nextRoundAdjustment / CHUNK_BITS) - chunksAdjustment, lastChunkToAggregate);
+		
+		// only for when bitsAdjustment == 0
+		#define aggregateAligned() \
+			uint64_t aggChunksPos = chunk + chunksAdjustment; \
+			uint64_t* aggChunks = colsAggregate + aggChunksPos; \
+			aggChunks[0] |= expRegCol[chunk];
+		
+		// only for when bitsAdjustment is between 1 and 63 both inclusive
+		#define aggregateBitAdjusted() \
+			uint64_t aggChunksPos = chunk + chunksAdjustment; \
+			uint64_t* aggChunks = colsAggregate + aggChunksPos; \
+			aggChunks[0] |= expRegCol[chunk] << bitsAdjustment; \
+			aggChunks[1] |= expRegCol[chunk] >> bitsAdjustmentComplement;
+		
+		// Tests if any bits are OFF. If so, then finds them & reports the numbers they represent.
+		// Each aggregate chunk is only ever checked by one column, and the columns check them in
+		// increasing order, so the zeros come out in order too. That's also when the chunk is
+		// final, so it's added to the rank index then.
+		#define checkForZeros() { \
+			if (~aggChunks[0] != 0) { \
+				reportZeros(aggChunks[0], aggChunksPos * 64, callbacks); \
+			} \
+			if (rankIndex != nullptr) { \
+				addRankIndexChunk(rankIndex, aggChunks[0]); \
+			} \
+			zerosReportedUpToChunk = aggChunksPos + 1; \
+		}
+		
+		#define reportProgress() { \
+			if ((chunk & 0xFFFF) == 0 && callbacks.progress) { \
+				callbacks.progress(powOf3, chunk); \
+			} \
+		}
+		
+		uint64_t chunk = 0;
+		uint64_t firstLimit = min(lastChunkToDouble, lastChunkToCheckZeros);
+		if (bitsAdjustment == 0) {
+			for (; chunk < firstLimit; chunk++) {
+				copyAlongToDoubleCurrentPos_macro(expRegCol, chunk, chunksAdjustment);
+				aggregateAligned();
+				checkForZeros();
+				reportProgress();
+			}
+		} else {
+			for (; chunk < firstLimit; chunk++) {
+				copyAlongToDoubleCurrentPos_macroBitAdjusted(expRegCol, chunk, chunksAdjustment, bitsAdjustment, bitsAdjustmentComplement);
+				aggregateBitAdjusted();
+				checkForZeros();
+				reportProgress();
+			}
+		}
+		// Now we're either done doubling, or done checking for zeros
+		
+		// If we're done doubling, continue along until we'e done checking for zeros
+		// Note that lastChunkToCheckZeros <= lastChunkToAggregate so aggregate() is always necessary (& won't go out of range)
+		if (bitsAdjustment == 0) {
+			for (; chunk < lastChunkToCheckZeros; chunk++) {
+				aggregateAligned();
+				checkForZeros();
+				reportProgress();
+			}
+		} else {
+			for (; chunk < lastChunkToCheckZeros; chunk++) {
+				aggregateBitAdjusted();
+				checkForZeros();
+				reportProgress();
+			}
+		}
+		// Now we're definitely done checking for zeros (and might also be done doubling)
+		
+		// Continue until we're either done doubling, or done aggregating
+		uint64_t secondLimit = min(lastChunkToDouble, lastChunkToAggregate);
+		if (bitsAdjustment == 0) {
+			for (; chunk < secondLimit; chunk++) {
+				copyAlongToDoubleCurrentPos_macro(expRegCol, chunk, chunksAdjustment);
+				aggregateAligned();
+				reportProgress();
+			}
+		} else {
+			for (; chunk < secondLimit; chunk++) {
+				copyAlongToDoubleCurrentPos_macroBitAdjusted(expRegCol, chunk, chunksAdjustment, bitsAdjustment, bitsAdjustmentComplement);
+				aggregateBitAdjusted();
+				reportProgress();
+			}
+		}
+		
+		// If we're done aggregating, continue along with the rest of the doubling
+		if (bitsAdjustment == 0) {
+			for (; chunk < lastChunkToDouble; chunk++) {
+				copyAlongToDoubleCurrentPos_macro(expRegCol, chunk, chunksAdjustment);
+				reportProgress();
+			}
+		} else {
+			for (; chunk < lastChunkToDouble; chunk++) {
+				copyAlongToDoubleCurrentPos_macroBitAdjusted(expRegCol, chunk, chunksAdjustment, bitsAdjustment, bitsAdjustmentComplement);
+				reportProgress();
+			}
+		}
+		
+		// Otherwise, if we're done doubling, continue along with the rest of the aggregating
+		if (bitsAdjustment == 0) {
+			for (; chunk < lastChunkToAggregate; chunk++) {
+				aggregateAligned();
+				reportProgress();
+			}
+		} else {
+			for (; chunk < lastChunkToAggregate; chunk++) {
+				aggregateBitAdjusted();
+				reportProgress();
+			}
+		}
+		
+		#undef aggregateAligned
+		#undef aggregateBitAdjusted
+		#undef checkForZeros
+		#undef reportProgress
+		
+		if (callbacks.columnFinished) {
+			callbacks.columnFinished(powOf3, firstBitValueRepresented);
+		}
+	}
+	
+	// Go through the rest of the columns aggregate, checking for any chunks with any zero bits
+	for (uint64_t chunk = zerosReportedUpToChunk; chunk < colLength; chunk++) {
+		if (~colsAggregate[chunk] != 0) { // If any bits OFF
+			reportZeros(colsAggregate[chunk], chunk * 64, callbacks);
+		}
+		if (rankIndex != nullptr) {
+			addRankIndexChunk(rankIndex, colsAggregate[chunk]);
+		}
+	}
+	
+	if (rankIndex != nullptr) {
+		finishRankIndex(rankIndex);
+	}
+	sieve->finished = true;
+}
\ No newline at end of file
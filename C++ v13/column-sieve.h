@@ -0,0 +1,55 @@
+#include <stdint.h>
+#include <functional>
+#include "bit-view.h"
+#include "rank-index.h"
+
+#ifndef COLUMN_SIEVE_H
+#define COLUMN_SIEVE_H
+
+// The v12 single-column engine, as a library. All state lives in struct columnSieve, so several
+// can be run at once (e.g. from different threads), and results are passed back through
+// callbacks rather than printed.
+
+struct columnSieveConfig {
+	uint64_t colLength; // measured in CHUNK_BITS-long chunks. Memory used is about 2 * colLength * 8 bytes.
+	
+	// Build a rank index (see rank-index.h) of the aggregate as its chunks become final, adding about
+	// 3% to the memory used
+	bool buildRankIndex;
+};
+
+// Any of these can be left empty
+struct columnSieveCallbacks {
+	// Called once for each non-trivial zero, in increasing order, as soon as it's certain
+	// (usually while the column that finalises it is being computed, otherwise in the final sweep)
+	std::function<void(uint64_t value)> zeroFound;
+	
+	// Called after the column for shift of 3^powOf3 has been doubled & merged into the aggregate
+	std::function<void(int powOf3, uint64_t firstValueRepresented)> columnFinished;
+	
+	// Called every 65536 chunks while a column is being computed
+	std::function<void(int powOf3, uint64_t chunk)> progress;
+};
+
+struct columnSieve {
+	struct columnSieveConfig config;
+	uint64_t maxValueRepresentable;
+	uint64_t *expRegCol;
+	uint64_t *colsAggregate;
+	struct rankIndex *rankIndex; // nullptr unless config.buildRankIndex
+	bool finished;
+};
+
+struct columnSieveConfig defaultColumnSieveConfig();
+
+// Same split as v12: use 90% of the given number of uint64_t's, shared between the column and the aggregate
+struct columnSieveConfig columnSieveConfigForMemory(uint64_t uint64sAvailable);
+
+struct columnSieve *createColumnSieve(struct columnSieveConfig config);
+void runColumnSieve(struct columnSieve *sieve, const struct columnSieveCallbacks &callbacks);
+void destroyColumnSieve(struct columnSieve *sieve);
+
+// Only valid after runColumnSieve() has returned, and until destroyColumnSieve()
+struct reachabilityBitView getAggregateView(const struct columnSieve *sieve);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "column-kernels.h"
+#include "column-store.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const uint64_t DEFAULT_STORE_CHUNKS_PER_BLOCK = 4096;
+
+// Columns 3^0 to 3^39, as writeStoreColumn() only takes powers below 40
+const uint64_t MAX_STORE_COLUMNS = 40;
+
+// The most a marker word can hold
+const uint64_t MAX_CLEAN_RUN = (1ULL << 32) - 1;
+const uint64_t MAX_LITERAL_RUN = (1ULL << 31) - 1;
+
+static bool isClean(uint64_t chunk) {
+	return chunk == 0 || chunk == ~0ULL;
+}
+
+static void encodeBlock(const uint64_t *chunks, uint64_t count, vector<uint64_t> &coded) {
+	coded.clear();
+	
+	uint64_t i = 0;
+	while (i < count) {
+		uint64_t runBit = chunks[i] == ~0ULL ? 1 : 0;
+		uint64_t cleanChunk = runBit ? ~0ULL : 0;
+		
+		uint64_t runLength = 0;
+		while (i < count && chunks[i] == cleanChunk && runLength < MAX_CLEAN_RUN) {
+			i++;
+			runLength++;
+		}
+		
+		uint64_t firstLiteral = i;
+		while (i < count && !isClean(chunks[i]) && i - firstLiteral < MAX_LITERAL_RUN) {
+			i++;
+		}
+		
+		coded.push_back(runBit | (runLength << 1) | ((i - firstLiteral) << 33));
+		coded.insert(coded.end(), chunks + firstLiteral, chunks + i);
+	}
+}
+
+static void decodeBlock(const uint64_t *coded, uint64_t codedWords, uint64_t *chunks, uint64_t count) {
+	uint64_t filled = 0;
+	uint64_t word = 0;
+	while (word < codedWords) {
+		uint64_t marker = coded[word++];
+		uint64_t runLength = (marker >> 1) & MAX_CLEAN_RUN;
+		uint64_t literals = marker >> 33;
+		if (filled + runLength + literals > count || word + literals > codedWords) {
+			throw runtime_error("Error: a block in the column store is corrupt (runs past its end)");
+		}
+		
+		fill(chunks + filled, chunks + filled + runLength, (marker & 1) ? ~0ULL : 0);
+		filled += runLength;
+		
+		memcpy(chunks + filled, coded + word, literals * sizeof(uint64_t));
+		filled += literals;
+		word += literals;
+	}
+	
+	if (filled != count) {
+		throw runtime_error("Error: a block in the column store is corrupt (too short)");
+	}
+}
+
+struct columnStoreConfig defaultColumnStoreConfig(const string &path) {
+	struct columnStoreConfig config;
+	config.path = path;
+	config.chunksPerBlock = DEFAULT_STORE_CHUNKS_PER_BLOCK;
+	return config;
+}
+
+struct columnStoreWriter *createColumnStoreWriter(struct columnStoreConfig config, uint64_t chunkCount, uint64_t maxValue) {
+	if (config.chunksPerBlock < 1) {
+		throw out_of_range("chunksPerBlock < 1");
+	}
+	if (chunkCount < 1) {
+		throw out_of_range("chunkCount < 1");
+	}
+	
+	struct columnStoreWriter *writer = new struct columnStoreWriter;
+	writer->config = config;
+	
+	writer->file.open(config.path, ios::binary | ios::trunc);
+	if (!writer->file.is_open()) {
+		delete writer;
+		throw runtime_error("Error: couldn't open '" + config.path + "' to write the column store to");
+	}
+	
+	memcpy(writer->header.magic, COLUMN_STORE_MAGIC, sizeof(COLUMN_STORE_MAGIC));
+	writer->header.chunkCount = chunkCount;
+	writer->header.maxValue = maxValue;
+	writer->header.chunksPerBlock = config.chunksPerBlock;
+	writer->header.columnCount = 0;
+	writer->header.indexOffset = 0;
+	writer->blockCount = (chunkCount + config.chunksPerBlock - 1) / config.chunksPerBlock;
+	
+	// rewritten with the index's position once it's known
+	writer->file.write((const char *)&writer->header, sizeof(writer->header));
+	
+	writer->block.resize(config.chunksPerBlock);
+	writer->finished = false;
+	
+	return writer;
+}
+
+// Codes and writes every block of a column, where bit i of chunks is bit i + bitOffset of the column
+static void writeBlocks(struct columnStoreWriter *writer, const uint64_t *chunks, uint64_t bitOffset, vector<struct columnStoreBlock> &blocks) {
+	uint64_t chunkCount = writer->header.chunkCount;
+	uint64_t chunksPerBlock = writer->config.chunksPerBlock;
+	uint64_t chunksOffset = bitOffset / CHUNK_BITS;
+	int bitsOffset = bitOffset % CHUNK_BITS;
+	
+	for (uint64_t blockNum = 0; blockNum < writer->blockCount; blockNum++) {
+		uint64_t first = blockNum * chunksPerBlock;
+		uint64_t count = min(chunksPerBlock, chunkCount - first);
+		
+		for (uint64_t i = 0; i < count; i++) {
+			uint64_t chunk = first + i;
+			if (chunk < chunksOffset) {
+				writer->block[i] = 0;
+				continue;
+			}
+			
+			uint64_t source = chunk - chunksOffset;
+			writer->block[i] = chunks[source] << bitsOffset;
+			if (bitsOffset != 0 && source > 0) {
+				writer->block[i] |= chunks[source - 1] >> (CHUNK_BITS - bitsOffset);
+			}
+		}
+		
+		encodeBlock(writer->block.data(), count, writer->coded);
+		
+		struct columnStoreBlock block;
+		block.offset = writer->file.tellp();
+		block.words = writer->coded.size();
+		blocks.push_back(block);
+		
+		writer->file.write((const char *)writer->coded.data(), writer->coded.size() * sizeof(uint64_t));
+	}
+	
+	if (!writer->file.good()) {
+		throw runtime_error("Error: couldn't write to '" + writer->config.path + "'");
+	}
+}
+
+void writeStoreColumn(struct columnStoreWriter *writer, int powOf3, const uint64_t *chunks, uint64_t bitOffset) {
+	if (powOf3 < 0 || (uint64_t)powOf3 >= MAX_STORE_COLUMNS) {
+		throw out_of_range("powOf3 < 0 or >= 40");
+	}
+	if (writer->finished) {
+		throw logic_error("Error: the column store has already been finished");
+	}
+	
+	if (writer->columnBlocks.size() <= (size_t)powOf3) {
+		writer->columnBlocks.resize(powOf3 + 1);
+	}
+	if (!writer->columnBlocks[powOf3].empty()) {
+		throw logic_error("Error: column 3^" + to_string(powOf3) + " has already been written to the column store");
+	}
+	
+	writeBlocks(writer, chunks, bitOffset, writer->columnBlocks[powOf3]);
+}
+
+void writeStoreAggregate(struct columnStoreWriter *writer, const uint64_t *chunks) {
+	if (writer->finished) {
+		throw logic_error("Error: the column store has already been finished");
+	}
+	if (!writer->aggregateBlocks.empty()) {
+		throw logic_error("Error: the aggregate has already been written to the column store");
+	}
+	
+	writeBlocks(writer, chunks, 0, writer->aggregateBlocks);
+}
+
+void finishColumnStore(struct columnStoreWriter *writer) {
+	if (writer->finished) {
+		throw logic_error("Error: the column store has already been finished");
+	}
+	
+	for (size_t powOf3 = 0; powOf3 < writer->columnBlocks.size(); powOf3++) {
+		if (writer->columnBlocks[powOf3].empty()) {
+			throw logic_error("Error: column 3^" + to_string(powOf3) + " was never written to the column store");
+		}
+	}
+	if (writer->aggregateBlocks.empty()) {
+		throw logic_error("Error: the aggregate was never written to the column store");
+	}
+	
+	writer->header.columnCount = writer->columnBlocks.size();
+	writer->header.indexOffset = writer->file.tellp();
+	
+	for (const vector<struct columnStoreBlock> &blocks : writer->columnBlocks) {
+		writer->file.write((const char *)blocks.data(), blocks.size() * sizeof(struct columnStoreBlock));
+	}
+	writer->file.write((const char *)writer->aggregateBlocks.data(), writer->aggregateBlocks.size() * sizeof(struct columnStoreBlock));
+	
+	writer->file.seekp(0);
+	writer->file.write((const char *)&writer->header, sizeof(writer->header));
+	writer->file.flush();
+	
+	if (!writer->file.good()) {
+		throw runtime_error("Error: couldn't write to '" + writer->config.path + "'");
+	}
+	writer->finished = true;
+}
+
+void destroyColumnStoreWriter(struct columnStoreWriter *writer) {
+	delete writer;
+}
+
+struct columnStoreReader *openColumnStore(const string &path) {
+	struct columnStoreReader *reader = new struct columnStoreReader;
+	
+	reader->file.open(path, ios::binary);
+	if (!reader->file.is_open()) {
+		delete reader;
+		throw runtime_error("Error: couldn't open '" + path + "'");
+	}
+	
+	reader->file.read((char *)&reader->header, sizeof(reader->header));
+	if (!reader->file.good() || memcmp(reader->header.magic, COLUMN_STORE_MAGIC, sizeof(COLUMN_STORE_MAGIC)) != 0) {
+		delete reader;
+		throw runtime_error("Error: '" + path + "' isn't a column store");
+	}
+	if (reader->header.chunksPerBlock < 1 || reader->header.columnCount > MAX_STORE_COLUMNS) {
+		delete reader;
+		throw runtime_error("Error: the header of the column store '" + path + "' is corrupt");
+	}
+	
+	uint64_t chunksPerBlock = reader->header.chunksPerBlock;
+	reader->blockCount = (reader->header.chunkCount + chunksPerBlock - 1) / chunksPerBlock;
+	
+	reader->index.resize((reader->header.columnCount + 1) * reader->blockCount);
+	reader->file.seekg(reader->header.indexOffset);
+	reader->file.read((char *)reader->index.data(), reader->index.size() * sizeof(struct columnStoreBlock));
+	if (!reader->file.good()) {
+		delete reader;
+		throw runtime_error("Error: couldn't read the index of '" + path + "' (was it finished?)");
+	}
+	
+	reader->block.resize(chunksPerBlock);
+	return reader;
+}
+
+void closeColumnStore(struct columnStoreReader *reader) {
+	delete reader;
+}
+
+uint64_t getStoreBlockHolding(const struct columnStoreReader *reader, uint64_t value) {
+	return numToBitPos(value) / CHUNK_BITS / reader->header.chunksPerBlock;
+}
+
+uint64_t readStoreBlock(struct columnStoreReader *reader, int powOf3, uint64_t blockNum, uint64_t *chunks) {
+	uint64_t columnCount = reader->header.columnCount;
+	if (powOf3 != STORE_AGGREGATE && (powOf3 < 0 || (uint64_t)powOf3 >= columnCount)) {
+		throw out_of_range("Error: the column store only has columns 3^0 to 3^" + to_string(columnCount - 1));
+	}
+	if (blockNum >= reader->blockCount) {
+		throw out_of_range("Error: the column store only has " + to_string(reader->blockCount) + " blocks per column");
+	}
+	
+	uint64_t column = powOf3 == STORE_AGGREGATE ? columnCount : powOf3;
+	const struct columnStoreBlock &block = reader->index[column * reader->blockCount + blockNum];
+	
+	reader->coded.resize(block.words);
+	reader->file.seekg(block.offset);
+	reader->file.read((char *)reader->coded.data(), block.words * sizeof(uint64_t));
+	if (!reader->file.good()) {
+		throw runtime_error("Error: couldn't read a block of the column store");
+	}
+	
+	uint64_t chunksPerBlock = reader->header.chunksPerBlock;
+	uint64_t count = min(chunksPerBlock, reader->header.chunkCount - blockNum * chunksPerBlock);
+	decodeBlock(reader->coded.data(), block.words, chunks, count);
+	return count;
+}
+
+bool isSetInStore(struct columnStoreReader *reader, int powOf3, uint64_t value) {
+	if (value > reader->header.maxValue) {
+		throw out_of_range(
+			string("Error: value '")
+			+ to_string(value)
+			+ "' is beyond the max value stored '"
+			+ to_string(reader->header.maxValue)
+			+ "'."
+		);
+	}
+	if (value % 3 == 0) return false;
+	
+	readStoreBlock(reader, powOf3, getStoreBlockHolding(reader, value), reader->block.data());
+	
+	uint64_t chunk = numToBitPos(value) / CHUNK_BITS % reader->header.chunksPerBlock;
+	return (reader->block[chunk] >> (numToBitPos(value) % CHUNK_BITS)) & 1;
+}
\ No newline at end of file
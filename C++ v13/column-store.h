@@ -0,0 +1,104 @@
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+// A file holding every column of a column sieve run, plus the aggregate, so that analysis can come
+// back to any part of one expensive run rather than redoing it.
+//
+// Everything is in the sieve's layout (multiples of 3 omitted, bit numToBitPos(value)), with each
+// column moved to where it lands in the aggregate, so block b of every column covers the same
+// values. Each column is cut into blocks of chunksPerBlock chunks, and each block is coded on its
+// own, so any (column, block) can be read back without decoding anything else. The file is:
+//  - a columnStoreHeader
+//  - the coded blocks, one column after another, in the order they were written
+//  - the index: a columnStoreBlock for each block of column 0, then column 1, ..., then the aggregate
+//
+// Blocks are word-aligned run-length coded (EWAH): a marker word, whose bit 0 is the value of a run
+// of "clean" chunks (all 0s or all 1s), bits 1 to 32 how many there are, and bits 33 to 63 how many
+// literal chunks follow it, stored as they are. A column is almost all 0s outside the values its
+// power can end, and the aggregate almost all 1s, so those come down to a word or two per block.
+
+const char COLUMN_STORE_MAGIC[8] = { 'T', 'T', 'D', 'C', 'O', 'L', 'S', '1' };
+
+// Column number for the aggregate
+const int STORE_AGGREGATE = -1;
+
+struct columnStoreHeader {
+	char magic[8];
+	uint64_t chunkCount; // chunks in every column
+	uint64_t maxValue;
+	uint64_t chunksPerBlock;
+	uint64_t columnCount; // powers of 3 from 3^0, not counting the aggregate
+	uint64_t indexOffset;
+};
+
+struct columnStoreBlock {
+	uint64_t offset; // in bytes, from the start of the file
+	uint64_t words; // coded length
+};
+
+struct columnStoreConfig {
+	std::string path;
+	uint64_t chunksPerBlock;
+};
+
+struct columnStoreWriter {
+	struct columnStoreConfig config;
+	std::ofstream file;
+	struct columnStoreHeader header;
+	uint64_t blockCount;
+	
+	// Blocks of each column written so far, by power of 3. Empty for columns not written yet.
+	std::vector<std::vector<struct columnStoreBlock>> columnBlocks;
+	std::vector<struct columnStoreBlock> aggregateBlocks;
+	
+	std::vector<uint64_t> block; // the block being coded, and its coded form
+	std::vector<uint64_t> coded;
+	bool finished;
+};
+
+struct columnStoreReader {
+	std::ifstream file;
+	struct columnStoreHeader header;
+	uint64_t blockCount;
+	std::vector<struct columnStoreBlock> index;
+	std::vector<uint64_t> block; // for isSetInStore()
+	std::vector<uint64_t> coded;
+};
+
+// 4096 chunks, so about 390,000 values per block
+struct columnStoreConfig defaultColumnStoreConfig(const std::string &path);
+
+// Throws std::runtime_error if the file can't be opened
+struct columnStoreWriter *createColumnStoreWriter(struct columnStoreConfig config, uint64_t chunkCount, uint64_t maxValue);
+
+// Writes column powOf3, where bit i of chunks belongs at bit i + bitOffset of the aggregate (bits
+// beyond chunkCount chunks are dropped). chunks must have at least chunkCount chunks. Columns can
+// be written in any order, but every power from 0 up to the highest has to be written once.
+void writeStoreColumn(struct columnStoreWriter *writer, int powOf3, const uint64_t *chunks, uint64_t bitOffset);
+void writeStoreAggregate(struct columnStoreWriter *writer, const uint64_t *chunks);
+
+// Writes the index and header. Throws std::logic_error if a column or the aggregate is missing.
+void finishColumnStore(struct columnStoreWriter *writer);
+void destroyColumnStoreWriter(struct columnStoreWriter *writer);
+
+// Reads just the header and index. Throws std::runtime_error if the file can't be read, isn't a
+// column store, or its header is corrupt.
+struct columnStoreReader *openColumnStore(const std::string &path);
+void closeColumnStore(struct columnStoreReader *reader);
+
+uint64_t getStoreBlockHolding(const struct columnStoreReader *reader, uint64_t value);
+
+// Decodes block blockNum of column powOf3 (or STORE_AGGREGATE) into chunks, which needs room for
+// chunksPerBlock chunks, and returns how many it holds (only the last block can be short).
+// Throws std::out_of_range for a column or block that isn't in the file.
+uint64_t readStoreBlock(struct columnStoreReader *reader, int powOf3, uint64_t blockNum, uint64_t *chunks);
+
+// Whether value's bit is ON in column powOf3 (or the aggregate), decoding just the block holding it
+bool isSetInStore(struct columnStoreReader *reader, int powOf3, uint64_t value);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,272 @@
+// C# version has more comments & explanation; this is just the same thing with some further optimisations
+
+#include "math-utils.h"
+#include "column-kernels.h"
+#include "two-three-decision-tracker.h"
+#include "decision-tree-search.h"
+#include "visited-store.h"
+#include "work-queue.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct treeSearch *createTreeSearch(struct treeSearchConfig config) {
+	if (config.max < 1) {
+		throw out_of_range("max < 1");
+	}
+	if (config.threads < 1) {
+		throw out_of_range("threads < 1");
+	}
+	
+	struct treeSearch *search = new struct treeSearch;
+	search->config = config;
+	search->visited = createVisitedStore(config.max);
+	search->finished = false;
+	
+	return search;
+}
+
+void destroyTreeSearch(struct treeSearch *search) {
+	if (search == nullptr) return;
+	
+	destroyVisitedStore(search->visited);
+	delete search;
+}
+
+struct reachabilityBitView getTreeSearchView(const struct treeSearch *search) {
+	if (!search->finished) {
+		throw logic_error("Error: the search result isn't final until runTreeSearch() has returned");
+	}
+	
+	struct reachabilityBitView view;
+	view.chunks = search->visited->planes[0];
+	view.chunkCount = search->visited->wordCount;
+	view.maxValue = search->config.max;
+	return view;
+}
+
+// Walks everything below where the tracker is (just after adding 3^(rootCount - 1)), leaving it back there
+template <bool SHARED>
+static void searchSubtree(struct decisionTracker *tracker, struct visitedStore *visited, int rootCount, const struct treeSearchCallbacks &callbacks) {
+	#define hasVisitedCurrent() hasVisited<SHARED>(visited, tracker->current, lastAddedThreeExponent(tracker))
+	
+	doubleRepeatedlyUpToMax(tracker);
+	while (tryAddNextPowerOf3(tracker)) { }
+	
+	markVisited<SHARED>(visited, tracker->current, lastAddedThreeExponent(tracker));
+	
+	while (!trackerAtSubtreeRoot(tracker, rootCount)) {
+		if (backtrackAndCheckIfWasDoublingOp(tracker)) {
+			if (tracker->count == 1 && callbacks.progress) {
+				callbacks.progress(tracker->doublingsSinceLastPowerOfThree[0]);
+			}
+			
+			// Whatever happens next, the state after adding the next power is checked soon
+			prefetchVisited(visited, tracker->current + threeToThe(tracker->count), tracker->count);
+			
+			if (hasVisitedCurrent()) continue;
+			
+			if (tryAddNextPowerOf3(tracker)) {
+				if (hasVisitedCurrent()) continue;
+				
+				doubleRepeatedlyUpToMax(tracker);
+				
+				if (hasVisitedCurrent()) continue;
+				
+				while (tryAddNextPowerOf3(tracker)) {
+					if (hasVisitedCurrent()) continue;
+				}
+				
+				markVisited<SHARED>(visited, tracker->current, lastAddedThreeExponent(tracker));
+			}
+			else
+			{
+				markVisited<SHARED>(visited, tracker->current, lastAddedThreeExponent(tracker));
+				continue;
+			}
+		}
+		else
+		{
+			markVisited<SHARED>(visited, tracker->current, lastAddedThreeExponent(tracker));
+		}
+	}
+	
+	#undef hasVisitedCurrent
+}
+
+// Subtrees per thread, so threads that get small ones aren't left idle at the end
+const uint64_t SUBTREES_PER_THREAD = 32;
+
+struct subtreeSplit {
+	int depth; // powers of 3 in each prefix
+	std::vector<int> prefixes; // depth doublings counts per subtree, one after another
+};
+
+// Collects the prefix of every subtree starting just after 3^depth is added, below where the
+// tracker is, and marks every state on the way (all with a smaller power, so no subtree walk ever
+// checks them, and they can be marked before what's below them is explored).
+static void splitTree(struct decisionTracker *tracker, struct visitedStore *visited, int depth, set<uint64_t> &roots, struct subtreeSplit *split) {
+	if (lastAddedThreeExponent(tracker) == depth) {
+		// Different prefixes can give the same value, and there's no point walking that twice
+		if (roots.insert(tracker->current).second) {
+			split->prefixes.insert(split->prefixes.end(), tracker->doublingsSinceLastPowerOfThree, tracker->doublingsSinceLastPowerOfThree + depth);
+		}
+		return;
+	}
+	
+	while (true) {
+		markVisited<false>(visited, tracker->current, lastAddedThreeExponent(tracker));
+		
+		if (tryAddNextPowerOf3(tracker)) {
+			splitTree(tracker, visited, depth, roots, split);
+			backtrackAndCheckIfWasDoublingOp(tracker);
+		}
+		
+		if (getNumDoublingsBeforeExceedingMax(tracker) == 0) break;
+		doubleNTimes(tracker, 1);
+	}
+	
+	while (tracker->doublingsSinceLastPowerOfThree[tracker->count - 1] > 0) {
+		halve(tracker);
+	}
+}
+
+// As deep as it takes to get enough subtrees to go round (or every state, for a small max)
+static struct subtreeSplit splitTreeForThreads(struct treeSearch *search, struct decisionTracker *tracker) {
+	uint64_t wanted = search->config.threads * SUBTREES_PER_THREAD;
+	
+	struct subtreeSplit split;
+	for (int depth = 1; ; depth++) {
+		split.depth = depth;
+		split.prefixes.clear();
+		
+		set<uint64_t> roots;
+		splitTree(tracker, search->visited, depth, roots, &split);
+		
+		uint64_t subtrees = split.prefixes.size() / depth;
+		if (subtrees >= wanted || subtrees == 0 || depth + 1 >= tracker->capacity) break;
+	}
+	
+	return split;
+}
+
+static void moveTrackerToSubtree(struct decisionTracker *tracker, const int *prefix, int depth) {
+	fill(tracker->doublingsSinceLastPowerOfThree, tracker->doublingsSinceLastPowerOfThree + tracker->capacity, 0);
+	tracker->count = 1;
+	tracker->current = 1;
+	
+	for (int i = 0; i < depth; i++) {
+		doubleNTimes(tracker, prefix[i]);
+		tryAddNextPowerOf3(tracker);
+	}
+}
+
+struct parallelTreeSearch {
+	struct treeSearch *search;
+	const struct subtreeSplit *split;
+	vector<struct workQueue> queues; // of subtrees
+	
+	// Signalled each time a subtree is finished
+	mutex progressLock;
+	condition_variable progressMade;
+	atomic<uint64_t> subtreesFinished;
+	
+	parallelTreeSearch(struct treeSearch *search, const struct subtreeSplit *split) : search(search), split(split), queues(search->config.threads), subtreesFinished(0) {}
+};
+
+static void runTreeSearchWorker(struct parallelTreeSearch *run, int thread) {
+	struct decisionTracker tracker;
+	initDecisionTracker(&tracker, run->search->config.max);
+	
+	int depth = run->split->depth;
+	struct treeSearchCallbacks noCallbacks;
+	uint64_t subtree;
+	while (takeWork(run->queues, thread, &subtree)) {
+		moveTrackerToSubtree(&tracker, &run->split->prefixes[subtree * depth], depth);
+		searchSubtree<true>(&tracker, run->search->visited, depth + 1, noCallbacks);
+		
+		run->subtreesFinished++;
+		lock_guard<mutex> guard(run->progressLock);
+		run->progressMade.notify_all();
+	}
+	
+	destructDecisionTracker(&tracker);
+}
+
+static void runTreeSearchInParallel(struct treeSearch *search, const struct treeSearchCallbacks &callbacks) {
+	struct decisionTracker tracker;
+	initDecisionTracker(&tracker, search->config.max);
+	struct subtreeSplit split = splitTreeForThreads(search, &tracker);
+	destructDecisionTracker(&tracker);
+	
+	int threads = search->config.threads;
+	uint64_t subtrees = split.prefixes.size() / split.depth;
+	struct parallelTreeSearch run(search, &split);
+	
+	// Prefixes come out in order of doublings before 3^1, so dealing them in turn gives every thread a mix
+	dealWork(run.queues, subtrees);
+	
+	vector<thread> workers;
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back(runTreeSearchWorker, &run, i);
+	}
+	
+	for (uint64_t reported = 0; reported < subtrees; ) {
+		unique_lock<mutex> guard(run.progressLock);
+		run.progressMade.wait(guard, [&run, reported]() {
+			return run.subtreesFinished.load() > reported;
+		});
+		reported = run.subtreesFinished.load();
+		guard.unlock();
+		
+		if (callbacks.progress) {
+			callbacks.progress((int)(subtrees - reported));
+		}
+	}
+	
+	for (thread &worker : workers) {
+		worker.join();
+	}
+}
+
+void runTreeSearch(struct treeSearch *search, const struct treeSearchCallbacks &callbacks) {
+	if (search->finished) {
+		throw logic_error("Error: runTreeSearch() has already been run on this search");
+	}
+	
+	if (search->config.threads > 1) {
+		runTreeSearchInParallel(search, callbacks);
+	} else {
+		struct decisionTracker tracker;
+		initDecisionTracker(&tracker, search->config.max);
+		searchSubtree<false>(&tracker, search->visited, 1, callbacks);
+		destructDecisionTracker(&tracker);
+	}
+	
+	mergeVisitedPlanes(search->visited);
+	search->finished = true;
+	
+	if (callbacks.zeroFound) {
+		struct reachabilityBitView view = getTreeSearchView(search);
+		for (uint64_t chunk = 0; chunk < view.chunkCount; chunk++) {
+			if (~view.chunks[chunk] == 0) continue;
+			
+			for (uint64_t i = 0; i < CHUNK_BITS; i++) {
+				uint64_t value = bitPosToNum(chunk * CHUNK_BITS + i);
+				if (value > view.maxValue) break;
+				
+				if ((~view.chunks[chunk]) & (1ULL << i)) {
+					callbacks.zeroFound(value);
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
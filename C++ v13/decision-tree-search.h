@@ -0,0 +1,53 @@
+#include <stdint.h>
+#include <functional>
+#include "bit-view.h"
+#include "visited-store.h"
+
+#ifndef DECISION_TREE_SEARCH_H
+#define DECISION_TREE_SEARCH_H
+
+// The depth-first search engine (C++/ and v3), as a library. Walks the whole tree of
+// double / add-next-power-of-3 decisions up to a maximum, skipping branches that have
+// already been explored from the same (value, last added power of 3).
+//
+// With more than one thread, the tree is split a few powers of 3 deep into subtrees, one per
+// prefix of doublings before each power of 3 (e.g. (5, 2) = double 5 times, add 3, double
+// twice, add 9). These are dealt out to a queue per thread, and a thread that runs out steals from
+// the far end of another's. Every thread has its own tracker, but they all mark the same expansion
+// register (with an atomic OR), so a branch explored by one thread is skipped by the rest. A state
+// is only marked once everything below it has been explored, so skipping it is always safe.
+
+struct treeSearchConfig {
+	uint64_t max;
+	int threads; // 1 runs the original single-threaded walk
+};
+
+// Any of these can be left empty
+struct treeSearchCallbacks {
+	// Called once for each non-trivial zero, in increasing order, after the search has finished
+	std::function<void(uint64_t value)> zeroFound;
+	
+	// Called each time the search backtracks to a new number of doublings before the first
+	// power of 3, i.e. the top level of the tree. This counts down to 0, when the search ends.
+	// With more than one thread, it's the number of subtrees left instead, called from the thread
+	// that called runTreeSearch() each time one finishes.
+	std::function<void(int doublingsBeforeFirstPowerOf3)> progress;
+};
+
+struct treeSearch {
+	struct treeSearchConfig config;
+	
+	// While searching, a bit plane per power of 3 (see visited-store.h). Afterwards, merged into
+	// plane 0: one bit per value, in the same layout as the column sieve's aggregate.
+	struct visitedStore *visited;
+	bool finished;
+};
+
+struct treeSearch *createTreeSearch(struct treeSearchConfig config);
+void runTreeSearch(struct treeSearch *search, const struct treeSearchCallbacks &callbacks);
+void destroyTreeSearch(struct treeSearch *search);
+
+// Only valid after runTreeSearch() has returned, and until destroyTreeSearch()
+struct reachabilityBitView getTreeSearchView(const struct treeSearch *search);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "increasing-multiplier.h"
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const uint64_t MAX_INCREASING_MULTIPLIER_VALUE = 1ULL << 62;
+
+struct valuePaths {
+	uint64_t value;
+	uint64_t paths;
+};
+
+typedef vector<struct valuePaths> stateColumn;
+
+const uint64_t COMPACT_MIN_STATES = 1 << 20;
+
+// Merges two sorted columns into out, adding the path counts of values in both
+static void mergeColumns(const stateColumn &a, const stateColumn &b, stateColumn &out) {
+	out.clear();
+	out.reserve(a.size() + b.size());
+	uint64_t i = 0;
+	uint64_t j = 0;
+	while (i < a.size() || j < b.size()) {
+		if (j == b.size() || (i < a.size() && a[i].value < b[j].value)) {
+			out.push_back(a[i++]);
+		} else if (i == a.size() || b[j].value < a[i].value) {
+			out.push_back(b[j++]);
+		} else {
+			out.push_back({ a[i].value, a[i].paths + b[j].paths });
+			i++;
+			j++;
+		}
+	}
+}
+
+// Sorts states by value, merging the paths of states with the same value, given that the first
+// sortedSize are already like that
+static void compactStates(stateColumn &states, uint64_t sortedSize) {
+	auto byValue = [](const struct valuePaths &a, const struct valuePaths &b) {
+		return a.value < b.value;
+	};
+	sort(states.begin() + sortedSize, states.end(), byValue);
+	inplace_merge(states.begin(), states.begin() + sortedSize, states.end(), byValue);
+	
+	uint64_t kept = 0;
+	for (uint64_t i = 0; i < states.size(); i++) {
+		if (kept != 0 && states[kept - 1].value == states[i].value) {
+			states[kept - 1].paths += states[i].paths;
+		} else {
+			states[kept++] = states[i];
+		}
+	}
+	states.resize(kept);
+}
+
+// Residues mod S of M^(n(n + 1)/2), for every n. n(n + 1)/2 mod L repeats every 2L, and M^x mod S
+// is periodic once x is past log2(S), so a few more than 2S values of n see every one.
+static vector<bool> findKeptResidues(int m, int s) {
+	vector<bool> kept(s, false);
+	uint64_t residue = 1 % s; // M^(n(n + 1)/2)
+	uint64_t multiplier = 1 % s; // M^n
+	for (int n = 0; n < 4 * s + 64; n++) {
+		kept[residue] = true;
+		multiplier = multiplier * m % s;
+		residue = residue * multiplier % s;
+	}
+	return kept;
+}
+
+struct increasingMultiplierSieve *createIncreasingMultiplierSieve(struct increasingMultiplierConfig config) {
+	if (config.m < 2 || config.s < 2) {
+		throw out_of_range("M and S must both be at least 2");
+	}
+	if (config.maxValue < 1 || config.maxValue > MAX_INCREASING_MULTIPLIER_VALUE) {
+		throw out_of_range(
+			string("Error: max value '")
+			+ to_string(config.maxValue)
+			+ "' isn't between 1 and 2^62."
+		);
+	}
+	
+	struct increasingMultiplierSieve *sieve = new struct increasingMultiplierSieve;
+	sieve->config = config;
+	sieve->keptResidues = findKeptResidues(config.m, config.s);
+	sieve->stateCount = 0;
+	sieve->reachableCount = 0;
+	sieve->zeroCount = 0;
+	sieve->trivialZeroCount = 0;
+	sieve->pathCount = 0;
+	sieve->mostPaths = 0;
+	sieve->mostPathsValue = 0;
+	sieve->maxAdds = 0;
+	sieve->maxMultiplies = 0;
+	sieve->finished = false;
+	
+	return sieve;
+}
+
+void destroyIncreasingMultiplierSieve(struct increasingMultiplierSieve *sieve) {
+	delete sieve;
+}
+
+// Zeros in (from, to), i.e. between two reachable values
+static void countZerosBetween(struct increasingMultiplierSieve *sieve, uint64_t trivialPerBlock, uint64_t from, uint64_t to, const struct increasingMultiplierCallbacks &callbacks) {
+	if (to <= from + 1) return;
+	
+	uint64_t s = sieve->config.s;
+	uint64_t zeros = to - from - 1;
+	sieve->zeroCount += zeros;
+	
+	// Whole blocks of S values each have trivialPerBlock trivial zeros, so only the ends are counted one by one
+	uint64_t value = from + 1;
+	for (; value < to && value % s != 0; value++) {
+		if (!sieve->keptResidues[value % s]) sieve->trivialZeroCount++;
+	}
+	uint64_t blocks = (to - value) / s;
+	sieve->trivialZeroCount += blocks * trivialPerBlock;
+	for (value += blocks * s; value < to; value++) {
+		if (!sieve->keptResidues[value % s]) sieve->trivialZeroCount++;
+	}
+	
+	if (callbacks.zeroFound) {
+		for (value = from + 1; value < to; value++) {
+			if (sieve->keptResidues[value % s]) callbacks.zeroFound(value);
+		}
+	}
+}
+
+void runIncreasingMultiplierSieve(struct increasingMultiplierSieve *sieve, const struct increasingMultiplierCallbacks &callbacks) {
+	if (sieve->finished) {
+		throw logic_error("Error: runIncreasingMultiplierSieve() has already been run on this sieve");
+	}
+	
+	uint64_t maxValue = sieve->config.maxValue;
+	uint64_t m = sieve->config.m;
+	uint64_t s = sieve->config.s;
+	
+	// multipliers[n] = M^n, for as long as it's <= maxValue. Anything multiplied by more is past it.
+	vector<uint64_t> multipliers = { 1 };
+	while (multipliers.back() <= maxValue / m) {
+		multipliers.push_back(multipliers.back() * m);
+	}
+	
+	// Every state found, the first compactedSize of which are already merged into reachable values
+	stateColumn states;
+	uint64_t compactedSize = 0;
+	
+	// Columns (k - 1, n) and (k, n) for every n that has any values
+	vector<stateColumn> previousRow;
+	vector<stateColumn> row;
+	stateColumn added;
+	stateColumn multiplied;
+	uint64_t power = 1; // S^k
+	
+	for (int k = 0; true; k++) {
+		row.clear();
+		for (int n = 0; true; n++) {
+			// Column (k - 1, n) with S^k added
+			added.clear();
+			if (k > 0 && n < (int)previousRow.size()) {
+				for (const struct valuePaths &state : previousRow[n]) {
+					if (state.value > maxValue - power) break;
+					added.push_back({ state.value + power, state.paths });
+				}
+			}
+			
+			// Column (k, n - 1) multiplied by M^n
+			multiplied.clear();
+			if (k == 0 && n == 0) {
+				multiplied.push_back({ 1, 1 });
+			} else if (n > 0 && n < (int)multipliers.size()) {
+				uint64_t multiplier = multipliers[n];
+				for (const struct valuePaths &state : row[n - 1]) {
+					if (state.value > maxValue / multiplier) break;
+					multiplied.push_back({ state.value * multiplier, state.paths });
+				}
+			}
+			
+			// Both only get emptier as n goes up, so the row's done
+			if (added.empty() && multiplied.empty() && (n >= (int)previousRow.size() || k == 0)) break;
+			
+			row.emplace_back();
+			mergeColumns(added, multiplied, row.back());
+			if (!row.back().empty()) {
+				sieve->maxAdds = max(sieve->maxAdds, k);
+				sieve->maxMultiplies = max(sieve->maxMultiplies, n);
+			}
+			states.insert(states.end(), row.back().begin(), row.back().end());
+			sieve->stateCount += row.back().size();
+		}
+		
+		// Far more states than values are found for some M and S (3x for M = 2, S = 2), so the
+		// states are merged into values whenever they've doubled since last time
+		if (states.size() >= 2 * compactedSize + COMPACT_MIN_STATES) {
+			compactStates(states, compactedSize);
+			compactedSize = states.size();
+		}
+		
+		// Drop the empty columns at the end, so the next row knows where to stop
+		while (!row.empty() && row.back().empty()) {
+			row.pop_back();
+		}
+		if (row.empty()) break;
+		
+		if (callbacks.rowFinished) {
+			uint64_t rowStates = 0;
+			for (const stateColumn &column : row) {
+				rowStates += column.size();
+			}
+			callbacks.rowFinished(k, rowStates);
+		}
+		
+		swap(previousRow, row);
+		if (power > maxValue / s) break;
+		power *= s;
+	}
+	
+	compactStates(states, 0);
+	
+	uint64_t trivialPerBlock = count(sieve->keptResidues.begin(), sieve->keptResidues.end(), false);
+	uint64_t lastReachable = 0;
+	for (const struct valuePaths &state : states) {
+		uint64_t value = state.value;
+		uint64_t paths = state.paths;
+		
+		countZerosBetween(sieve, trivialPerBlock, lastReachable, value, callbacks);
+		lastReachable = value;
+		
+		sieve->reachableCount++;
+		sieve->pathCount += paths;
+		if (paths > sieve->mostPaths) {
+			sieve->mostPaths = paths;
+			sieve->mostPathsValue = value;
+		}
+		if (callbacks.reachableFound) {
+			callbacks.reachableFound(value, paths);
+		}
+	}
+	countZerosBetween(sieve, trivialPerBlock, lastReachable, maxValue + 1, callbacks);
+	
+	sieve->finished = true;
+}
\ No newline at end of file
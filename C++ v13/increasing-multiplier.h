@@ -0,0 +1,69 @@
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#ifndef INCREASING_MULTIPLIER_H
+#define INCREASING_MULTIPLIER_H
+
+// The variant in the problem statement at the top of Executor/Program.cs, where the n-th multiply
+// step multiplies by M^n rather than by M: start at 1, and either multiply by M^(n + 1) (n being
+// the multiplies so far) or add the next power of S (S^1 first).
+//
+// The multiplier no longer depends on just the last power added, so a state is (value, adds k,
+// multiplies n), and column (k, n) holds the values of every state with those counts. Column (k, n)
+// is column (k - 1, n) with S^k added to every value, merged with column (k, n - 1) with every
+// value multiplied by M^n, so the columns are made a row of every n per k at a time, and only the
+// previous row is kept.
+//
+// Unlike the fixed-multiplier problem, the reachable values are sparse (M^(n(n + 1)/2) soon runs
+// past any max, so there are only a handful of multiplies on any path): for M = 2, S = 3 there
+// are about 13,000 below 3 * 10^6, thinning out roughly as 1 / sqrt(max). So the columns are
+// sorted lists of (value, path count) rather than bitmaps, and merging them also counts the paths.
+// The zeros are then everything else: reachable values are congruent to some M^(n(n + 1)/2) mod S,
+// so those classes are kept, and the rest are counted as trivial zeros without being looked at.
+//
+// Memory is about 16 bytes per reachable value. M = 2, S = 3 up to 10^10 (714,000 states) takes
+// 0.1s, and M = 2, S = 2 up to 10^14 (179 million states, 53 million values) about 30s.
+
+struct increasingMultiplierConfig {
+	int m;
+	int s;
+	uint64_t maxValue;
+};
+
+// Any of these can be left empty
+struct increasingMultiplierCallbacks {
+	// Called for each reachable value, in increasing order, with the number of paths to it
+	std::function<void(uint64_t value, uint64_t paths)> reachableFound;
+	
+	// Called for each zero in a kept class mod S, in increasing order. Nearly every value is one,
+	// so this is only worth setting for a small max.
+	std::function<void(uint64_t value)> zeroFound;
+	
+	// Called after the column for every number of multiplies with `adds` powers of S added is made
+	std::function<void(int adds, uint64_t states)> rowFinished;
+};
+
+struct increasingMultiplierSieve {
+	struct increasingMultiplierConfig config;
+	std::vector<bool> keptResidues; // mod S, whether any reachable value can have that residue
+	
+	// Filled by runIncreasingMultiplierSieve()
+	uint64_t stateCount;
+	uint64_t reachableCount;
+	uint64_t zeroCount;
+	uint64_t trivialZeroCount; // of zeroCount, those in classes mod S that aren't kept
+	uint64_t pathCount; // over every reachable value
+	uint64_t mostPaths;
+	uint64_t mostPathsValue; // the smallest value with mostPaths paths
+	int maxAdds; // the most of any state
+	int maxMultiplies;
+	bool finished;
+};
+
+// Throws std::out_of_range for an M or S below 2, or a max value below 1 or past 2^62
+struct increasingMultiplierSieve *createIncreasingMultiplierSieve(struct increasingMultiplierConfig config);
+void runIncreasingMultiplierSieve(struct increasingMultiplierSieve *sieve, const struct increasingMultiplierCallbacks &callbacks);
+void destroyIncreasingMultiplierSieve(struct increasingMultiplierSieve *sieve);
+
+#endif
\ No newline at end of file
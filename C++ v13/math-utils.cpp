@@ -0,0 +1,104 @@
+#include "math-utils.h"
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+#include <string>
+
+using namespace std;
+
+// Takes the bits of x, and OR's the lower half into the even numbered positions (zero indexed) of *low,
+// and the upper half into the even numbered positions of *high
+// Adapted from: http://www.graphics.stanford.edu/~seander/bithacks.html#InterleaveBMN
+void spreadAndOrBits(uint64_t x, uint64_t *low, uint64_t *high) {
+	uint64_t xLow = x & 0x00000000FFFFFFFF;
+	uint64_t xHigh = (x & 0xFFFFFFFF00000000) >> 32;
+	
+	xLow = (xLow | (xLow << 16)) & 0x0000FFFF0000FFFF; //16 0's, 16 1's, 16 0's, 16 1's
+	xLow = (xLow | (xLow << 8 )) & 0x00FF00FF00FF00FF; //8 0's, 8 1's, 8 0's, ...
+	xLow = (xLow | (xLow << 4 )) & 0x0F0F0F0F0F0F0F0F; //00001111...
+	xLow = (xLow | (xLow << 2 )) & 0x3333333333333333; //00110011...
+	xLow = (xLow | (xLow << 1 )) & 0x5555555555555555; //0101...
+	
+	xHigh = (xHigh | (xHigh << 16)) & 0x0000FFFF0000FFFF;
+	xHigh = (xHigh | (xHigh << 8 )) & 0x00FF00FF00FF00FF;
+	xHigh = (xHigh | (xHigh << 4 )) & 0x0F0F0F0F0F0F0F0F;
+	xHigh = (xHigh | (xHigh << 2 )) & 0x3333333333333333;
+	xHigh = (xHigh | (xHigh << 1 )) & 0x5555555555555555;
+	
+	*low |= xLow;
+	*high |= xHigh;
+}
+
+void spreadAndOrBits_noMult3(uint64_t x, uint64_t *low, uint64_t *high) {
+	// Workings spreadsheet ("omit multiples of 3 workings 2.xlsx") shows that when omitting
+	// the multiples of 3, we still double the chunk position as usual, then in this method
+	// we just leave off the last step when spreading the bits (so they remain in pairs rather
+	// than fully spaced out), and then shift to the left by 1.
+	
+	uint64_t xLow = x & 0x00000000FFFFFFFF;
+	uint64_t xHigh = (x & 0xFFFFFFFF00000000) >> 32;
+	
+	xLow = (xLow | (xLow << 16)) & 0x0000FFFF0000FFFF; //16 0's, 16 1's, 16 0's, 16 1's
+	xLow = (xLow | (xLow << 8 )) & 0x00FF00FF00FF00FF; //8 0's, 8 1's, 8 0's, ...
+	xLow = (xLow | (xLow << 4 )) & 0x0F0F0F0F0F0F0F0F; //00001111...
+	xLow = (xLow | (xLow << 2 )) & 0x3333333333333333; //00110011...
+	xLow = xLow << 1;
+	
+	xHigh = (xHigh | (xHigh << 16)) & 0x0000FFFF0000FFFF;
+	xHigh = (xHigh | (xHigh << 8 )) & 0x00FF00FF00FF00FF;
+	xHigh = (xHigh | (xHigh << 4 )) & 0x0F0F0F0F0F0F0F0F;
+	xHigh = (xHigh | (xHigh << 2 )) & 0x3333333333333333;
+	xHigh = xHigh << 1;
+	
+	*low |= xLow;
+	*high |= xHigh;
+}
+
+// transforms something like:
+// 11111111 to:
+// 11001100 11001100
+// bits in *low and *high are overwritten, not ORed or anything
+void spreadBitsPaired(uint64_t x, uint64_t *low, uint64_t *high) {
+	uint64_t xLow = x & 0x00000000FFFFFFFF;
+	uint64_t xHigh = (x & 0xFFFFFFFF00000000) >> 32;
+	
+	xLow = (xLow | (xLow << 16)) & 0x0000FFFF0000FFFF; //16 0's, 16 1's, 16 0's, 16 1's
+	xLow = (xLow | (xLow << 8 )) & 0x00FF00FF00FF00FF; //8 0's, 8 1's, 8 0's, ...
+	xLow = (xLow | (xLow << 4 )) & 0x0F0F0F0F0F0F0F0F; //00001111...
+	xLow = (xLow | (xLow << 2 )) & 0x3333333333333333; //00110011...
+	
+	xHigh = (xHigh | (xHigh << 16)) & 0x0000FFFF0000FFFF;
+	xHigh = (xHigh | (xHigh << 8 )) & 0x00FF00FF00FF00FF;
+	xHigh = (xHigh | (xHigh << 4 )) & 0x0F0F0F0F0F0F0F0F;
+	xHigh = (xHigh | (xHigh << 2 )) & 0x3333333333333333;
+	
+	*low = xLow;
+	*high = xHigh;
+}
+
+bool parseUInt128(const char *str, uint128_t *out) {
+	if (*str == '\0') return false;
+	
+	uint128_t n = 0;
+	for (; *str != '\0'; str++) {
+		if (*str < '0' || *str > '9') return false;
+		
+		uint128_t digit = *str - '0';
+		if (n > (~(uint128_t)0 - digit) / 10) return false;
+		n = n * 10 + digit;
+	}
+	
+	*out = n;
+	return true;
+}
+
+string uint128ToString(uint128_t n) {
+	if (n == 0) return "0";
+	
+	string str;
+	while (n != 0) {
+		str.insert(str.begin(), (char)('0' + (int)(n % 10)));
+		n /= 10;
+	}
+	return str;
+}
\ No newline at end of file
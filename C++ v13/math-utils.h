@@ -0,0 +1,82 @@
+#include <stdint.h>
+#include <string>
+
+#ifndef MATH_UTILS_H
+#define MATH_UTILS_H
+
+void spreadAndOrBits(uint64_t x, uint64_t *low, uint64_t *high);
+void spreadAndOrBits_noMult3(uint64_t x, uint64_t *low, uint64_t *high);
+void spreadBitsPaired(uint64_t x, uint64_t *low, uint64_t *high);
+
+// For values beyond what the sieves can reach, e.g. 10^13 and up in the backward search
+typedef unsigned __int128 uint128_t;
+
+// Decimal only. Returns false (leaving *out alone) if str is empty, has anything other than digits,
+// or doesn't fit in 128 bits.
+bool parseUInt128(const char *str, uint128_t *out);
+std::string uint128ToString(uint128_t n);
+
+// Unlike floorLog2_64bit(), n must not be 0
+inline int countTrailingZeros128(uint128_t n) {
+	uint64_t low = (uint64_t)n;
+	return low != 0 ? __builtin_ctzll(low) : 64 + __builtin_ctzll((uint64_t)(n >> 64));
+}
+
+inline int floorLog2_128(uint128_t n) {
+	uint64_t high = (uint64_t)(n >> 64);
+	return high != 0 ? 127 - __builtin_clzll(high) : 63 - __builtin_clzll((uint64_t)n);
+}
+
+// Unlike isPowerOf2(), false for 0
+inline bool isPowerOf2_128(uint128_t n) {
+	return n != 0 && (n & (n - 1)) == 0;
+}
+
+// Compile-time table, so threeToThe() is a single load (or folds away for a constant power)
+constexpr uint64_t threePowers[40] = {
+	1ull, 3ull, 9ull, 27ull, 81ull, 243ull, 729ull, 2187ull, 6561ull, 19683ull, 59049ull, 177147ull,
+	531441ull, 1594323ull, 4782969ull, 14348907ull, 43046721ull, 129140163ull, 387420489ull, 1162261467ull,
+	3486784401ull, 10460353203ull, 31381059609ull, 94143178827ull, 282429536481ull, 847288609443ull,
+	2541865828329ull, 7625597484987ull, 22876792454961ull, 68630377364883ull, 205891132094649ull,
+	617673396283947ull, 1853020188851841ull, 5559060566555523ull, 16677181699666569ull, 50031545098999707ull,
+	150094635296999121ull, 450283905890997363ull, 1350851717672992089ull, 4052555153018976267ull
+};
+
+// Unchecked: power must be < 40. Anything that could ask for more checks once up front
+// (e.g. against the max value), rather than on every call
+constexpr uint64_t threeToThe(int power) {
+	return threePowers[power];
+}
+
+//Note: returns 0 for n == 0, same as the De Bruijn lookup this replaces
+constexpr int floorLog2_64bit(uint64_t n) {
+	return n == 0 ? 0 : 63 - __builtin_clzll(n);
+}
+
+//Note: returns true for n == 0
+//Source: http://www.graphics.stanford.edu/~seander/bithacks.html#DetermineIfPowerOf2
+constexpr bool isPowerOf2(uint64_t n) {
+	return (n & (n - 1)) == 0;
+}
+
+// input:   1  2  4  5  7  8  10 11 13 14 16 17 19 20 22 23 25 26 28 29 31 ...
+// maps to: 0  1  2  3  4  5  6  7  8  9  10 11 12 13 14 15 16 17 18 19 20 ...
+#define mapToAvoidMult3s(n) \
+	((n) - (uint64_t)((n) / 3) - 1)
+
+#define spreadBitsPaired_macro(x, low, high) { \
+	low = (x) & 0x00000000FFFFFFFF; \
+	high = ((x) & 0xFFFFFFFF00000000) >> 32; \
+	\
+	low = (low | (low << 16)) & 0x0000FFFF0000FFFF; \
+	low = (low | (low << 8 )) & 0x00FF00FF00FF00FF; \
+	low = (low | (low << 4 )) & 0x0F0F0F0F0F0F0F0F; \
+	low = (low | (low << 2 )) & 0x3333333333333333; \
+	\
+	high = (high | (high << 16)) & 0x0000FFFF0000FFFF; \
+	high = (high | (high << 8 )) & 0x00FF00FF00FF00FF; \
+	high = (high | (high << 4 )) & 0x0F0F0F0F0F0F0F0F; \
+	high = (high | (high << 2 )) & 0x3333333333333333; \
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "math-utils.h"
+#include "backward-search.h"
+#include "meet-in-the-middle.h"
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+static uint128_t addCounts(uint128_t a, uint128_t b) {
+	uint128_t sum = a + b;
+	if (sum < a) {
+		throw overflow_error("Error: path count doesn't fit in 128 bits");
+	}
+	return sum;
+}
+
+static void buildReachableBits(struct meetInTheMiddle *mitm) {
+	uint64_t lowMax = mitm->config.lowMax;
+	uint64_t words = mapToAvoidMult3s(lowMax) / 64 + 1;
+	
+	mitm->reachableBits.assign(mitm->maxLowPowOf3 + 1, vector<uint64_t>(words, 0));
+	for (uint64_t value = 1; value <= lowMax; value *= 2) {
+		uint64_t pos = mapToAvoidMult3s(value);
+		mitm->reachableBits[0][pos / 64] |= 1ull << (pos % 64);
+	}
+	
+	// Halving & taking off 3^k never turn a non-multiple of 3 into a multiple, so those are skipped
+	for (int k = 1; k <= mitm->maxLowPowOf3; k++) {
+		const vector<uint64_t> &previous = mitm->reachableBits[k - 1];
+		vector<uint64_t> &plane = mitm->reachableBits[k];
+		uint64_t powOf3 = threeToThe(k);
+		
+		for (uint64_t value = powOf3 + 1; value <= lowMax; value++) {
+			if (value % 3 == 0) continue;
+			
+			uint64_t subtracted = mapToAvoidMult3s(value - powOf3);
+			bool reachable = (previous[subtracted / 64] >> (subtracted % 64)) & 1;
+			if (!reachable && value % 2 == 0) {
+				uint64_t halved = mapToAvoidMult3s(value / 2);
+				reachable = (plane[halved / 64] >> (halved % 64)) & 1;
+			}
+			
+			if (reachable) {
+				uint64_t pos = mapToAvoidMult3s(value);
+				plane[pos / 64] |= 1ull << (pos % 64);
+			}
+		}
+	}
+}
+
+static void buildPathCounts(struct meetInTheMiddle *mitm) {
+	uint64_t lowMax = mitm->config.lowMax;
+	uint64_t size = mapToAvoidMult3s(lowMax) + 1;
+	
+	mitm->pathCounts.assign(mitm->maxLowPowOf3 + 1, vector<uint32_t>(size, 0));
+	for (uint64_t value = 1; value <= lowMax; value *= 2) {
+		mitm->pathCounts[0][mapToAvoidMult3s(value)] = 1;
+	}
+	
+	for (int k = 1; k <= mitm->maxLowPowOf3; k++) {
+		const vector<uint32_t> &previous = mitm->pathCounts[k - 1];
+		vector<uint32_t> &plane = mitm->pathCounts[k];
+		uint64_t powOf3 = threeToThe(k);
+		
+		for (uint64_t value = powOf3 + 1; value <= lowMax; value++) {
+			if (value % 3 == 0) continue;
+			
+			uint64_t count = previous[mapToAvoidMult3s(value - powOf3)];
+			if (value % 2 == 0) count += plane[mapToAvoidMult3s(value / 2)];
+			
+			if (count > UINT32_MAX) {
+				throw overflow_error("Error: a path count below lowMax doesn't fit in 32 bits");
+			}
+			plane[mapToAvoidMult3s(value)] = (uint32_t)count;
+		}
+	}
+}
+
+static uint128_t lookUpLowHalf(struct meetInTheMiddle *mitm, uint64_t value, int lastPowOf3) {
+	mitm->tableLookups++;
+	return lowHalfPaths(mitm, value, lastPowOf3);
+}
+
+// Only complete counts are memoised, so a memoised state's count is nonzero only if it's really
+// reachable, whichever way it was found
+uint128_t countPathsFrom(struct meetInTheMiddle *mitm, uint128_t value, int lastPowOf3, bool stopAtFirst) {
+	if (value < pow3_128.minSums[lastPowOf3] || value % 3 == 0) return 0;
+	
+	// Every state with value <= lowMax has lastPowOf3 <= maxLowPowOf3, as minSums[k] <= value
+	if (value <= mitm->config.lowMax) return lookUpLowHalf(mitm, (uint64_t)value, lastPowOf3);
+	if (lastPowOf3 <= 1) return isReachableLeaf(value, lastPowOf3) ? 1 : 0;
+	
+	struct backwardState state = { value, lastPowOf3 };
+	if (mitm->config.maxHighMemoEntries != 0 && lastPowOf3 >= MIN_MEMOISED_POW_OF_3) {
+		auto it = mitm->highMemo.find(state);
+		if (it != mitm->highMemo.end()) {
+			mitm->memoHits++;
+			return it->second;
+		}
+	}
+	
+	mitm->statesVisited++;
+	
+	// Halve some number of times, then take off 3^lastPowOf3. Once halving gets into the table,
+	// that state's count already covers halving further.
+	//
+	// When deciding, halving twice then once are tried before the rest (0, 3, 4, ...). That keeps
+	// the value roughly in proportion to the powers left to take off, where nearly every state is
+	// reachable, rather than heading for a small power with a huge value, where hardly any are. A
+	// path to 10^30 turns up in 0.1s this way, and not in 5 minutes in order.
+	uint128_t count = 0;
+	int maxHalvings = countTrailingZeros128(value);
+	for (int i = 0; i <= max(maxHalvings, 2); i++) {
+		int halvings = stopAtFirst && i <= 2 ? 2 - i : i;
+		if (halvings > maxHalvings) continue;
+		
+		uint128_t halved = value >> halvings;
+		if (halved < pow3_128.minSums[lastPowOf3]) {
+			maxHalvings = halvings - 1;
+			continue;
+		}
+		
+		if (halvings != 0 && halved <= mitm->config.lowMax) {
+			count = addCounts(count, lookUpLowHalf(mitm, (uint64_t)halved, lastPowOf3));
+			if (stopAtFirst && count != 0) return count;
+			maxHalvings = halvings - 1;
+			continue;
+		}
+		
+		count = addCounts(count, countPathsFrom(mitm, halved - pow3_128.powers[lastPowOf3], lastPowOf3 - 1, stopAtFirst));
+		if (stopAtFirst && count != 0) return count;
+	}
+	
+	if (mitm->config.maxHighMemoEntries != 0 && lastPowOf3 >= MIN_MEMOISED_POW_OF_3) {
+		if (mitm->highMemo.size() >= mitm->config.maxHighMemoEntries) {
+			mitm->highMemo.clear();
+		}
+		mitm->highMemo[state] = count;
+	}
+	return count;
+}
+
+struct meetInTheMiddleConfig defaultMeetInTheMiddleConfig(bool countPaths) {
+	struct meetInTheMiddleConfig config;
+	config.lowMax = countPaths ? 1ull << 22 : 1ull << 26;
+	config.countPaths = countPaths;
+	config.maxHighMemoEntries = 4000000; // about 300MB
+	return config;
+}
+
+struct meetInTheMiddle *createMeetInTheMiddle(struct meetInTheMiddleConfig config) {
+	if (config.lowMax < 2) {
+		throw out_of_range("lowMax < 2");
+	}
+	if (config.lowMax > threeToThe(39)) {
+		throw out_of_range("lowMax > 3^39");
+	}
+	
+	struct meetInTheMiddle *mitm = new struct meetInTheMiddle;
+	mitm->config = config;
+	mitm->maxLowPowOf3 = maxLastPowOf3(config.lowMax);
+	mitm->statesVisited = 0;
+	mitm->tableLookups = 0;
+	mitm->memoHits = 0;
+	
+	if (config.countPaths) {
+		buildPathCounts(mitm);
+	} else {
+		buildReachableBits(mitm);
+	}
+	
+	return mitm;
+}
+
+void destroyMeetInTheMiddle(struct meetInTheMiddle *mitm) {
+	delete mitm;
+}
+
+bool isReachableMeetInTheMiddle(struct meetInTheMiddle *mitm, uint128_t value) {
+	if (value == 0) return false;
+	
+	for (int lastPowOf3 = maxLastPowOf3(value); lastPowOf3 >= 0; lastPowOf3--) {
+		if (countPathsFrom(mitm, value, lastPowOf3, true) != 0) return true;
+	}
+	return false;
+}
+
+uint128_t countPathsMeetInTheMiddle(struct meetInTheMiddle *mitm, uint128_t value) {
+	if (!mitm->config.countPaths) {
+		throw logic_error("Error: path counts weren't built (countPaths = false)");
+	}
+	if (value == 0) return 0;
+	
+	uint128_t count = 0;
+	for (int lastPowOf3 = maxLastPowOf3(value); lastPowOf3 >= 0; lastPowOf3--) {
+		count = addCounts(count, countPathsFrom(mitm, value, lastPowOf3, false));
+	}
+	return count;
+}
\ No newline at end of file
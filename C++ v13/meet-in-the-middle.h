@@ -0,0 +1,87 @@
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "backward-search.h"
+#include "math-utils.h"
+
+#ifndef MEET_IN_THE_MIDDLE_H
+#define MEET_IN_THE_MIDDLE_H
+
+// A reachable value is sum(3^i * 2^e_i) for i = 0 to k, with e_0 >= e_1 >= ... >= e_k >= 0 (the
+// rephrasing in Executor/Program.cs). Splitting that sum at some power, the low powers make a
+// reachable value with its own last power, times 2^(the high half's largest exponent). So:
+//  - the low half is built forwards once: a table, for every last power k, of the values up to
+//    lowMax that can be reached with 3^k as the last power (or how many ways)
+//  - the high half is enumerated backwards from the target, over how many times to halve before
+//    taking off each power of 3, until what's left is <= lowMax
+//  - the two are joined by looking up (what's left, the power about to be taken off) in the table
+// The high half's partial sums are far too many to store (about target^0.5 paths), so they're
+// walked depth first rather than sorted or hashed; it's the low half where memory is traded for
+// time, as every state below lowMax (nearly all of them) becomes a single lookup.
+//
+// Deciding needs a bit per value & power, about 95MB for the default lowMax; counting needs 4 bytes.
+// The higher states above lowMax are memoised by (value, power about to be taken off) in a hash map.
+//
+// A path to a reachable value up to 2^100 or so usually turns up in milliseconds, and the zero
+// 128502917195 is ruled out in 0.01s (against about a second with backward-search.h), but proving a
+// value is a zero still means exhausting its states, which grows about with the square root of the
+// value. Counting takes about as long as backward-path-count.h.
+
+// High states with a smaller last power than this are rarely met twice, and recounting them is
+// cheaper than the hash map (memoising all of them made counting 10^14 30x slower)
+const int MIN_MEMOISED_POW_OF_3 = 12;
+
+struct meetInTheMiddleConfig {
+	uint64_t lowMax; // the largest value the table covers
+	bool countPaths; // store path counts rather than just whether each state is reachable
+	
+	// High half states already counted (or found dead) are remembered, across calls too. The memo is
+	// cleared when it gets this big. 0 turns it off.
+	uint64_t maxHighMemoEntries;
+};
+
+struct meetInTheMiddle {
+	struct meetInTheMiddleConfig config;
+	int maxLowPowOf3; // no value <= lowMax has a later last power than this
+	
+	// [k][mapToAvoidMult3s(value)], for values up to lowMax. Only one of these is filled.
+	std::vector<std::vector<uint64_t>> reachableBits;
+	std::vector<std::vector<uint32_t>> pathCounts;
+	
+	std::unordered_map<struct backwardState, uint128_t, struct backwardStateHash> highMemo;
+	
+	// Totals over every call so far
+	uint64_t statesVisited; // above lowMax
+	uint64_t tableLookups;
+	uint64_t memoHits;
+};
+
+// Deciding if countPaths is false, counting (with a smaller table) if true
+struct meetInTheMiddleConfig defaultMeetInTheMiddleConfig(bool countPaths);
+
+// Builds the table, which takes a few seconds for the default lowMax. Throws std::overflow_error if
+// a count doesn't fit in 32 bits (not below 2^32).
+struct meetInTheMiddle *createMeetInTheMiddle(struct meetInTheMiddleConfig config);
+void destroyMeetInTheMiddle(struct meetInTheMiddle *mitm);
+
+// The low half table's entry: how many paths (or 1 if deciding and there's any) reach value with
+// 3^lastPowOf3 as the last power. value must be <= lowMax and not a multiple of 3, and lastPowOf3
+// <= maxLowPowOf3.
+inline uint64_t lowHalfPaths(const struct meetInTheMiddle *mitm, uint64_t value, int lastPowOf3) {
+	uint64_t pos = mapToAvoidMult3s(value);
+	if (mitm->config.countPaths) return mitm->pathCounts[lastPowOf3][pos];
+	return (mitm->reachableBits[lastPowOf3][pos / 64] >> (pos % 64)) & 1;
+}
+
+bool isReachableMeetInTheMiddle(struct meetInTheMiddle *mitm, uint128_t value);
+
+// The paths to value with 3^lastPowOf3 as the last power (lastPowOf3 <= 40), or if stopAtFirst,
+// nonzero as soon as one's found. High states are memoised in highMemo, as for the calls above.
+// Throws std::overflow_error if the count doesn't fit in 128 bits.
+uint128_t countPathsFrom(struct meetInTheMiddle *mitm, uint128_t value, int lastPowOf3, bool stopAtFirst);
+
+// Throws std::logic_error if created without countPaths, or std::overflow_error if the count
+// doesn't fit in 128 bits
+uint128_t countPathsMeetInTheMiddle(struct meetInTheMiddle *mitm, uint128_t value);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include <stdint.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "bit-view.h"
+#include "column-sieve.h"
+#include "ms-kernels.h"
+
+#ifndef MS_COLUMN_SIEVE_H
+#define MS_COLUMN_SIEVE_H
+
+// The v12 single-column engine for any multiplier M and summand S, i.e. start at 1, and either
+// multiply by M or add the next power of S (S^1 first). This is the same problem as
+// BinaryDecisionZMSFinder in the C# project and reachability-search-m-s-agnostic.pl, but M and S
+// are template parameters so the kernels & storage layout (see ms-kernels.h) are fixed at compile
+// time. msColumnSieve<2, 3> finds the same zeros as struct columnSieve.
+//
+// Uses the same config & callbacks as struct columnSieve, with powOf3 meaning the power of S.
+// Zeros are only reported for the residues mod S that are kept, as the rest can never be reached.
+//
+// Each column k holds the values reachable with S^k as the last power added, relative to the
+// smallest one, 1 + S + ... + S^k. So column k+1 starts out as the same bits as column k, and
+// only needs multiplying along, then ORing into the aggregate.
+
+template <int M, int S>
+struct msColumnSieve {
+	struct columnSieveConfig config;
+	uint64_t maxValueRepresentable;
+	uint64_t *expRegCol;
+	uint64_t *colsAggregate;
+	bool finished;
+};
+
+template <int M, int S>
+struct msColumnSieve<M, S> *createMSColumnSieve(struct columnSieveConfig config) {
+	if (config.colLength < 1) {
+		throw std::out_of_range("colLength < 1");
+	}
+	
+	struct msColumnSieve<M, S> *sieve = new struct msColumnSieve<M, S>;
+	sieve->config = config;
+	sieve->maxValueRepresentable = msValueAt<M, S>(config.colLength * CHUNK_BITS - 1);
+	sieve->expRegCol = new uint64_t[config.colLength + M + 2](); // overflow for copyAlongToMultiplyCurrentPos()
+	sieve->colsAggregate = new uint64_t[config.colLength + 1](); // 1 chunk of overflow, as the bit-adjusted aggregating can spill one past the end
+	sieve->finished = false;
+	
+	return sieve;
+}
+
+template <int M, int S>
+void destroyMSColumnSieve(struct msColumnSieve<M, S> *sieve) {
+	if (sieve == nullptr) return;
+	
+	delete[] sieve->expRegCol;
+	delete[] sieve->colsAggregate;
+	delete sieve;
+}
+
+// Only valid after runMSColumnSieve() has returned, and until destroyMSColumnSieve().
+// Bits are in the ms-kernels.h layout, so read it with isReachableMS<M, S>() rather than isReachable().
+template <int M, int S>
+struct reachabilityBitView getMSAggregateView(const struct msColumnSieve<M, S> *sieve) {
+	if (!sieve->finished) {
+		throw std::logic_error("Error: the aggregate isn't final until runMSColumnSieve() has returned");
+	}
+	
+	struct reachabilityBitView view;
+	view.chunks = sieve->colsAggregate;
+	view.chunkCount = sieve->config.colLength;
+	view.maxValue = sieve->maxValueRepresentable;
+	return view;
+}
+
+template <int M, int S>
+bool isReachableMS(const struct reachabilityBitView *view, uint64_t value) {
+	if (value > view->maxValue) {
+		throw std::out_of_range(
+			std::string("Error: value '")
+			+ std::to_string(value)
+			+ "' is beyond the max value stored '"
+			+ std::to_string(view->maxValue)
+			+ "'."
+		);
+	}
+	if (value == 0 || msTables<M, S>.rankOf[value % S] < 0) return false;
+	
+	uint64_t bitPos = msPositionOf<M, S>(value);
+	return (view->chunks[bitPos / CHUNK_BITS] >> (bitPos % CHUNK_BITS)) & 1;
+}
+
+// Multiplies along the first two chunks bit by bit, as a multiplied bit can land in the same or the
+// next chunk there. From chunk 2 on, copyAlongToMultiplyCurrentPos() only ever writes to later chunks.
+template <int M, int S>
+void initialiseMSColFirstChunks(uint64_t *col, uint64_t colBits, uint64_t multiplyAdjustment) {
+	uint64_t lastBit = std::min((uint64_t)(2 * CHUNK_BITS), colBits);
+	for (uint64_t j = 0; j < lastBit; j++) {
+		if ((col[j / CHUNK_BITS] & (1ULL << (j % CHUNK_BITS))) == 0) continue;
+		
+		uint64_t multipliedBit = msPositionOf<M, S>(M * msValueAt<M, S>(j)) + multiplyAdjustment;
+		if (multipliedBit < colBits) {
+			col[multipliedBit / CHUNK_BITS] |= 1ULL << (multipliedBit % CHUNK_BITS);
+		}
+	}
+}
+
+template <int M, int S>
+void reportMSZeros(uint64_t chunk, uint64_t bitOffset, const struct columnSieveCallbacks &callbacks) {
+	if (!callbacks.zeroFound) return;
+	
+	// Find & report the position of the OFF bits, offset by bitOffset
+	for (uint64_t i = 0; i < CHUNK_BITS; i++) {
+		if ((~chunk) & (1ULL << i)) {
+			callbacks.zeroFound(msValueAt<M, S>(bitOffset + i));
+		}
+	}
+}
+
+template <int M, int S>
+void runMSColumnSieve(struct msColumnSieve<M, S> *sieve, const struct columnSieveCallbacks &callbacks) {
+	constexpr const struct msResidueTables<M, S> &t = msTables<M, S>;
+	constexpr const struct msPowerTable<S> &sPowers = msPowers<S>;
+	
+	if (sieve->finished) {
+		throw std::logic_error("Error: runMSColumnSieve() has already been run on this sieve");
+	}
+	
+	uint64_t colLength = sieve->config.colLength;
+	uint64_t maxValueRepresentable = sieve->maxValueRepresentable;
+	uint64_t *expRegCol = sieve->expRegCol;
+	uint64_t *colsAggregate = sieve->colsAggregate;
+	
+	// Setup column 0, i.e. ON at every power of M
+	for (uint64_t i = 1; i <= maxValueRepresentable; i *= M) {
+		uint64_t bitPos = msPositionOf<M, S>(i);
+		expRegCol[bitPos / CHUNK_BITS] |= 1ULL << (bitPos % CHUNK_BITS);
+		
+		if (i > maxValueRepresentable / M) break;
+	}
+	
+	// Overlay column 0 onto the aggregate
+	for (uint64_t i = 0; i < colLength; i++) {
+		colsAggregate[i] |= expRegCol[i];
+	}
+	
+	// chunks of the aggregate before this have had their zeros reported
+	uint64_t zerosReportedUpToChunk = 0;
+	
+	// Everything below the first value of the next column is final, so report zeros up to there
+	#define reportFinalZeros(nextFirstValueRepresented) { \
+		uint64_t finalUpToChunk = colLength; \
+		if ((nextFirstValueRepresented) <= maxValueRepresentable) { \
+			finalUpToChunk = msPositionOf<M, S>(nextFirstValueRepresented) / CHUNK_BITS; \
+		} \
+		for (; zerosReportedUpToChunk < finalUpToChunk; zerosReportedUpToChunk++) { \
+			if (~colsAggregate[zerosReportedUpToChunk] != 0) { \
+				reportMSZeros<M, S>(colsAggregate[zerosReportedUpToChunk], zerosReportedUpToChunk * CHUNK_BITS, callbacks); \
+			} \
+		} \
+	}
+	
+	uint64_t firstBitValueRepresented = 1;
+	for (int powOfS = 1; true; powOfS++) {
+		if (powOfS >= sPowers.count || sPowers.powers[powOfS] > maxValueRepresentable) break;
+		
+		reportFinalZeros(firstBitValueRepresented + sPowers.powers[powOfS]);
+		
+		firstBitValueRepresented += sPowers.powers[powOfS];
+		if (firstBitValueRepresented > maxValueRepresentable) break;
+		
+		// Column bit j represents firstBitValueRepresented - 1 + msValueAt(j). As firstBitValueRepresented - 1
+		// is a multiple of S, that's just a shift of (firstBitValueRepresented - 1) / S blocks in the aggregate,
+		// and M - 1 times as many when multiplying along the column.
+		uint64_t blocksAdjustment = (firstBitValueRepresented - 1) / S;
+		uint64_t aggAdjustment = blocksAdjustment * t.kept;
+		uint64_t aggChunksAdjustment = aggAdjustment / CHUNK_BITS;
+		uint64_t aggBitsAdjustment = aggAdjustment % CHUNK_BITS;
+		uint64_t mulAdjustment = (M - 1) * aggAdjustment;
+		uint64_t mulChunksAdjustment = mulAdjustment / CHUNK_BITS;
+		uint64_t mulBitsAdjustment = mulAdjustment % CHUNK_BITS;
+		
+		// Chunks of the column beyond this are past the end of the aggregate, and as later columns start
+		// later still, nothing will ever need them
+		uint64_t lastChunkToAggregate = colLength - aggChunksAdjustment;
+		
+		// Chunks from this one on only multiply into chunks at or beyond lastChunkToAggregate
+		uint64_t lastChunkToMultiply = 0;
+		if (lastChunkToAggregate + 1 > mulChunksAdjustment) {
+			lastChunkToMultiply = std::min(lastChunkToAggregate, (lastChunkToAggregate + 1 - mulChunksAdjustment + M - 1) / M);
+		}
+		
+		initialiseMSColFirstChunks<M, S>(expRegCol, lastChunkToAggregate * CHUNK_BITS, mulAdjustment);
+		
+		#define aggregate() { \
+			uint64_t *aggChunks = colsAggregate + chunk + aggChunksAdjustment; \
+			aggChunks[0] |= expRegCol[chunk] << aggBitsAdjustment; \
+			aggChunks[1] |= (expRegCol[chunk] >> 1) >> (CHUNK_BITS - 1 - aggBitsAdjustment); \
+		}
+		
+		#define multiply() { \
+			copyAlongToMultiplyCurrentPos<M, S>(expRegCol, chunk, phase, mulChunksAdjustment, mulBitsAdjustment); \
+			phase = (phase + CHUNK_BITS % t.kept) % t.kept; \
+		}
+		
+		#define reportProgress() { \
+			if ((chunk & 0xFFFF) == 0 && callbacks.progress) { \
+				callbacks.progress(powOfS, chunk); \
+			} \
+		}
+		
+		uint64_t chunk = 0;
+		for (; chunk < std::min((uint64_t)2, lastChunkToAggregate); chunk++) {
+			aggregate();
+		}
+		
+		int phase = (2 * CHUNK_BITS) % t.kept;
+		uint64_t firstLimit = std::min(lastChunkToMultiply, lastChunkToAggregate);
+		for (; chunk < firstLimit; chunk++) {
+			multiply();
+			aggregate();
+			reportProgress();
+		}
+		
+		// Either done multiplying or done aggregating, so carry on with whichever isn't
+		for (; chunk < lastChunkToMultiply; chunk++) {
+			multiply();
+			reportProgress();
+		}
+		for (; chunk < lastChunkToAggregate; chunk++) {
+			aggregate();
+			reportProgress();
+		}
+		
+		#undef aggregate
+		#undef multiply
+		#undef reportProgress
+		
+		if (callbacks.columnFinished) {
+			callbacks.columnFinished(powOfS, firstBitValueRepresented);
+		}
+	}
+	
+	// Nothing further can be reached, so the rest of the aggregate is final too
+	reportFinalZeros(maxValueRepresentable + 1);
+	
+	#undef reportFinalZeros
+	
+	sieve->finished = true;
+}
+
+#endif
\ No newline at end of file
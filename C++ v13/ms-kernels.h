@@ -0,0 +1,231 @@
+#include <stdint.h>
+#include "column-kernels.h"
+
+#ifndef MS_KERNELS_H
+#define MS_KERNELS_H
+
+// Compile-time tables and per-chunk kernels for the sieve in ms-column-sieve.h, which generalises
+// the v12 column engine from "double or add the next power of 3" to "multiply by M or add the next
+// power of S".
+//
+// Storage layout: starting from 1, multiplying by M and adding multiples of S means a reachable
+// value is always congruent to some M^a mod S. The residues mod S outside that orbit can never be
+// reached, so (just like multiples of 3 for M = 2, S = 3) no bits are stored for them. Each block
+// of S consecutive values then takes `kept` bits, one per residue in the orbit, in increasing
+// order of residue.
+//
+// Multiplying by M then maps bit p to bit M * p + multiplyDelta[p % kept] (the bits are spread
+// M-way and then each residue class is nudged by a small constant), plus a constant adjustment
+// for where the column starts. For M = 2, S = 3 that's bit 2j -> 4j + 1 and bit 2j + 1 -> 4j + 2,
+// the same as copyAlongToDoubleCurrentPos_macro.
+
+template <int M, int S>
+struct msResidueTables {
+	int kept; // residues mod S that can be reached, i.e. bits stored per block of S values
+	int rankOf[S]; // bit within a block for each residue, or -1 if it can never be reached
+	int residueAt[S]; // inverse of rankOf, only the first `kept` are used
+	int multiplyDelta[S]; // indexed by bit position % kept, see above
+	int minDelta;
+	int maxDelta;
+	
+	// The bits of a chunk grouped by which multiplyDelta they need, so each group is one shift.
+	// Which bits fall in which residue class depends on (64 * chunk) % kept, the chunk's phase.
+	int deltaGroups;
+	int groupDelta[S];
+	uint64_t spreadMasks[S][S][M]; // [phase][group][word], already spread M-way
+};
+
+template <int M, int S>
+constexpr struct msResidueTables<M, S> makeMSResidueTables() {
+	static_assert(M >= 2 && S >= 2, "M and S must both be at least 2");
+	
+	struct msResidueTables<M, S> t = {};
+	
+	bool reachableResidue[S] = {};
+	for (int r = 1 % S; !reachableResidue[r]; r = (r * M) % S) {
+		reachableResidue[r] = true;
+	}
+	
+	t.kept = 0;
+	for (int r = 0; r < S; r++) {
+		t.rankOf[r] = reachableResidue[r] ? t.kept : -1;
+		if (reachableResidue[r]) t.residueAt[t.kept++] = r;
+	}
+	
+	// For n = q*S + residueAt[idx], stored at block position B = q*kept + idx (see
+	// msPositionOf()), M*n is at block position M*q*kept + multipliedOffset
+	int rankOfOne = t.rankOf[1 % S];
+	for (int j = 0; j < t.kept; j++) {
+		int idx = (j + rankOfOne) % t.kept;
+		int residue = t.residueAt[idx];
+		int multipliedOffset = (M * residue / S) * t.kept + t.rankOf[(M * residue) % S];
+		t.multiplyDelta[j] = (M - 1) * rankOfOne - M * idx + multipliedOffset;
+		
+		if (j == 0 || t.multiplyDelta[j] < t.minDelta) t.minDelta = t.multiplyDelta[j];
+		if (j == 0 || t.multiplyDelta[j] > t.maxDelta) t.maxDelta = t.multiplyDelta[j];
+	}
+	
+	t.deltaGroups = 0;
+	for (int j = 0; j < t.kept; j++) {
+		bool seen = false;
+		for (int g = 0; g < t.deltaGroups; g++) {
+			if (t.groupDelta[g] == t.multiplyDelta[j]) seen = true;
+		}
+		if (!seen) t.groupDelta[t.deltaGroups++] = t.multiplyDelta[j];
+	}
+	
+	for (int phase = 0; phase < t.kept; phase++) {
+		for (int i = 0; i < CHUNK_BITS; i++) {
+			int delta = t.multiplyDelta[(phase + i) % t.kept];
+			int g = 0;
+			while (t.groupDelta[g] != delta) g++;
+			
+			int spreadPos = M * i;
+			t.spreadMasks[phase][g][spreadPos / CHUNK_BITS] |= 1ULL << (spreadPos % CHUNK_BITS);
+		}
+	}
+	
+	return t;
+}
+
+template <int M, int S>
+constexpr struct msResidueTables<M, S> msTables = makeMSResidueTables<M, S>();
+
+// S^0, S^1, ... for as long as they fit in 64 bits
+template <int S>
+struct msPowerTable {
+	uint64_t powers[64];
+	int count;
+};
+
+template <int S>
+constexpr struct msPowerTable<S> makeMSPowerTable() {
+	struct msPowerTable<S> t = {};
+	uint64_t power = 1;
+	while (true) {
+		t.powers[t.count++] = power;
+		if (power > UINT64_MAX / S) break;
+		power *= S;
+	}
+	return t;
+}
+
+template <int S>
+constexpr struct msPowerTable<S> msPowers = makeMSPowerTable<S>();
+
+// These are accurate when the first bit represents the value 1, like numToBitPos() and bitPosToNum().
+// Only valid for values whose residue mod S is kept.
+template <int M, int S>
+inline uint64_t msPositionOf(uint64_t number) {
+	constexpr const struct msResidueTables<M, S> &t = msTables<M, S>;
+	return (number / S) * t.kept + t.rankOf[number % S] - t.rankOf[1 % S];
+}
+
+template <int M, int S>
+inline uint64_t msValueAt(uint64_t bitPos) {
+	constexpr const struct msResidueTables<M, S> &t = msTables<M, S>;
+	uint64_t blockPos = bitPos + t.rankOf[1 % S];
+	return (blockPos / t.kept) * S + t.residueAt[blockPos % t.kept];
+}
+
+// Puts bit i of x at bit M*i of out[0..M-1]. M = 2, 3 and 4 use the magic-mask spreads
+// (http://www.graphics.stanford.edu/~seander/bithacks.html#InterleaveBMN), anything else goes bit by bit.
+template <int M>
+inline void spreadBits(uint64_t x, uint64_t *out) {
+	for (int w = 0; w < M; w++) out[w] = 0;
+	while (x != 0) {
+		int i = __builtin_ctzll(x);
+		x &= x - 1;
+		out[(M * i) / CHUNK_BITS] |= 1ULL << ((M * i) % CHUNK_BITS);
+	}
+}
+
+inline uint64_t spread2Way_32bit(uint64_t x) {
+	x = (x | (x << 16)) & 0x0000FFFF0000FFFF;
+	x = (x | (x << 8 )) & 0x00FF00FF00FF00FF;
+	x = (x | (x << 4 )) & 0x0F0F0F0F0F0F0F0F;
+	x = (x | (x << 2 )) & 0x3333333333333333;
+	x = (x | (x << 1 )) & 0x5555555555555555;
+	return x;
+}
+
+// Bits 0 to 20 of x go to bits 0, 3, ..., 60
+inline uint64_t spread3Way_21bit(uint64_t x) {
+	x &= 0x1FFFFF;
+	x = (x | (x << 32)) & 0x001F00000000FFFF;
+	x = (x | (x << 16)) & 0x001F0000FF0000FF;
+	x = (x | (x << 8 )) & 0x100F00F00F00F00F;
+	x = (x | (x << 4 )) & 0x10C30C30C30C30C3;
+	x = (x | (x << 2 )) & 0x1249249249249249;
+	return x;
+}
+
+template <>
+inline void spreadBits<2>(uint64_t x, uint64_t *out) {
+	out[0] = spread2Way_32bit(x & 0x00000000FFFFFFFF);
+	out[1] = spread2Way_32bit(x >> 32);
+}
+
+template <>
+inline void spreadBits<3>(uint64_t x, uint64_t *out) {
+	// bits 0-21 land in word 0 (bit 21 at 63), 22-42 in word 1 from bit 2, 43-63 in word 2 from bit 1
+	out[0] = spread3Way_21bit(x) | (((x >> 21) & 1) << 63);
+	out[1] = spread3Way_21bit(x >> 22) << 2;
+	out[2] = spread3Way_21bit(x >> 43) << 1;
+}
+
+template <>
+inline void spreadBits<4>(uint64_t x, uint64_t *out) {
+	uint64_t low = spread2Way_32bit(x & 0x00000000FFFFFFFF);
+	uint64_t high = spread2Way_32bit(x >> 32);
+	out[0] = spread2Way_32bit(low & 0x00000000FFFFFFFF);
+	out[1] = spread2Way_32bit(low >> 32);
+	out[2] = spread2Way_32bit(high & 0x00000000FFFFFFFF);
+	out[3] = spread2Way_32bit(high >> 32);
+}
+
+// For each ON bit in col[sourceChunkNum], turns ON the bit representing M times its value, where
+// destination bit positions are offset by (64 * chunksAdjustment + bitsAdjustment). Writes to
+// at most col[M * sourceChunkNum + chunksAdjustment - 1] to M + 2 chunks after that.
+// phase = (64 * sourceChunkNum) % kept, and bitsAdjustment must be 0 to 63.
+template <int M, int S>
+inline void copyAlongToMultiplyCurrentPos(uint64_t *col, uint64_t sourceChunkNum, int phase, uint64_t chunksAdjustment, uint64_t bitsAdjustment) {
+	constexpr const struct msResidueTables<M, S> &t = msTables<M, S>;
+	static_assert(-t.minDelta < CHUNK_BITS && t.maxDelta < CHUNK_BITS, "multiplyDelta is too big to shift by, S is too large for this M");
+	
+	uint64_t spread[M];
+	spreadBits<M>(col[sourceChunkNum], spread);
+	
+	// out[0] is the chunk before M * sourceChunkNum, for bits nudged backwards
+	uint64_t out[M + 2] = {};
+	for (int g = 0; g < t.deltaGroups; g++) {
+		int delta = t.groupDelta[g];
+		for (int w = 0; w < M; w++) {
+			uint64_t part = spread[w] & t.spreadMasks[phase][g][w];
+			if (delta > 0) {
+				out[w + 1] |= part << delta;
+				out[w + 2] |= part >> (CHUNK_BITS - delta);
+			} else if (delta < 0) {
+				out[w + 1] |= part >> -delta;
+				out[w] |= part << (CHUNK_BITS + delta);
+			} else {
+				out[w + 1] |= part;
+			}
+		}
+	}
+	
+	// Only touch the chunks that can have bits in them. Often no bits are nudged backwards, e.g. for M = 2, S = 3.
+	constexpr int firstOut = t.minDelta < 0 ? 0 : 1;
+	constexpr int lastOut = t.maxDelta > 0 ? M + 1 : M;
+	
+	// (x >> 1) >> (63 - bitsAdjustment) is x >> (64 - bitsAdjustment), but still 0 when bitsAdjustment is 0
+	uint64_t *dest = col + M * sourceChunkNum + chunksAdjustment - 1;
+	uint64_t carry = 0;
+	for (int k = firstOut; k <= lastOut; k++) {
+		dest[k] |= (out[k] << bitsAdjustment) | carry;
+		carry = (out[k] >> 1) >> (CHUNK_BITS - 1 - bitsAdjustment);
+	}
+	dest[lastOut + 1] |= carry;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "ms-sweep.h"
+#include "residue-wheel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const int WORD_BITS = 64;
+
+const uint64_t MAX_SWEEP_Z = 1ULL << 40;
+
+// maxZ of the probe run each job's cost is estimated from
+const uint64_t SWEEP_PROBE_Z = 1 << 16;
+
+const uint64_t CSV_MODULI_LISTED = 8;
+
+struct sweepRun {
+	const vector<struct msSweepJob> *jobs;
+	struct msSweepConfig config;
+	vector<uint64_t> order; // job indices, most costly first
+	atomic<uint64_t> nextInOrder;
+	vector<struct msSweepRow> rows;
+	
+	// Indices of rows finished but not yet reported, & the first exception thrown in a worker
+	mutex finishedLock;
+	condition_variable rowFinished;
+	vector<uint64_t> finished;
+	exception_ptr error;
+	
+	sweepRun() : nextInOrder(0) {}
+};
+
+// Fills aggregate (maxZ / 64 + 1 words) with every value reachable up to maxZ, using column as
+// scratch of the same size. Returns the work done: words touched plus ON bits multiplied.
+static uint64_t runGeneralizedSieve(int m, int s, uint64_t maxZ, vector<uint64_t> &column, vector<uint64_t> &aggregate) {
+	uint64_t words = maxZ / WORD_BITS + 1;
+	column.assign(words, 0);
+	aggregate.assign(words, 0);
+	uint64_t lastBitsMask = (maxZ % WORD_BITS == WORD_BITS - 1) ? ~0ULL : (1ULL << (maxZ % WORD_BITS + 1)) - 1;
+	uint64_t maxToMultiply = maxZ / m;
+	uint64_t work = 0;
+	
+	// Column 0, every power of M
+	for (uint64_t value = 1; true; value *= m) {
+		column[value / WORD_BITS] |= 1ULL << (value % WORD_BITS);
+		if (value > maxToMultiply) break;
+	}
+	for (uint64_t i = 0; i < words; i++) {
+		aggregate[i] = column[i];
+	}
+	work += words;
+	
+	uint64_t power = 1;
+	uint64_t firstValue = 1; // 1 + S + ... + S^k, the smallest value in column k
+	while (power <= maxZ / s && power * s <= maxZ - firstValue) {
+		power *= s;
+		firstValue += power;
+		uint64_t firstWord = firstValue / WORD_BITS;
+		
+		// Adding S^k to every value, from the top down so it can be done in place
+		uint64_t wordShift = power / WORD_BITS;
+		int bitShift = power % WORD_BITS;
+		for (uint64_t i = words - 1; i >= firstWord && i >= wordShift; i--) {
+			uint64_t word = column[i - wordShift] << bitShift;
+			if (bitShift != 0 && i > wordShift) word |= column[i - wordShift - 1] >> (WORD_BITS - bitShift);
+			column[i] = word;
+			if (i == 0) break;
+		}
+		for (uint64_t i = 0; i < firstWord; i++) {
+			column[i] = 0;
+		}
+		column[words - 1] &= lastBitsMask;
+		
+		// Multiplying by M is always further along, so one sweep up picks up every multiple of a
+		// multiple. Bits set in the word being swept are picked up by rereading it.
+		uint64_t lastWordToMultiply = maxToMultiply / WORD_BITS;
+		for (uint64_t i = firstWord; i <= lastWordToMultiply; i++) {
+			uint64_t done = 0;
+			uint64_t word;
+			while ((word = column[i] & ~done) != 0) {
+				int bit = __builtin_ctzll(word);
+				done |= 1ULL << bit;
+				work++;
+				
+				uint64_t value = i * WORD_BITS + bit;
+				if (value > maxToMultiply) break;
+				uint64_t multiplied = value * m;
+				column[multiplied / WORD_BITS] |= 1ULL << (multiplied % WORD_BITS);
+			}
+		}
+		
+		for (uint64_t i = firstWord; i < words; i++) {
+			aggregate[i] |= column[i];
+		}
+		work += 2 * (words - firstWord);
+	}
+	
+	return work;
+}
+
+void findTrivialModuli(int m, int s, int maxModulus, vector<int> &moduli, vector<vector<bool>> &reachable) {
+	moduli.clear();
+	reachable.clear();
+	
+	bool *classes = new bool[maxModulus + 1];
+	for (int modulus = 2; modulus <= maxModulus; modulus++) {
+		findReachableResidues(m, s, modulus, classes);
+		
+		// Whether some class is never reached even though it is mod every divisor kept so far
+		bool explained = true;
+		for (int r = 0; r < modulus && explained; r++) {
+			if (classes[r]) continue;
+			
+			bool unreachableModDivisor = false;
+			for (uint64_t i = 0; i < moduli.size(); i++) {
+				if (modulus % moduli[i] == 0 && !reachable[i][r % moduli[i]]) unreachableModDivisor = true;
+			}
+			if (!unreachableModDivisor) explained = false;
+		}
+		if (explained) continue;
+		
+		moduli.push_back(modulus);
+		reachable.push_back(vector<bool>(classes, classes + modulus));
+	}
+	delete[] classes;
+}
+
+static void runSweepJob(struct sweepRun *run, uint64_t jobIndex, vector<uint64_t> &column, vector<uint64_t> &aggregate) {
+	const struct msSweepJob &job = (*run->jobs)[jobIndex];
+	struct msSweepRow &row = run->rows[jobIndex];
+	auto start = chrono::steady_clock::now();
+	
+	runGeneralizedSieve(job.m, job.s, job.maxZ, column, aggregate);
+	
+	vector<vector<bool>> reachableClasses;
+	findTrivialModuli(job.m, job.s, run->config.maxTrivialModulus, row.trivialModuli, reachableClasses);
+	
+	// The never reached classes of each modulus n, as a word for each phase (64 * word) % n, so the
+	// zeros in any of them can be masked out a word at a time
+	uint64_t moduliCount = row.trivialModuli.size();
+	vector<vector<uint64_t>> unreachableMasks(moduliCount);
+	vector<int> phases(moduliCount, 0);
+	for (uint64_t j = 0; j < moduliCount; j++) {
+		int modulus = row.trivialModuli[j];
+		unreachableMasks[j].assign(modulus, 0);
+		for (int phase = 0; phase < modulus; phase++) {
+			for (int bit = 0; bit < WORD_BITS; bit++) {
+				if (!reachableClasses[j][(phase + bit) % modulus]) unreachableMasks[j][phase] |= 1ULL << bit;
+			}
+		}
+	}
+	
+	row.zeroCount = 0;
+	row.trivialZeroCount = 0;
+	row.nonTrivialZeroCount = 0;
+	row.nonTrivialZeros.clear();
+	uint64_t lastWord = job.maxZ / WORD_BITS;
+	for (uint64_t i = 0; i <= lastWord; i++) {
+		uint64_t zeros = ~aggregate[i];
+		if (i == 0) zeros &= ~1ULL; // 0 isn't a value
+		if (i == lastWord && job.maxZ % WORD_BITS != WORD_BITS - 1) zeros &= (1ULL << (job.maxZ % WORD_BITS + 1)) - 1;
+		
+		uint64_t trivial = 0;
+		for (uint64_t j = 0; j < moduliCount; j++) {
+			trivial |= unreachableMasks[j][phases[j]];
+			phases[j] = (phases[j] + WORD_BITS) % row.trivialModuli[j];
+		}
+		
+		row.zeroCount += __builtin_popcountll(zeros);
+		row.trivialZeroCount += __builtin_popcountll(zeros & trivial);
+		uint64_t nonTrivial = zeros & ~trivial;
+		row.nonTrivialZeroCount += __builtin_popcountll(nonTrivial);
+		while (nonTrivial != 0 && row.nonTrivialZeros.size() < run->config.maxListedZeros) {
+			row.nonTrivialZeros.push_back(i * WORD_BITS + __builtin_ctzll(nonTrivial));
+			nonTrivial &= nonTrivial - 1;
+		}
+	}
+	row.zeroDensity = (double)row.zeroCount / job.maxZ;
+	
+	row.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void runSweepWorker(struct sweepRun *run) {
+	vector<uint64_t> column;
+	vector<uint64_t> aggregate;
+	
+	uint64_t next;
+	while ((next = run->nextInOrder++) < run->order.size()) {
+		uint64_t jobIndex = run->order[next];
+		try {
+			runSweepJob(run, jobIndex, column, aggregate);
+		} catch (...) {
+			// e.g. running out of memory. The rest of the jobs are left, as they'd likely fail too.
+			lock_guard<mutex> guard(run->finishedLock);
+			if (!run->error) run->error = current_exception();
+			run->nextInOrder = run->order.size();
+			run->rowFinished.notify_all();
+			return;
+		}
+		
+		lock_guard<mutex> guard(run->finishedLock);
+		run->finished.push_back(jobIndex);
+		run->rowFinished.notify_all();
+	}
+}
+
+struct msSweepConfig defaultMSSweepConfig() {
+	struct msSweepConfig config;
+	config.threads = max(1u, thread::hardware_concurrency());
+	config.maxTrivialModulus = 256;
+	config.maxListedZeros = 20;
+	return config;
+}
+
+vector<struct msSweepJob> makeMSSweepGrid(int maxM, int maxS, uint64_t maxZ) {
+	vector<struct msSweepJob> jobs;
+	for (int m = 2; m <= maxM; m++) {
+		for (int s = 2; s <= maxS; s++) {
+			jobs.push_back({ m, s, maxZ });
+		}
+	}
+	return jobs;
+}
+
+vector<struct msSweepRow> runMSSweep(const vector<struct msSweepJob> &jobs, struct msSweepConfig config, const struct msSweepCallbacks &callbacks) {
+	if (config.threads < 1) {
+		throw out_of_range("threads < 1");
+	}
+	if (config.maxTrivialModulus < 1) {
+		throw out_of_range("maxTrivialModulus < 1");
+	}
+	for (const struct msSweepJob &job : jobs) {
+		if (job.m < 2 || job.s < 2 || job.maxZ < 1 || job.maxZ > MAX_SWEEP_Z) {
+			throw out_of_range(
+				string("Error: the job M = ")
+				+ to_string(job.m)
+				+ ", S = "
+				+ to_string(job.s)
+				+ ", maxZ = "
+				+ to_string(job.maxZ)
+				+ " needs M and S of at least 2, and maxZ from 1 to 2^40."
+			);
+		}
+	}
+	
+	struct sweepRun run;
+	run.jobs = &jobs;
+	run.config = config;
+	run.rows.resize(jobs.size());
+	
+	// The work of a small run, scaled by how many more values and columns the real one has. Multiples
+	// of multiples make the work grow a little faster than that, but it's the order that matters.
+	vector<uint64_t> column;
+	vector<uint64_t> aggregate;
+	for (uint64_t i = 0; i < jobs.size(); i++) {
+		const struct msSweepJob &job = jobs[i];
+		uint64_t probeZ = min(job.maxZ, SWEEP_PROBE_Z);
+		double probeWork = runGeneralizedSieve(job.m, job.s, probeZ, column, aggregate);
+		double columnRatio = (log((double)job.maxZ) + 1) / (log((double)probeZ) + 1);
+		
+		run.rows[i].job = job;
+		run.rows[i].estimatedCost = probeWork * ((double)job.maxZ / probeZ) * columnRatio;
+		run.order.push_back(i);
+	}
+	stable_sort(run.order.begin(), run.order.end(), [&run](uint64_t a, uint64_t b) {
+		return run.rows[a].estimatedCost > run.rows[b].estimatedCost;
+	});
+	
+	int threads = min((uint64_t)config.threads, max((uint64_t)1, (uint64_t)jobs.size()));
+	vector<thread> workers;
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back(runSweepWorker, &run);
+	}
+	
+	// Report each row as it comes in
+	for (uint64_t reported = 0; reported < jobs.size(); reported++) {
+		uint64_t jobIndex;
+		{
+			unique_lock<mutex> guard(run.finishedLock);
+			run.rowFinished.wait(guard, [&run]() {
+				return !run.finished.empty() || run.error;
+			});
+			if (run.error) break;
+			jobIndex = run.finished.back();
+			run.finished.pop_back();
+		}
+		
+		if (callbacks.rowFinished) {
+			callbacks.rowFinished(run.rows[jobIndex]);
+		}
+	}
+	
+	for (thread &worker : workers) {
+		worker.join();
+	}
+	if (run.error) {
+		rethrow_exception(run.error);
+	}
+	
+	return run.rows;
+}
+
+string msSweepCsvHeader() {
+	return "M,S,maxZ,zeros,density,trivial moduli,trivial zeros,non-trivial zeros,first non-trivial zeros,seconds";
+}
+
+string msSweepCsvRow(const struct msSweepRow &row) {
+	// There can be dozens, e.g. for M = 2, S = 2, so only the smallest few are listed
+	string moduli;
+	for (uint64_t i = 0; i < row.trivialModuli.size() && i < CSV_MODULI_LISTED; i++) {
+		moduli += (i == 0 ? "" : " ") + to_string(row.trivialModuli[i]);
+	}
+	if (row.trivialModuli.size() > CSV_MODULI_LISTED) {
+		moduli += " (+" + to_string(row.trivialModuli.size() - CSV_MODULI_LISTED) + ")";
+	}
+	string zeros;
+	for (uint64_t i = 0; i < row.nonTrivialZeros.size(); i++) {
+		zeros += (i == 0 ? "" : " ") + to_string(row.nonTrivialZeros[i]);
+	}
+	
+	char density[32];
+	snprintf(density, sizeof(density), "%.6g", row.zeroDensity);
+	char seconds[32];
+	snprintf(seconds, sizeof(seconds), "%.3f", row.seconds);
+	
+	return to_string(row.job.m) + "," + to_string(row.job.s) + "," + to_string(row.job.maxZ) + ","
+		+ to_string(row.zeroCount) + "," + density + "," + moduli + ","
+		+ to_string(row.trivialZeroCount) + "," + to_string(row.nonTrivialZeroCount) + "," + zeros + ","
+		+ seconds;
+}
\ No newline at end of file
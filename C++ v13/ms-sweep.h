@@ -0,0 +1,74 @@
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef MS_SWEEP_H
+#define MS_SWEEP_H
+
+// Runs "multiply by M or add the next power of S" for a whole grid of (M, S) pairs, as
+// PrintBinaryDecisionZMSFinderResults() in the C# project does one at a time, summarising each.
+//
+// M and S are only known at run time, so rather than msColumnSieve<M, S> each job runs a sieve of
+// plain bits (bit v for the value v): column k (the values with S^k as the last power added) is
+// column k - 1 shifted S^k bits along, then swept once in increasing order to multiply every ON
+// bit by M, and ORed into the aggregate. Two bitmaps of maxZ bits, so 25MB for maxZ = 10^8.
+//
+// Jobs are handed out biggest first, by the cost of a small probe run scaled up to the job's maxZ,
+// so one slow pair isn't left to start last with every other thread idle.
+//
+// Some residue classes can never be reached, e.g. 5 mod 6 for M = 2, S = 2, so every zero in them
+// is trivial. These are found exactly, not guessed from the zeros as GetNonTrivialZeros() does,
+// by findReachableResidues() (see residue-wheel.h) for every modulus up to maxTrivialModulus: as
+// the powers of S are periodic mod n, there are at most n times that period states to follow.
+// Only the moduli whose unreachable classes aren't all explained by a smaller one are kept, and
+// each one's classes are turned into a mask per 64-bit word, so zeros are split a word at a time.
+
+struct msSweepJob {
+	int m;
+	int s;
+	uint64_t maxZ;
+};
+
+struct msSweepConfig {
+	int threads;
+	int maxTrivialModulus;
+	uint64_t maxListedZeros; // non-trivial zeros kept per row
+};
+
+struct msSweepRow {
+	struct msSweepJob job;
+	uint64_t zeroCount; // of 1 to maxZ
+	double zeroDensity; // zeroCount / maxZ
+	std::vector<int> trivialModuli; // that have classes that are never reached
+	uint64_t trivialZeroCount;
+	uint64_t nonTrivialZeroCount;
+	std::vector<uint64_t> nonTrivialZeros; // the first maxListedZeros of them
+	double estimatedCost; // relative to the other jobs
+	double seconds;
+};
+
+// Any of these can be left empty
+struct msSweepCallbacks {
+	// Called as each job finishes (so not in job order), from the thread that called runMSSweep()
+	std::function<void(const struct msSweepRow &row)> rowFinished;
+};
+
+struct msSweepConfig defaultMSSweepConfig();
+
+// Every M from 2 to maxM with every S from 2 to maxS
+std::vector<struct msSweepJob> makeMSSweepGrid(int maxM, int maxS, uint64_t maxZ);
+
+// Throws std::out_of_range for an M or S below 2, or a maxZ below 1 or past 2^40, before any job is
+// started. Returns a row per job, in job order.
+std::vector<struct msSweepRow> runMSSweep(const std::vector<struct msSweepJob> &jobs, struct msSweepConfig config, const struct msSweepCallbacks &callbacks);
+
+// The moduli from 2 to maxModulus with classes that are never reached, other than those explained
+// by a smaller modulus in the list, and for each, which classes can be reached
+void findTrivialModuli(int m, int s, int maxModulus, std::vector<int> &moduli, std::vector<std::vector<bool>> &reachable);
+
+// M,S,maxZ,zeros,density,trivial moduli,trivial zeros,non-trivial zeros,first non-trivial zeros,seconds
+std::string msSweepCsvHeader();
+std::string msSweepCsvRow(const struct msSweepRow &row);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "multi-source-sieve.h"
+#include "column-kernels.h"
+#include "math-utils.h"
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const uint64_t MAX_MULTI_SOURCE_VALUE = 1ULL << 62;
+const int MAX_SEED_POW = 39;
+
+// Where value is in a lane, in either layout
+static uint64_t valueToPos(const struct multiSourceSieve *sieve, uint64_t value) {
+	return sieve->storesMultiplesOf3 ? value - 1 : numToBitPos(value);
+}
+static uint64_t posToValue(const struct multiSourceSieve *sieve, uint64_t pos) {
+	return sieve->storesMultiplesOf3 ? pos + 1 : bitPosToNum(pos);
+}
+
+struct multiSourceSieve *createMultiSourceSieve(struct multiSourceSieveConfig config) {
+	if (config.maxValue < 1 || config.maxValue > MAX_MULTI_SOURCE_VALUE) {
+		throw out_of_range(
+			string("Error: max value '")
+			+ to_string(config.maxValue)
+			+ "' isn't between 1 and 2^62."
+		);
+	}
+	if (config.seeds.empty()) {
+		throw out_of_range("Error: there must be at least one seed.");
+	}
+	if (config.perSourceLabels && config.seeds.size() > MAX_LABELLED_SEEDS) {
+		throw out_of_range(
+			string("Error: ")
+			+ to_string(config.seeds.size())
+			+ " seeds can't each be labelled, the most is "
+			+ to_string(MAX_LABELLED_SEEDS)
+			+ "."
+		);
+	}
+	bool storesMultiplesOf3 = false;
+	for (const struct sieveSeed &seed : config.seeds) {
+		if (seed.value < 1 || seed.value > config.maxValue || seed.lastPow < 0 || seed.lastPow > MAX_SEED_POW) {
+			throw out_of_range(
+				string("Error: seed ")
+				+ to_string(seed.value)
+				+ ":"
+				+ to_string(seed.lastPow)
+				+ " needs a value between 1 and the max value, and a last power between 0 and "
+				+ to_string(MAX_SEED_POW)
+				+ "."
+			);
+		}
+		if (seed.value % 3 == 0) storesMultiplesOf3 = true;
+	}
+	
+	struct multiSourceSieve *sieve = new struct multiSourceSieve;
+	sieve->config = config;
+	sieve->storesMultiplesOf3 = storesMultiplesOf3;
+	sieve->lanes = config.perSourceLabels ? (int)config.seeds.size() : 1;
+	sieve->bitCount = valueToPos(sieve, config.maxValue) + 1;
+	sieve->chunksPerLane = (sieve->bitCount + CHUNK_BITS - 1) / CHUNK_BITS + 2;
+	try {
+		sieve->plane.assign(sieve->chunksPerLane * sieve->lanes, 0);
+		sieve->aggregate.assign(sieve->chunksPerLane * sieve->lanes, 0);
+	} catch (...) {
+		delete sieve;
+		throw;
+	}
+	sieve->stateCount = 0;
+	sieve->reachableCount = 0;
+	sieve->zeroCount = 0;
+	sieve->reachableCountPerSource.assign(config.perSourceLabels ? config.seeds.size() : 0, 0);
+	sieve->reachedByEverySource = 0;
+	sieve->planeCount = 0;
+	sieve->finished = false;
+	
+	return sieve;
+}
+
+void destroyMultiSourceSieve(struct multiSourceSieve *sieve) {
+	delete sieve;
+}
+
+// Clears every bit past bitCount, in every lane
+static void clearPastEnd(struct multiSourceSieve *sieve) {
+	uint64_t lanes = sieve->lanes;
+	uint64_t lastChunk = (sieve->bitCount - 1) / CHUNK_BITS;
+	uint64_t bitsLeft = sieve->bitCount % CHUNK_BITS;
+	if (bitsLeft != 0) {
+		for (uint64_t lane = 0; lane < lanes; lane++) {
+			sieve->plane[lastChunk * lanes + lane] &= (1ULL << bitsLeft) - 1;
+		}
+	}
+	fill(sieve->plane.begin() + (lastChunk + 1) * lanes, sieve->plane.end(), 0);
+}
+
+// Moves every bit of every lane shift bits along, returning whether any are left
+static bool shiftPlane(struct multiSourceSieve *sieve, uint64_t shift) {
+	if (shift >= sieve->bitCount) {
+		fill(sieve->plane.begin(), sieve->plane.end(), 0);
+		return false;
+	}
+	
+	uint64_t lanes = sieve->lanes;
+	uint64_t chunkShift = shift / CHUNK_BITS;
+	int bitShift = shift % CHUNK_BITS;
+	uint64_t lastChunk = (sieve->bitCount - 1) / CHUNK_BITS;
+	uint64_t *plane = sieve->plane.data();
+	
+	// Top down, so nothing's overwritten before it's moved
+	uint64_t any = 0;
+	for (uint64_t chunk = lastChunk + 1; chunk-- > chunkShift; ) {
+		uint64_t *to = plane + chunk * lanes;
+		const uint64_t *from = plane + (chunk - chunkShift) * lanes;
+		if (bitShift == 0) {
+			for (uint64_t lane = 0; lane < lanes; lane++) {
+				to[lane] = from[lane];
+				any |= to[lane];
+			}
+		} else if (chunk > chunkShift) {
+			for (uint64_t lane = 0; lane < lanes; lane++) {
+				to[lane] = (from[lane] << bitShift) | ((from - lanes)[lane] >> (CHUNK_BITS - bitShift));
+				any |= to[lane];
+			}
+		} else {
+			for (uint64_t lane = 0; lane < lanes; lane++) {
+				to[lane] = from[lane] << bitShift;
+				any |= to[lane];
+			}
+		}
+	}
+	fill(sieve->plane.begin(), sieve->plane.begin() + chunkShift * lanes, 0);
+	clearPastEnd(sieve);
+	
+	return any != 0;
+}
+
+// ORs the doubles of chunk's bits (in one lane) into chunks 2 * chunk and 2 * chunk + 1.
+// spreadBitsPaired_macro moves bits 2j & 2j + 1 to 4j & 4j + 1, so shifted up 1 that's exactly
+// doubling in the column sieve's layout (3j + 1 to 6j + 2, 3j + 2 to 6j + 4). In the plain layout
+// (bit p being p + 1), bit p doubles to 2p + 1, so the second of each pair moves up 1 more.
+template <bool storesMultiplesOf3>
+static inline void doubleChunk(uint64_t *plane, uint64_t lanes, uint64_t chunk, uint64_t lane) {
+	uint64_t spread1 = 0;
+	uint64_t spread2 = 0;
+	
+	spreadBitsPaired_macro(plane[chunk * lanes + lane], spread1, spread2);
+	
+	if (storesMultiplesOf3) {
+		spread1 = ((spread1 & 0x1111111111111111) << 1) | ((spread1 & 0x2222222222222222) << 2);
+		spread2 = ((spread2 & 0x1111111111111111) << 1) | ((spread2 & 0x2222222222222222) << 2);
+	} else {
+		spread1 <<= 1;
+		spread2 <<= 1;
+	}
+	
+	plane[(chunk << 1) * lanes + lane] |= spread1;
+	plane[((chunk << 1) + 1) * lanes + lane] |= spread2;
+}
+
+// Adds every chain of doublings to the plane, in one increasing sweep. Only chunk 0 doubles into
+// itself, so it's repeated until nothing changes; every other chunk's doubles are further along.
+template <bool storesMultiplesOf3>
+static void doublePlane(struct multiSourceSieve *sieve) {
+	uint64_t maxToDouble = sieve->config.maxValue / 2;
+	if (maxToDouble < 1) return;
+	
+	uint64_t lanes = sieve->lanes;
+	uint64_t *plane = sieve->plane.data();
+	uint64_t lastChunkToDouble = valueToPos(sieve, maxToDouble) / CHUNK_BITS;
+	
+	for (uint64_t lane = 0; lane < lanes; lane++) {
+		uint64_t before;
+		do {
+			before = plane[lane];
+			doubleChunk<storesMultiplesOf3>(plane, lanes, 0, lane);
+		} while (plane[lane] != before);
+	}
+	for (uint64_t chunk = 1; chunk <= lastChunkToDouble; chunk++) {
+		for (uint64_t lane = 0; lane < lanes; lane++) {
+			doubleChunk<storesMultiplesOf3>(plane, lanes, chunk, lane);
+		}
+	}
+	
+	// Doubles of values past maxToDouble are past the max
+	clearPastEnd(sieve);
+}
+
+// ORs the plane into the aggregate, returning the number of states in it
+static uint64_t aggregatePlane(struct multiSourceSieve *sieve) {
+	uint64_t states = 0;
+	for (uint64_t i = 0; i < sieve->plane.size(); i++) {
+		sieve->aggregate[i] |= sieve->plane[i];
+		states += __builtin_popcountll(sieve->plane[i]);
+	}
+	return states;
+}
+
+// Bit i set for each lane with bit bitInChunk set in chunk
+static uint64_t gatherLanes(const struct multiSourceSieve *sieve, uint64_t chunk, int bitInChunk) {
+	uint64_t sources = 0;
+	const uint64_t *chunks = sieve->aggregate.data() + chunk * sieve->lanes;
+	for (int lane = 0; lane < sieve->lanes; lane++) {
+		sources |= ((chunks[lane] >> bitInChunk) & 1) << lane;
+	}
+	return sources;
+}
+
+void runMultiSourceSieve(struct multiSourceSieve *sieve, const struct multiSourceSieveCallbacks &callbacks) {
+	if (sieve->finished) {
+		throw logic_error("Error: runMultiSourceSieve() has already been run on this sieve");
+	}
+	
+	const vector<struct sieveSeed> &seeds = sieve->config.seeds;
+	uint64_t lanes = sieve->lanes;
+	int maxSeedPow = 0;
+	for (const struct sieveSeed &seed : seeds) {
+		maxSeedPow = max(maxSeedPow, seed.lastPow);
+	}
+	
+	for (int powOf3 = 0; true; powOf3++) {
+		// Plane k - 1 with 3^k added to every state. Adding 3^k to a value that isn't a multiple of 3
+		// moves it 2 * 3^(k - 1) bits along in the column sieve's layout.
+		bool any = false;
+		if (powOf3 > 0) {
+			uint64_t shift;
+			if (powOf3 > MAX_SEED_POW || threeToThe(powOf3) >= sieve->config.maxValue) {
+				shift = sieve->bitCount;
+			} else {
+				shift = sieve->storesMultiplesOf3 ? threeToThe(powOf3) : 2 * threeToThe(powOf3 - 1);
+			}
+			any = shiftPlane(sieve, shift);
+		}
+		
+		for (uint64_t i = 0; i < seeds.size(); i++) {
+			if (seeds[i].lastPow != powOf3) continue;
+			uint64_t pos = valueToPos(sieve, seeds[i].value);
+			uint64_t lane = sieve->config.perSourceLabels ? i : 0;
+			sieve->plane[(pos / CHUNK_BITS) * lanes + lane] |= 1ULL << (pos % CHUNK_BITS);
+			any = true;
+		}
+		
+		if (!any) {
+			if (powOf3 >= maxSeedPow) break;
+			continue;
+		}
+		
+		if (sieve->storesMultiplesOf3) {
+			doublePlane<true>(sieve);
+		} else {
+			doublePlane<false>(sieve);
+		}
+		
+		uint64_t states = aggregatePlane(sieve);
+		sieve->stateCount += states;
+		sieve->planeCount = powOf3 + 1;
+		if (callbacks.planeFinished) {
+			callbacks.planeFinished(powOf3, states);
+		}
+	}
+	
+	// Go through the aggregate, counting & reporting
+	uint64_t lastChunk = (sieve->bitCount - 1) / CHUNK_BITS;
+	uint64_t bitsLeft = sieve->bitCount % CHUNK_BITS;
+	for (uint64_t chunk = 0; chunk <= lastChunk; chunk++) {
+		const uint64_t *chunks = sieve->aggregate.data() + chunk * lanes;
+		uint64_t reached = 0;
+		uint64_t reachedByEvery = ~0ULL;
+		for (uint64_t lane = 0; lane < lanes; lane++) {
+			reached |= chunks[lane];
+			reachedByEvery &= chunks[lane];
+			if (sieve->config.perSourceLabels) {
+				sieve->reachableCountPerSource[lane] += __builtin_popcountll(chunks[lane]);
+			}
+		}
+		uint64_t stored = (chunk == lastChunk && bitsLeft != 0) ? (1ULL << bitsLeft) - 1 : ~0ULL;
+		
+		sieve->reachableCount += __builtin_popcountll(reached);
+		sieve->zeroCount += __builtin_popcountll(~reached & stored);
+		if (sieve->config.perSourceLabels) {
+			sieve->reachedByEverySource += __builtin_popcountll(reachedByEvery);
+		}
+		
+		if (callbacks.reachableFound) {
+			for (uint64_t word = reached; word != 0; word &= word - 1) {
+				int bit = __builtin_ctzll(word);
+				uint64_t sources = sieve->config.perSourceLabels ? gatherLanes(sieve, chunk, bit) : 1;
+				callbacks.reachableFound(posToValue(sieve, chunk * CHUNK_BITS + bit), sources);
+			}
+		}
+		if (callbacks.zeroFound) {
+			for (uint64_t word = ~reached & stored; word != 0; word &= word - 1) {
+				callbacks.zeroFound(posToValue(sieve, chunk * CHUNK_BITS + __builtin_ctzll(word)));
+			}
+		}
+	}
+	
+	sieve->finished = true;
+}
+
+uint64_t multiSourceReachedBy(const struct multiSourceSieve *sieve, uint64_t value) {
+	if (value < 1 || value > sieve->config.maxValue) return 0;
+	if (!sieve->storesMultiplesOf3 && value % 3 == 0) return 0;
+	
+	uint64_t pos = valueToPos(sieve, value);
+	uint64_t sources = gatherLanes(sieve, pos / CHUNK_BITS, pos % CHUNK_BITS);
+	return sieve->config.perSourceLabels ? sources : (sources != 0 ? 1 : 0);
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#ifndef MULTI_SOURCE_SIEVE_H
+#define MULTI_SOURCE_SIEVE_H
+
+// Everything reachable up to a max from a set of starting states rather than just (1, 3^0), as the
+// Prolog's reachableFrom(M, S, Num, LastAddedPow, Start, StartPrevPow) does for one start at a
+// time. A seed (value, lastPow) can double, or add 3^(lastPow + 1) next, so (1, 0) is the usual
+// problem.
+//
+// The column sieve's columns are relative to 1 + 3 + ... + 3^k, which a seed's states can be far
+// below, so this keeps planes of bits from the value 1 up instead, like state-graph-exporter.cpp:
+// plane k holds every state with 3^k as the last power added, and is plane k - 1 shifted along
+// by the bits for 3^k, plus the seeds with lastPow k, then doubled in one increasing sweep (a
+// chunk at a time with spreadBitsPaired_macro, as every chunk's doubles land in chunks after it),
+// and ORed into the aggregate. All the seeds go through the same sweeps, so adding seeds doesn't
+// add passes over memory.
+//
+// With perSourceLabels, each seed gets its own lane of bits, and the lanes are interleaved a
+// 64-bit chunk at a time (chunk c of lane l at c * lanes + l), so every step still runs through
+// memory once, touching each lane's chunk together. That's a bitmask of the seeds reaching each
+// value, at 2 bits per value per seed.
+//
+// Multiples of 3 are only reached from seeds that are multiples of 3 (adding a power of 3 keeps
+// the residue mod 3, and doubling swaps 1 & 2), so they're omitted as in the column sieve unless a
+// seed is one, in which case the planes have a bit for every value. Memory is 2 bits per stored
+// value per lane, so 2 * max / 3 bits for the usual layout.
+
+struct sieveSeed {
+	uint64_t value;
+	int lastPow; // 3^lastPow was the last power added, so 3^(lastPow + 1) is next
+};
+
+struct multiSourceSieveConfig {
+	uint64_t maxValue;
+	std::vector<struct sieveSeed> seeds;
+	bool perSourceLabels; // at most MAX_LABELLED_SEEDS seeds
+};
+
+const int MAX_LABELLED_SEEDS = 64;
+
+// Any of these can be left empty
+struct multiSourceSieveCallbacks {
+	// Called for each reachable value, in increasing order, with bit i set for each seeds[i] that
+	// reaches it, or just 1 without perSourceLabels
+	std::function<void(uint64_t value, uint64_t sources)> reachableFound;
+	
+	// Called for each value that isn't reached, in increasing order, other than multiples of 3
+	// when they aren't stored
+	std::function<void(uint64_t value)> zeroFound;
+	
+	// Called after plane k is made and aggregated, with the number of states in it (over every lane)
+	std::function<void(int powOf3, uint64_t states)> planeFinished;
+};
+
+struct multiSourceSieve {
+	struct multiSourceSieveConfig config;
+	bool storesMultiplesOf3;
+	int lanes; // 1, or one per seed with perSourceLabels
+	uint64_t bitCount; // per lane
+	uint64_t chunksPerLane; // including 2 chunks past bitCount, for the doubling sweep to spill into
+	std::vector<uint64_t> plane;
+	std::vector<uint64_t> aggregate;
+	
+	// Filled by runMultiSourceSieve()
+	uint64_t stateCount; // over every plane and lane
+	uint64_t reachableCount;
+	uint64_t zeroCount; // of the values stored
+	std::vector<uint64_t> reachableCountPerSource; // with perSourceLabels
+	uint64_t reachedByEverySource; // with perSourceLabels
+	int planeCount;
+	bool finished;
+};
+
+// Throws std::out_of_range for a max value below 1 or past 2^62, no seeds, a seed outside 1 to max
+// or with a lastPow outside 0 to 39, or more than MAX_LABELLED_SEEDS seeds with perSourceLabels.
+// The planes are allocated here, so it can also throw std::bad_alloc.
+struct multiSourceSieve *createMultiSourceSieve(struct multiSourceSieveConfig config);
+void runMultiSourceSieve(struct multiSourceSieve *sieve, const struct multiSourceSieveCallbacks &callbacks);
+void destroyMultiSourceSieve(struct multiSourceSieve *sieve);
+
+// Bit i set for each seeds[i] that reaches value, after runMultiSourceSieve(), or 1 / 0 without
+// perSourceLabels. 0 for values past the max or that aren't stored.
+uint64_t multiSourceReachedBy(const struct multiSourceSieve *sieve, uint64_t value);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include "math-utils.h"
+#include "column-kernels.h"
+#include "path-count-sieve.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+
+using namespace std;
+
+// Lanes are added this many at a time, and only kept if none of them overflowed
+const uint64_t BLOCK_LANES = 4096;
+
+template <typename T>
+static void *newLanes(uint64_t count) {
+	return new T[count]();
+}
+
+static void *newLanes(int laneBytes, uint64_t count) {
+	switch (laneBytes) {
+		case 1: return newLanes<uint8_t>(count);
+		case 2: return newLanes<uint16_t>(count);
+		case 4: return newLanes<uint32_t>(count);
+		default: return newLanes<uint64_t>(count);
+	}
+}
+
+static void deleteLanes(void *lanes, int laneBytes) {
+	switch (laneBytes) {
+		case 1: delete[] (uint8_t *)lanes; break;
+		case 2: delete[] (uint16_t *)lanes; break;
+		case 4: delete[] (uint32_t *)lanes; break;
+		default: delete[] (uint64_t *)lanes; break;
+	}
+}
+
+template <typename From, typename To>
+static void *widenLanes(void *lanes, uint64_t count) {
+	const From *from = (const From *)lanes;
+	To *to = new To[count];
+	for (uint64_t i = 0; i < count; i++) {
+		to[i] = from[i];
+	}
+	delete[] from;
+	return to;
+}
+
+static void widenLanes(struct pathCountSieve *sieve) {
+	uint64_t count = sieve->config.colLength * CHUNK_BITS;
+	switch (sieve->laneBytes) {
+		case 1:
+			sieve->colCounts = widenLanes<uint8_t, uint16_t>(sieve->colCounts, count);
+			sieve->aggregateCounts = widenLanes<uint8_t, uint16_t>(sieve->aggregateCounts, count);
+			break;
+		case 2:
+			sieve->colCounts = widenLanes<uint16_t, uint32_t>(sieve->colCounts, count);
+			sieve->aggregateCounts = widenLanes<uint16_t, uint32_t>(sieve->aggregateCounts, count);
+			break;
+		case 4:
+			sieve->colCounts = widenLanes<uint32_t, uint64_t>(sieve->colCounts, count);
+			sieve->aggregateCounts = widenLanes<uint32_t, uint64_t>(sieve->aggregateCounts, count);
+			break;
+		default:
+			throw overflow_error("Error: a path count doesn't fit in 64 bits");
+	}
+	sieve->laneBytes *= 2;
+}
+
+// Doubles col[first..end) along the column and adds it into the aggregate, where both destinations
+// are `adjustment` lanes along, & nothing at or beyond lastPos is needed. Lane p doubles to lane
+// 2p + 1 if p is even, or 2p if it's odd (see copyAlongToDoubleCurrentPos_macro).
+//
+// As long as end <= 2 * first (or it's the single lane 0), the destinations never overlap the block.
+// If any lane overflows, the block is subtracted back out and false returned, so it can be redone
+// with wider lanes.
+template <typename T>
+static bool addColumnBlock(T *col, T *aggregate, uint64_t first, uint64_t end, uint64_t adjustment, uint64_t lastPos) {
+	const T *__restrict src = col;
+	T *__restrict doubled = col + adjustment;
+	T *__restrict aggregated = aggregate + adjustment;
+	
+	// Lanes from doubleEnd on double to at or beyond lastPos
+	uint64_t doubleEnd = first;
+	if (lastPos > adjustment) {
+		uint64_t destLimit = lastPos - adjustment;
+		doubleEnd = max(first, min(end, destLimit / 2));
+		if (doubleEnd < end && 2 * doubleEnd + 1 - (doubleEnd & 1) < destLimit) doubleEnd++;
+	}
+	
+	// Even lanes first & last, so the middle can go in pairs, 2j -> 4j + 1 & 2j + 1 -> 4j + 2
+	uint64_t pairsStart = min(doubleEnd, first + (first & 1));
+	uint64_t pairsEnd = max(pairsStart, doubleEnd - (doubleEnd & 1));
+	
+	#define addLanes(dest, source) { \
+		T sum = (T)((dest) + (source)); \
+		overflowed |= sum < (source); \
+		(dest) = sum; \
+	}
+	
+	#define subtractLanes(dest, source) { \
+		(dest) = (T)((dest) - (source)); \
+	}
+	
+	#define forEachLane(op) { \
+		for (uint64_t p = first; p < pairsStart; p++) { \
+			op(doubled[2 * p + 1 - (p & 1)], src[p]); \
+		} \
+		for (uint64_t p = pairsStart; p < pairsEnd; p += 2) { \
+			op(doubled[2 * p + 1], src[p]); \
+			op(doubled[2 * p + 2], src[p + 1]); \
+		} \
+		for (uint64_t p = pairsEnd; p < doubleEnd; p++) { \
+			op(doubled[2 * p + 1 - (p & 1)], src[p]); \
+		} \
+		for (uint64_t p = first; p < end; p++) { \
+			op(aggregated[p], src[p]); \
+		} \
+	}
+	
+	bool overflowed = false;
+	forEachLane(addLanes);
+	if (overflowed) {
+		forEachLane(subtractLanes);
+	}
+	
+	#undef addLanes
+	#undef subtractLanes
+	#undef forEachLane
+	
+	return !overflowed;
+}
+
+static bool addColumnBlock(struct pathCountSieve *sieve, uint64_t first, uint64_t end, uint64_t adjustment, uint64_t lastPos) {
+	switch (sieve->laneBytes) {
+		case 1: return addColumnBlock<uint8_t>((uint8_t *)sieve->colCounts, (uint8_t *)sieve->aggregateCounts, first, end, adjustment, lastPos);
+		case 2: return addColumnBlock<uint16_t>((uint16_t *)sieve->colCounts, (uint16_t *)sieve->aggregateCounts, first, end, adjustment, lastPos);
+		case 4: return addColumnBlock<uint32_t>((uint32_t *)sieve->colCounts, (uint32_t *)sieve->aggregateCounts, first, end, adjustment, lastPos);
+		default: return addColumnBlock<uint64_t>((uint64_t *)sieve->colCounts, (uint64_t *)sieve->aggregateCounts, first, end, adjustment, lastPos);
+	}
+}
+
+template <typename T>
+static void reportFinalCounts(struct pathCountSieve *sieve, uint64_t first, uint64_t end, ofstream &countsFile, const struct pathCountCallbacks &callbacks) {
+	const T *aggregate = (const T *)sieve->aggregateCounts;
+	vector<uint64_t> &histogram = sieve->histogram;
+	
+	for (uint64_t i = first; i < end; i++) {
+		uint64_t count = aggregate[i];
+		if (count >= histogram.size()) histogram.resize(count + 1, 0);
+		histogram[count]++;
+		
+		if (count == 1) {
+			sieve->singlePathValues.push_back(bitPosToNum(i));
+			if (callbacks.singlePathFound) callbacks.singlePathFound(bitPosToNum(i));
+		}
+	}
+	
+	if (countsFile.is_open()) {
+		struct pathCountSegmentHeader header;
+		header.firstBitPos = first;
+		header.count = end - first;
+		header.laneBytes = sizeof(T);
+		countsFile.write((const char *)&header, sizeof(header));
+		countsFile.write((const char *)(aggregate + first), (end - first) * sizeof(T));
+	}
+}
+
+static void reportFinalCounts(struct pathCountSieve *sieve, uint64_t first, uint64_t end, ofstream &countsFile, const struct pathCountCallbacks &callbacks) {
+	if (first >= end) return;
+	
+	switch (sieve->laneBytes) {
+		case 1: reportFinalCounts<uint8_t>(sieve, first, end, countsFile, callbacks); break;
+		case 2: reportFinalCounts<uint16_t>(sieve, first, end, countsFile, callbacks); break;
+		case 4: reportFinalCounts<uint32_t>(sieve, first, end, countsFile, callbacks); break;
+		default: reportFinalCounts<uint64_t>(sieve, first, end, countsFile, callbacks); break;
+	}
+}
+
+struct pathCountSieve *createPathCountSieve(struct pathCountSieveConfig config) {
+	if (config.colLength < 1) {
+		throw out_of_range("colLength < 1");
+	}
+	
+	struct pathCountSieve *sieve = new struct pathCountSieve;
+	sieve->config = config;
+	sieve->maxValueRepresentable = bitPosToNum(config.colLength * CHUNK_BITS - 1);
+	sieve->laneBytes = 1;
+	sieve->colCounts = newLanes(sieve->laneBytes, config.colLength * CHUNK_BITS);
+	sieve->aggregateCounts = newLanes(sieve->laneBytes, config.colLength * CHUNK_BITS);
+	sieve->finished = false;
+	
+	return sieve;
+}
+
+void destroyPathCountSieve(struct pathCountSieve *sieve) {
+	if (sieve == nullptr) return;
+	
+	deleteLanes(sieve->colCounts, sieve->laneBytes);
+	deleteLanes(sieve->aggregateCounts, sieve->laneBytes);
+	delete sieve;
+}
+
+uint64_t getPathCount(const struct pathCountSieve *sieve, uint64_t value) {
+	if (!sieve->finished) {
+		throw logic_error("Error: the counts aren't final until runPathCountSieve() has returned");
+	}
+	if (value > sieve->maxValueRepresentable) {
+		throw out_of_range(
+			string("Error: value '")
+			+ to_string(value)
+			+ "' is beyond the max value stored '"
+			+ to_string(sieve->maxValueRepresentable)
+			+ "'."
+		);
+	}
+	if (value == 0 || value % 3 == 0) return 0;
+	
+	uint64_t bitPos = numToBitPos(value);
+	switch (sieve->laneBytes) {
+		case 1: return ((const uint8_t *)sieve->aggregateCounts)[bitPos];
+		case 2: return ((const uint16_t *)sieve->aggregateCounts)[bitPos];
+		case 4: return ((const uint32_t *)sieve->aggregateCounts)[bitPos];
+		default: return ((const uint64_t *)sieve->aggregateCounts)[bitPos];
+	}
+}
+
+void runPathCountSieve(struct pathCountSieve *sieve, const struct pathCountCallbacks &callbacks) {
+	if (sieve->finished) {
+		throw logic_error("Error: runPathCountSieve() has already been run on this sieve");
+	}
+	
+	ofstream countsFile;
+	if (!sieve->config.countsFilePath.empty()) {
+		countsFile.open(sieve->config.countsFilePath, ios::binary | ios::trunc);
+		if (!countsFile.is_open()) {
+			throw runtime_error("Error: couldn't open '" + sieve->config.countsFilePath + "' to write the counts to");
+		}
+	}
+	
+	uint64_t colPositions = sieve->config.colLength * CHUNK_BITS;
+	uint64_t maxValueRepresentable = sieve->maxValueRepresentable;
+	
+	// Setup column 0, i.e. 1 path to every power of 2. Nothing can overflow yet, so 8-bit lanes.
+	uint8_t *col = (uint8_t *)sieve->colCounts;
+	uint8_t *aggregate = (uint8_t *)sieve->aggregateCounts;
+	for (uint64_t i = 1; i <= maxValueRepresentable; i *= 2) {
+		col[numToBitPos(i)] = 1;
+		aggregate[numToBitPos(i)] = 1;
+		
+		if (i > maxValueRepresentable / 2) break;
+	}
+	
+	// lanes of the aggregate before this have been reported
+	uint64_t reportedUpTo = 0;
+	
+	uint64_t firstValueRepresented = 1;
+	for (int powOf3 = 1; powOf3 < 40; powOf3++) {
+		if (threeToThe(powOf3) > maxValueRepresentable) break;
+		
+		// Everything below this column's first value is final
+		firstValueRepresented += threeToThe(powOf3);
+		uint64_t adjustment = firstValueRepresented > maxValueRepresentable ? colPositions : numToBitPos(firstValueRepresented);
+		reportFinalCounts(sieve, reportedUpTo, adjustment, countsFile, callbacks);
+		reportedUpTo = adjustment;
+		
+		if (firstValueRepresented > maxValueRepresentable) break;
+		
+		// Column lane p represents firstValueRepresented - 1 + bitPosToNum(p), so it goes `adjustment`
+		// lanes along in the aggregate, & doubles to the same adjustment plus where bitPosToNum(p) doubles to.
+		// Lanes beyond lastPos are past the end of the aggregate, and as later columns start later still,
+		// nothing will ever need them.
+		uint64_t lastPos = colPositions - adjustment;
+		
+		uint64_t first = 0;
+		while (first < lastPos) {
+			uint64_t end = min(lastPos, first + min(BLOCK_LANES, max((uint64_t)1, first)));
+			if (!addColumnBlock(sieve, first, end, adjustment, lastPos)) {
+				widenLanes(sieve);
+				if (callbacks.lanesWidened) callbacks.lanesWidened(sieve->laneBytes);
+				continue;
+			}
+			first = end;
+		}
+		
+		if (callbacks.columnFinished) {
+			callbacks.columnFinished(powOf3, firstValueRepresented);
+		}
+	}
+	
+	// Nothing further can be reached, so the rest of the aggregate is final too
+	reportFinalCounts(sieve, reportedUpTo, colPositions, countsFile, callbacks);
+	
+	sieve->finished = true;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef PATH_COUNT_SIEVE_H
+#define PATH_COUNT_SIEVE_H
+
+// The v12 column engine, but counting the decision sequences that reach each value rather than
+// just whether there's one, i.e. the 1, 1, 0, 2, 1, 0, ... sequence from
+// TwoThreeDecisionZFinder.GetExpansionCounts_twoThreeDecisions() in the C# project.
+//
+// Same layout as struct columnSieve, with a lane per value instead of a bit (multiples of 3 are
+// left out, as they always have 0 paths). Counts start out as 8-bit lanes, and when an addition
+// overflows the whole column & aggregate are widened to 16, 32 and then 64 bits. Columns are
+// added in blocks of plain loops over the lanes, which -Ofast vectorises.
+
+struct pathCountSieveConfig {
+	uint64_t colLength; // measured in CHUNK_BITS-long chunks, like columnSieveConfig, so there's colLength * 64 lanes per array
+	
+	// If not empty, the counts are written here as they become final, as a series of segments. Each is
+	// a pathCountSegmentHeader followed by `count` little-endian counts `laneBytes` bytes each, for the
+	// values bitPosToNum(firstBitPos) onwards.
+	std::string countsFilePath;
+};
+
+struct pathCountSegmentHeader {
+	uint64_t firstBitPos;
+	uint64_t count;
+	uint64_t laneBytes;
+};
+
+// Any of these can be left empty
+struct pathCountCallbacks {
+	// Called once for each value with exactly one path, in increasing order, as soon as it's final
+	std::function<void(uint64_t value)> singlePathFound;
+	
+	// Called after the column for shift of 3^powOf3 has been added into the aggregate
+	std::function<void(int powOf3, uint64_t firstValueRepresented)> columnFinished;
+	
+	// Called when the lanes have just been widened to laneBytes bytes
+	std::function<void(int laneBytes)> lanesWidened;
+};
+
+struct pathCountSieve {
+	struct pathCountSieveConfig config;
+	uint64_t maxValueRepresentable;
+	int laneBytes;
+	void *colCounts; // laneBytes-wide unsigned ints
+	void *aggregateCounts;
+	bool finished;
+	
+	// Filled in as counts become final. histogram[c] is how many values (excluding multiples of 3)
+	// have exactly c paths.
+	std::vector<uint64_t> histogram;
+	std::vector<uint64_t> singlePathValues;
+};
+
+struct pathCountSieve *createPathCountSieve(struct pathCountSieveConfig config);
+void runPathCountSieve(struct pathCountSieve *sieve, const struct pathCountCallbacks &callbacks);
+void destroyPathCountSieve(struct pathCountSieve *sieve);
+
+// Only valid after runPathCountSieve() has returned. 0 for multiples of 3.
+uint64_t getPathCount(const struct pathCountSieve *sieve, uint64_t value);
+
+#endif
\ No newline at end of file
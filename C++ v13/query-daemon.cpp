@@ -0,0 +1,321 @@
+#include "math-utils.h"
+#include "backward-path-count.h"
+#include "backward-search.h"
+#include "bit-view.h"
+#include "query-daemon.h"
+#include "result-set.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+// A client that sends more than this without a newline is cut off
+const uint64_t MAX_REQUEST_BYTES = 1 << 20;
+
+const int RECEIVE_BUFFER_BYTES = 1 << 16;
+
+struct queryClient {
+	int fd;
+	string received; // not yet answered, as there's no newline after it yet
+	string toSend;
+	bool doneReceiving; // the client has shut down its side (or been cut off), so it's only sent to
+};
+
+static bool isReachableAnswer(struct queryDaemon *daemon, uint128_t value) {
+	if (value <= daemon->results->aggregate.maxValue) {
+		return isReachable(&daemon->results->aggregate, (uint64_t)value);
+	}
+	
+	daemon->fallbacks++;
+	return isReachableBackward(daemon->search, value);
+}
+
+static string nextZeroAnswer(struct queryDaemon *daemon, uint128_t value) {
+	uint64_t maxValue = daemon->results->aggregate.maxValue;
+	if (value < maxValue) {
+		uint64_t zero = getNextStoredZero(daemon->results, (uint64_t)value);
+		if (zero != 0) return to_string(zero);
+	}
+	
+	daemon->fallbacks++;
+	if (value == ~(uint128_t)0) return "none";
+	uint128_t first = max(value, (uint128_t)maxValue) + 1;
+	uint128_t last = first + daemon->config.maxFallbackScan - 1;
+	if (last < first) last = ~(uint128_t)0;
+	
+	// Scans that start where the last one left off are remembered, so asking again is free
+	if (daemon->fallbackZero >= first) {
+		return daemon->fallbackZero <= last ? uint128ToString(daemon->fallbackZero) : "none";
+	}
+	bool extendsScanned = daemon->fallbackZero == 0 && first <= daemon->fallbackScannedTo + 1;
+	if (extendsScanned) {
+		if (last <= daemon->fallbackScannedTo) return "none";
+		first = daemon->fallbackScannedTo + 1;
+	}
+	
+	for (uint128_t candidate = first; candidate <= last && candidate != 0; candidate++) {
+		bool zero = candidate % 3 != 0 && !isReachableBackward(daemon->search, candidate);
+		if (extendsScanned) {
+			daemon->fallbackScannedTo = candidate;
+			if (zero) daemon->fallbackZero = candidate;
+		}
+		if (zero) return uint128ToString(candidate);
+	}
+	return "none";
+}
+
+static string pathCountAnswer(struct queryDaemon *daemon, uint128_t value) {
+	const struct resultSet *results = daemon->results;
+	if (value <= results->header->countsMaxValue) {
+		return to_string(getStoredPathCount(results, (uint64_t)value));
+	}
+	
+	// A zero has no paths, and it's far quicker to look that up than to count them
+	if (value <= results->aggregate.maxValue && !isReachable(&results->aggregate, (uint64_t)value)) {
+		return "0";
+	}
+	
+	daemon->fallbacks++;
+	return uint128ToString(countPathsBackward(daemon->counter, value));
+}
+
+string answerQuery(struct queryDaemon *daemon, const string &request) {
+	istringstream words(request);
+	string command;
+	words >> command;
+	
+	if (command == "info") {
+		const struct resultSetHeader *header = daemon->results->header;
+		daemon->requestsAnswered++;
+		return "ok " + to_string(header->maxValue) + " " + to_string(header->countsMaxValue) + " " + to_string(header->zeroCount);
+	}
+	if (command != "reachable" && command != "next" && command != "paths") {
+		return "error unknown command '" + command + "'";
+	}
+	
+	vector<uint128_t> values;
+	string word;
+	while (words >> word) {
+		uint128_t value;
+		if (!parseUInt128(word.c_str(), &value)) {
+			return "error '" + word + "' isn't a whole number below 2^128";
+		}
+		values.push_back(value);
+	}
+	if (values.empty()) {
+		return "error no values given";
+	}
+	
+	string response = "ok";
+	try {
+		for (uint128_t value : values) {
+			if (command == "reachable") {
+				response += isReachableAnswer(daemon, value) ? " 1" : " 0";
+			} else if (command == "next") {
+				response += " " + nextZeroAnswer(daemon, value);
+			} else {
+				response += " " + pathCountAnswer(daemon, value);
+			}
+		}
+	} catch (const exception &e) {
+		// e.g. a path count that doesn't fit in 128 bits
+		string message = e.what();
+		if (message.compare(0, 7, "Error: ") == 0) message.erase(0, 7);
+		return "error " + message;
+	}
+	
+	daemon->requestsAnswered++;
+	daemon->valuesAnswered += values.size();
+	return response;
+}
+
+struct queryDaemonConfig defaultQueryDaemonConfig(const string &socketPath) {
+	struct queryDaemonConfig config;
+	config.socketPath = socketPath;
+	config.maxFallbackScan = 100000;
+	config.pathCountThreads = defaultBackwardPathCounterConfig().threads;
+	return config;
+}
+
+struct queryDaemon *createQueryDaemon(struct queryDaemonConfig config, const struct resultSet *results) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (config.socketPath.empty() || config.socketPath.size() >= sizeof(address.sun_path)) {
+		throw runtime_error("Error: the socket path '" + config.socketPath + "' is empty or too long");
+	}
+	strcpy(address.sun_path, config.socketPath.c_str());
+	
+	// Left behind by a daemon that didn't get to clean up. Anything else there is left alone, and
+	// bind() fails below.
+	struct stat status;
+	if (stat(config.socketPath.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+		unlink(config.socketPath.c_str());
+	}
+	
+	int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listenFd < 0) {
+		throw runtime_error(string("Error: couldn't create a socket: ") + strerror(errno));
+	}
+	if (bind(listenFd, (const struct sockaddr *)&address, sizeof(address)) != 0 || listen(listenFd, SOMAXCONN) != 0) {
+		string error = strerror(errno);
+		close(listenFd);
+		throw runtime_error("Error: couldn't listen on '" + config.socketPath + "': " + error);
+	}
+	
+	struct backwardPathCounterConfig counterConfig = defaultBackwardPathCounterConfig();
+	counterConfig.threads = config.pathCountThreads;
+	
+	struct queryDaemon *daemon = new struct queryDaemon;
+	daemon->config = config;
+	daemon->results = results;
+	daemon->search = createBackwardSearch(defaultBackwardSearchConfig());
+	daemon->counter = createBackwardPathCounter(counterConfig);
+	daemon->listenFd = listenFd;
+	daemon->stopRequested = false;
+	daemon->requestsAnswered = 0;
+	daemon->valuesAnswered = 0;
+	daemon->fallbacks = 0;
+	daemon->fallbackScannedTo = results->aggregate.maxValue;
+	daemon->fallbackZero = 0;
+	
+	return daemon;
+}
+
+// Answers every complete line received. Returns false if the client has to be cut off.
+static bool answerReceived(struct queryDaemon *daemon, struct queryClient &client, uint64_t &requests) {
+	uint64_t lineStart = 0;
+	uint64_t newline;
+	while ((newline = client.received.find('\n', lineStart)) != string::npos) {
+		string request = client.received.substr(lineStart, newline - lineStart);
+		if (!request.empty() && request.back() == '\r') request.pop_back();
+		
+		client.toSend += answerQuery(daemon, request);
+		client.toSend += '\n';
+		requests++;
+		lineStart = newline + 1;
+	}
+	client.received.erase(0, lineStart);
+	
+	return client.received.size() <= MAX_REQUEST_BYTES;
+}
+
+// One read per wakeup, so a client sending a lot can't keep the others waiting. Returns false if
+// the client has gone. At the end of what it sends, a last request without a newline is given one.
+static bool receiveFrom(struct queryClient &client) {
+	char buffer[RECEIVE_BUFFER_BYTES];
+	ssize_t bytes = recv(client.fd, buffer, sizeof(buffer), 0);
+	if (bytes > 0) {
+		client.received.append(buffer, bytes);
+		return true;
+	}
+	if (bytes == 0) {
+		if (!client.received.empty()) client.received += '\n';
+		client.doneReceiving = true;
+		return true;
+	}
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+// Sends as much as the socket will take now. Returns false if the client has gone.
+static bool sendTo(struct queryClient &client) {
+	while (!client.toSend.empty()) {
+		ssize_t bytes = send(client.fd, client.toSend.data(), client.toSend.size(), MSG_NOSIGNAL);
+		if (bytes >= 0) {
+			client.toSend.erase(0, bytes);
+			continue;
+		}
+		if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+		if (errno == EINTR) continue;
+		return false;
+	}
+	return true;
+}
+
+void runQueryDaemon(struct queryDaemon *daemon, const struct queryDaemonCallbacks &callbacks) {
+	vector<struct queryClient> clients;
+	vector<struct pollfd> pollFds;
+	
+	while (!daemon->stopRequested) {
+		// The listening socket, then each client in the same order as clients
+		pollFds.clear();
+		pollFds.push_back({ daemon->listenFd, POLLIN, 0 });
+		for (const struct queryClient &client : clients) {
+			short events = (client.doneReceiving ? 0 : POLLIN) | (client.toSend.empty() ? 0 : POLLOUT);
+			pollFds.push_back({ client.fd, events, 0 });
+		}
+		
+		int ready = poll(pollFds.data(), pollFds.size(), QUERY_DAEMON_POLL_MS);
+		if (ready < 0 && errno != EINTR) {
+			throw runtime_error(string("Error: poll() failed: ") + strerror(errno));
+		}
+		if (ready <= 0) continue;
+		
+		vector<struct queryClient> stillOpen;
+		for (uint64_t i = 0; i < clients.size(); i++) {
+			struct queryClient &client = clients[i];
+			short events = pollFds[i + 1].revents;
+			
+			bool open = true;
+			if (!client.doneReceiving && (events & (POLLIN | POLLHUP | POLLERR))) {
+				open = receiveFrom(client);
+				
+				uint64_t requests = 0;
+				uint64_t valuesBefore = daemon->valuesAnswered;
+				if (!answerReceived(daemon, client, requests)) {
+					client.toSend += "error request longer than " + to_string(MAX_REQUEST_BYTES) + " bytes\n";
+					client.received.clear();
+					client.doneReceiving = true;
+				}
+				if (requests != 0 && callbacks.batchAnswered) {
+					callbacks.batchAnswered(requests, daemon->valuesAnswered - valuesBefore);
+				}
+			}
+			
+			// A client that's finished sending is only polled for POLLOUT from then on, and closed
+			// once everything it's been answered has been sent
+			if (!open || !sendTo(client) || (client.doneReceiving && client.toSend.empty())) {
+				close(client.fd);
+			} else {
+				stillOpen.push_back(move(client));
+			}
+		}
+		clients = move(stillOpen);
+		
+		if (pollFds[0].revents & POLLIN) {
+			int fd;
+			while ((fd = accept4(daemon->listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+				clients.push_back({ fd, "", "", false });
+			}
+		}
+	}
+	
+	for (const struct queryClient &client : clients) {
+		close(client.fd);
+	}
+}
+
+void stopQueryDaemon(struct queryDaemon *daemon) {
+	daemon->stopRequested = true;
+}
+
+void destroyQueryDaemon(struct queryDaemon *daemon) {
+	if (daemon == nullptr) return;
+	
+	close(daemon->listenFd);
+	unlink(daemon->config.socketPath.c_str());
+	destroyBackwardSearch(daemon->search);
+	destroyBackwardPathCounter(daemon->counter);
+	delete daemon;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include "backward-path-count.h"
+#include "backward-search.h"
+#include "result-set.h"
+
+#ifndef QUERY_DAEMON_H
+#define QUERY_DAEMON_H
+
+// Answers questions about a result set (see result-set.h) over a Unix domain socket, so other
+// tools can ask without rerunning an engine or grepping its output. Past what the result set
+// covers, it falls back to backward-search.h and backward-path-count.h (whose memos are kept
+// between queries), so any value below 2^128 can be asked about.
+//
+// Requests and responses are lines of text. A request is a command and any number of values, and
+// is answered by one line with an answer per value, in order:
+//   reachable Z [Z ...]  ->  ok 1 0 ...     (1 if Z is reachable)
+//   next Z [Z ...]       ->  ok Z' ...      (the first zero above Z, or "none" if there isn't one
+//                                            up to maxFallbackScan values past the result set)
+//   paths Z [Z ...]      ->  ok count ...   (the number of paths to Z)
+//   info                 ->  ok maxValue countsMaxValue zeroCount
+// or "error <message>". Several requests can be sent at once; every complete line that's arrived is
+// answered, and the answers sent back together.
+//
+// Clients are served one after another from a single thread (with poll()), as a lookup in the
+// result set takes a microsecond or so. A query that needs a fallback holds up every other client
+// until it's done.
+
+struct queryDaemonConfig {
+	std::string socketPath; // replaced if it's already there
+	uint64_t maxFallbackScan; // values tried past the result set by "next"
+	int pathCountThreads;
+};
+
+// Any of these can be left empty
+struct queryDaemonCallbacks {
+	// Called after every batch of requests from a client has been answered
+	std::function<void(uint64_t requests, uint64_t values)> batchAnswered;
+};
+
+struct queryDaemon {
+	struct queryDaemonConfig config;
+	const struct resultSet *results;
+	struct backwardSearch *search;
+	struct backwardPathCounter *counter;
+	int listenFd;
+	std::atomic<bool> stopRequested;
+	
+	// Totals so far
+	uint64_t requestsAnswered;
+	uint64_t valuesAnswered;
+	uint64_t fallbacks; // values answered by searching rather than from the result set
+	
+	// Every value from the result set's max value up to fallbackScannedTo has been tried by "next",
+	// and fallbackZero is the first zero there (0 if none has been found)
+	uint128_t fallbackScannedTo;
+	uint128_t fallbackZero;
+};
+
+struct queryDaemonConfig defaultQueryDaemonConfig(const std::string &socketPath);
+
+// Binds and listens on the socket. Throws std::runtime_error if that fails. The result set has to
+// stay open until the daemon is destroyed.
+struct queryDaemon *createQueryDaemon(struct queryDaemonConfig config, const struct resultSet *results);
+
+// Serves clients until stopQueryDaemon() is called
+void runQueryDaemon(struct queryDaemon *daemon, const struct queryDaemonCallbacks &callbacks);
+
+// Safe to call from a signal handler or another thread. runQueryDaemon() returns within
+// QUERY_DAEMON_POLL_MS, or once the query it's answering is done.
+void stopQueryDaemon(struct queryDaemon *daemon);
+
+// Removes the socket. Connections are closed as runQueryDaemon() returns.
+void destroyQueryDaemon(struct queryDaemon *daemon);
+
+const int QUERY_DAEMON_POLL_MS = 200;
+
+// The response to one request line (without its newline), as it'd be sent back
+std::string answerQuery(struct queryDaemon *daemon, const std::string &request);
+
+#endif
\ No newline at end of file
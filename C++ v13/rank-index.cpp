@@ -0,0 +1,279 @@
+#include "bit-view.h"
+#include "column-kernels.h"
+#include "rank-index.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#if defined(__BMI2__)
+	#include <immintrin.h>
+#endif
+
+using namespace std;
+
+const uint64_t RANK_BLOCK_BITS = RANK_BLOCK_CHUNKS * CHUNK_BITS;
+const uint64_t RANK_SUPERBLOCK_BITS = RANK_SUPERBLOCK_CHUNKS * CHUNK_BITS;
+const uint64_t BLOCKS_PER_SUPERBLOCK = RANK_SUPERBLOCK_CHUNKS / RANK_BLOCK_CHUNKS;
+
+static uint64_t chunksFor(uint64_t bitCount) {
+	return (bitCount + CHUNK_BITS - 1) / CHUNK_BITS;
+}
+
+// The position of the n-th (from 1) ON bit of word, which has at least n
+static int selectInWord(uint64_t word, uint64_t n) {
+	#if defined(__BMI2__)
+		return __builtin_ctzll(_pdep_u64(1ULL << (n - 1), word));
+	#else
+		for (uint64_t i = 1; i < n; i++) {
+			word &= word - 1;
+		}
+		return __builtin_ctzll(word);
+	#endif
+}
+
+// ON (or OFF) bits before a superblock or block, given the ON bits before it and where it starts
+static uint64_t countBefore(bool on, uint64_t onBefore, uint64_t bitsBefore) {
+	return on ? onBefore : bitsBefore - onBefore;
+}
+
+static void takeSelectSamples(struct rankIndex *index, bool on, vector<uint64_t> &samples) {
+	samples.clear();
+	uint64_t total = on ? index->onCount : index->bitCount - index->onCount;
+	uint64_t superblock = 0;
+	for (uint64_t n = 1; n <= total; n += RANK_SELECT_SAMPLE) {
+		while (superblock + 1 < index->superblocks.size()
+			&& countBefore(on, index->superblocks[superblock + 1], (superblock + 1) * RANK_SUPERBLOCK_BITS) < n) {
+			superblock++;
+		}
+		samples.push_back(superblock);
+	}
+}
+
+struct rankIndex *createRankIndex(uint64_t maxValue) {
+	if (maxValue < 1) {
+		throw out_of_range("maxValue < 1");
+	}
+	
+	struct rankIndex *index = new struct rankIndex;
+	index->maxValue = maxValue;
+	index->bitCount = numToBitPos(maxValue) + 1;
+	index->chunksAdded = 0;
+	index->onCount = 0;
+	
+	uint64_t chunkCount = chunksFor(index->bitCount);
+	index->superblocks.reserve(chunkCount / RANK_SUPERBLOCK_CHUNKS + 1);
+	index->blocks.reserve(chunkCount / RANK_BLOCK_CHUNKS + 1);
+	index->finished = false;
+	
+	return index;
+}
+
+void finishRankIndex(struct rankIndex *index) {
+	if (index->finished) {
+		throw logic_error("Error: the rank index has already been finished");
+	}
+	if (index->chunksAdded != chunksFor(index->bitCount)) {
+		throw logic_error(
+			string("Error: ")
+			+ to_string(index->chunksAdded)
+			+ " chunks were added to the rank index, rather than the "
+			+ to_string(chunksFor(index->bitCount))
+			+ " up to its max value."
+		);
+	}
+	
+	takeSelectSamples(index, true, index->onSamples);
+	takeSelectSamples(index, false, index->offSamples);
+	index->finished = true;
+}
+
+struct rankIndex *buildRankIndex(const struct reachabilityBitView *view) {
+	struct rankIndex *index = createRankIndex(view->maxValue);
+	uint64_t chunkCount = chunksFor(index->bitCount);
+	for (uint64_t i = 0; i < chunkCount; i++) {
+		addRankIndexChunk(index, view->chunks[i]);
+	}
+	finishRankIndex(index);
+	return index;
+}
+
+void destroyRankIndex(struct rankIndex *index) {
+	delete index;
+}
+
+void saveRankIndex(const struct rankIndex *index, const string &path) {
+	if (!index->finished) {
+		throw logic_error("Error: the rank index hasn't been finished");
+	}
+	
+	struct rankIndexFileHeader header;
+	memcpy(header.magic, RANK_INDEX_MAGIC, sizeof(RANK_INDEX_MAGIC));
+	header.maxValue = index->maxValue;
+	header.onCount = index->onCount;
+	header.superblockCount = index->superblocks.size();
+	header.blockCount = index->blocks.size();
+	
+	ofstream file(path, ios::binary | ios::trunc);
+	file.write((const char *)&header, sizeof(header));
+	file.write((const char *)index->superblocks.data(), index->superblocks.size() * sizeof(uint64_t));
+	file.write((const char *)index->blocks.data(), index->blocks.size() * sizeof(uint16_t));
+	file.flush();
+	if (!file.good()) {
+		throw runtime_error("Error: couldn't write the rank index to '" + path + "'");
+	}
+}
+
+struct rankIndex *loadRankIndex(const string &path) {
+	ifstream file(path, ios::binary);
+	if (!file.is_open()) {
+		throw runtime_error("Error: couldn't open '" + path + "'");
+	}
+	
+	struct rankIndexFileHeader header;
+	file.read((char *)&header, sizeof(header));
+	if (!file.good() || memcmp(header.magic, RANK_INDEX_MAGIC, sizeof(RANK_INDEX_MAGIC)) != 0 || header.maxValue < 1) {
+		throw runtime_error("Error: '" + path + "' isn't a rank index");
+	}
+	
+	struct rankIndex *index = createRankIndex(header.maxValue);
+	uint64_t chunkCount = chunksFor(index->bitCount);
+	if (header.superblockCount != (chunkCount + RANK_SUPERBLOCK_CHUNKS - 1) / RANK_SUPERBLOCK_CHUNKS
+		|| header.blockCount != (chunkCount + RANK_BLOCK_CHUNKS - 1) / RANK_BLOCK_CHUNKS) {
+		destroyRankIndex(index);
+		throw runtime_error("Error: '" + path + "' isn't a rank index");
+	}
+	
+	index->superblocks.resize(header.superblockCount);
+	index->blocks.resize(header.blockCount);
+	file.read((char *)index->superblocks.data(), index->superblocks.size() * sizeof(uint64_t));
+	file.read((char *)index->blocks.data(), index->blocks.size() * sizeof(uint16_t));
+	if (!file.good()) {
+		destroyRankIndex(index);
+		throw runtime_error("Error: '" + path + "' has been cut short");
+	}
+	
+	index->onCount = header.onCount;
+	index->chunksAdded = chunkCount;
+	finishRankIndex(index);
+	return index;
+}
+
+static void checkUsable(const struct rankIndex *index, const struct reachabilityBitView *view) {
+	if (!index->finished) {
+		throw logic_error("Error: the rank index hasn't been finished");
+	}
+	if (view->maxValue < index->maxValue) {
+		throw logic_error("Error: the bitmap doesn't go as far as the rank index, so can't be the one it was made from");
+	}
+}
+
+// ON bits among the first bitCount bits
+static uint64_t rankBits(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t bitCount) {
+	if (bitCount == index->bitCount) return index->onCount;
+	
+	uint64_t chunk = bitCount / CHUNK_BITS;
+	uint64_t block = chunk / RANK_BLOCK_CHUNKS;
+	uint64_t count = index->superblocks[chunk / RANK_SUPERBLOCK_CHUNKS] + index->blocks[block];
+	for (uint64_t i = block * RANK_BLOCK_CHUNKS; i < chunk; i++) {
+		count += __builtin_popcountll(view->chunks[i]);
+	}
+	if (bitCount % CHUNK_BITS != 0) {
+		count += __builtin_popcountll(view->chunks[chunk] & ((1ULL << (bitCount % CHUNK_BITS)) - 1));
+	}
+	return count;
+}
+
+// The position of the n-th (from 1) ON (or OFF) bit
+static uint64_t selectBit(const struct rankIndex *index, const struct reachabilityBitView *view, bool on, uint64_t n) {
+	checkUsable(index, view);
+	
+	uint64_t total = on ? index->onCount : index->bitCount - index->onCount;
+	if (n < 1 || n > total) {
+		throw out_of_range(
+			string("Error: there are ")
+			+ to_string(total)
+			+ (on ? " reachable values" : " zeros")
+			+ " up to the max value indexed '"
+			+ to_string(index->maxValue)
+			+ "', so no "
+			+ to_string(n)
+			+ "th."
+		);
+	}
+	
+	// The last superblock with fewer than n before it, between the samples either side of n
+	const vector<uint64_t> &samples = on ? index->onSamples : index->offSamples;
+	uint64_t sample = (n - 1) / RANK_SELECT_SAMPLE;
+	uint64_t low = samples[sample];
+	uint64_t high = sample + 1 < samples.size() ? samples[sample + 1] : index->superblocks.size() - 1;
+	while (low < high) {
+		uint64_t mid = (low + high + 1) / 2;
+		if (countBefore(on, index->superblocks[mid], mid * RANK_SUPERBLOCK_BITS) < n) {
+			low = mid;
+		} else {
+			high = mid - 1;
+		}
+	}
+	uint64_t superblock = low;
+	n -= countBefore(on, index->superblocks[superblock], superblock * RANK_SUPERBLOCK_BITS);
+	
+	// Then the same for its blocks
+	uint64_t firstBlock = superblock * BLOCKS_PER_SUPERBLOCK;
+	low = firstBlock;
+	high = min(firstBlock + BLOCKS_PER_SUPERBLOCK, (uint64_t)index->blocks.size()) - 1;
+	while (low < high) {
+		uint64_t mid = (low + high + 1) / 2;
+		if (countBefore(on, index->blocks[mid], (mid - firstBlock) * RANK_BLOCK_BITS) < n) {
+			low = mid;
+		} else {
+			high = mid - 1;
+		}
+	}
+	n -= countBefore(on, index->blocks[low], (low - firstBlock) * RANK_BLOCK_BITS);
+	
+	// Then the words of the block
+	for (uint64_t chunk = low * RANK_BLOCK_CHUNKS; true; chunk++) {
+		uint64_t word = on ? view->chunks[chunk] : ~view->chunks[chunk];
+		uint64_t bitsLeft = index->bitCount - chunk * CHUNK_BITS;
+		if (bitsLeft < CHUNK_BITS) word &= (1ULL << bitsLeft) - 1;
+		
+		uint64_t count = __builtin_popcountll(word);
+		if (n <= count) return chunk * CHUNK_BITS + selectInWord(word, n);
+		n -= count;
+	}
+}
+
+static void checkInIndex(const struct rankIndex *index, uint64_t value) {
+	if (value > index->maxValue) {
+		throw out_of_range(
+			string("Error: value '")
+			+ to_string(value)
+			+ "' is beyond the max value indexed '"
+			+ to_string(index->maxValue)
+			+ "'."
+		);
+	}
+}
+
+uint64_t countReachableUpTo(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t value) {
+	checkUsable(index, view);
+	checkInIndex(index, value);
+	return rankBits(index, view, value - value / 3);
+}
+
+uint64_t countZerosUpTo(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t value) {
+	checkUsable(index, view);
+	checkInIndex(index, value);
+	return value - value / 3 - rankBits(index, view, value - value / 3);
+}
+
+uint64_t getNthReachable(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t n) {
+	return bitPosToNum(selectBit(index, view, true, n));
+}
+
+uint64_t getNthZero(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t n) {
+	return bitPosToNum(selectBit(index, view, false, n));
+}
\ No newline at end of file
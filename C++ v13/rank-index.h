@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "bit-view.h"
+#include "column-kernels.h"
+
+#ifndef RANK_INDEX_H
+#define RANK_INDEX_H
+
+// Counts of ON bits before each part of a final reachability bitmap, so "how many values <= x are
+// reachable (or zeros)" and "the n-th reachable value (or zero)" don't need a scan of the bitmap.
+//
+// The counts are at two levels: an absolute 64-bit count before every superblock of
+// RANK_SUPERBLOCK_BITS, and a 16-bit count from the start of its superblock before every block of
+// RANK_BLOCK_BITS, about 3.2% of the bitmap's size in all. A rank is then the two counts plus at
+// most 7 popcounts. A select binary searches the superblocks (starting from a sample taken every
+// RANK_SELECT_SAMPLE ON or OFF bits, so usually only a few), then the blocks, then the words.
+//
+// The bitmap is in the sieve's layout, with multiples of 3 omitted, so the bits for the values
+// 1 to x are the first x - x / 3, and every OFF bit is a zero.
+
+const uint64_t RANK_BLOCK_CHUNKS = 8; // 512 bits
+const uint64_t RANK_SUPERBLOCK_CHUNKS = 1024; // 65,536 bits, so counts within one fit in 16 bits
+const uint64_t RANK_SELECT_SAMPLE = 1 << 16;
+
+const char RANK_INDEX_MAGIC[8] = { 'T', 'T', 'D', 'R', 'A', 'N', 'K', '1' };
+
+struct rankIndex {
+	uint64_t maxValue;
+	uint64_t bitCount; // numToBitPos(maxValue) + 1
+	uint64_t chunksAdded;
+	uint64_t onCount; // of the chunks added so far
+	
+	std::vector<uint64_t> superblocks;
+	std::vector<uint16_t> blocks;
+	
+	// onSamples[k] is the superblock holding the (k * RANK_SELECT_SAMPLE + 1)-th ON bit, and
+	// offSamples the same for OFF bits. Made by finishRankIndex().
+	std::vector<uint64_t> onSamples;
+	std::vector<uint64_t> offSamples;
+	bool finished;
+};
+
+struct rankIndexFileHeader {
+	char magic[8];
+	uint64_t maxValue;
+	uint64_t onCount;
+	uint64_t superblockCount;
+	uint64_t blockCount;
+};
+
+// An empty index, for the chunks of a bitmap up to maxValue to be added in order as they become final
+struct rankIndex *createRankIndex(uint64_t maxValue);
+
+// Bits past the index's bitCount are ignored
+inline void addRankIndexChunk(struct rankIndex *index, uint64_t chunk) {
+	uint64_t chunkNum = index->chunksAdded++;
+	if (chunkNum % RANK_SUPERBLOCK_CHUNKS == 0) {
+		index->superblocks.push_back(index->onCount);
+	}
+	if (chunkNum % RANK_BLOCK_CHUNKS == 0) {
+		index->blocks.push_back(index->onCount - index->superblocks.back());
+	}
+	
+	uint64_t bitsLeft = index->bitCount - chunkNum * CHUNK_BITS;
+	if (bitsLeft < CHUNK_BITS) chunk &= (1ULL << bitsLeft) - 1;
+	index->onCount += __builtin_popcountll(chunk);
+}
+
+// Throws std::logic_error unless exactly the chunks covering maxValue have been added
+void finishRankIndex(struct rankIndex *index);
+
+// All of the above, in one pass over a bitmap
+struct rankIndex *buildRankIndex(const struct reachabilityBitView *view);
+
+void destroyRankIndex(struct rankIndex *index);
+
+// Throws std::runtime_error if the file can't be written or read, or isn't a rank index
+void saveRankIndex(const struct rankIndex *index, const std::string &path);
+struct rankIndex *loadRankIndex(const std::string &path);
+
+// These need the bitmap the index was made from. The counts exclude multiples of 3, and throw
+// std::out_of_range beyond the index's max value.
+uint64_t countReachableUpTo(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t value);
+uint64_t countZerosUpTo(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t value);
+
+// n from 1. Throw std::out_of_range if there aren't n up to the index's max value.
+uint64_t getNthReachable(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t n);
+uint64_t getNthZero(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t n);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "column-kernels.h"
+#include "residue-wheel.h"
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+void findReachableResidues(int m, int s, int modulus, bool *reachable) {
+	// state = (value % modulus, next power of s % modulus)
+	vector<bool> seen((size_t)modulus * modulus, false);
+	vector<int> stack;
+	
+	#define visit(value, power) { \
+		int v = (value), p = (power); \
+		if (!seen[(size_t)v * modulus + p]) { \
+			seen[(size_t)v * modulus + p] = true; \
+			stack.push_back(v * modulus + p); \
+		} \
+	}
+	
+	visit(1 % modulus, s % modulus);
+	while (!stack.empty()) {
+		int state = stack.back();
+		stack.pop_back();
+		int value = state / modulus;
+		int power = state % modulus;
+		
+		visit((int)(((int64_t)value * m) % modulus), power);
+		visit((value + power) % modulus, (int)(((int64_t)power * s) % modulus));
+	}
+	
+	#undef visit
+	
+	for (int r = 0; r < modulus; r++) {
+		reachable[r] = false;
+		for (int p = 0; p < modulus; p++) {
+			if (seen[(size_t)r * modulus + p]) reachable[r] = true;
+		}
+	}
+}
+
+// Groups the per-residue deltas, & builds the mask of each group for each phase. spread is 1 for
+// shifts and m for multiplying. Deltas of INT32_MIN are left out of every group.
+static void groupDeltas(const struct residueWheel *wheel, const int *delta, int spread, int *groupCount, int **groupDelta, uint64_t **masks) {
+	int kept = wheel->kept;
+	
+	*groupDelta = new int[kept];
+	*groupCount = 0;
+	for (int j = 0; j < kept; j++) {
+		if (delta[j] == INT32_MIN) continue;
+		
+		bool seen = false;
+		for (int g = 0; g < *groupCount; g++) {
+			if ((*groupDelta)[g] == delta[j]) seen = true;
+		}
+		if (!seen) (*groupDelta)[(*groupCount)++] = delta[j];
+	}
+	
+	*masks = new uint64_t[(size_t)kept * *groupCount * spread]();
+	for (int phase = 0; phase < kept; phase++) {
+		for (int i = 0; i < CHUNK_BITS; i++) {
+			int d = delta[(phase + i) % kept];
+			if (d == INT32_MIN) continue;
+			
+			int g = 0;
+			while ((*groupDelta)[g] != d) g++;
+			
+			int spreadPos = spread * i;
+			(*masks)[((size_t)phase * *groupCount + g) * spread + spreadPos / CHUNK_BITS] |= 1ULL << (spreadPos % CHUNK_BITS);
+		}
+	}
+}
+
+struct residueWheel *createResidueWheel(int m, int s, int modulus) {
+	if (m < 2 || s < 2) {
+		throw out_of_range("M and S must both be at least 2");
+	}
+	if (modulus < 2) {
+		throw out_of_range("modulus < 2");
+	}
+	
+	bool *reachable = new bool[modulus];
+	findReachableResidues(m, s, modulus, reachable);
+	
+	struct residueWheel *wheel = new struct residueWheel;
+	wheel->m = m;
+	wheel->s = s;
+	wheel->modulus = modulus;
+	wheel->rankOf = new int[modulus];
+	wheel->residueAt = new int[modulus];
+	wheel->kept = 0;
+	for (int r = 0; r < modulus; r++) {
+		wheel->rankOf[r] = reachable[r] ? wheel->kept : -1;
+		if (reachable[r]) wheel->residueAt[wheel->kept++] = r;
+	}
+	delete[] reachable;
+	
+	// Same as makeMSResidueTables(), with modulus in place of S
+	int kept = wheel->kept;
+	int rankOfOne = wheel->rankOf[1];
+	wheel->multiplyDelta = new int[kept];
+	for (int j = 0; j < kept; j++) {
+		int idx = (j + rankOfOne) % kept;
+		int64_t multiplied = (int64_t)m * wheel->residueAt[idx];
+		int multipliedOffset = (int)(multiplied / modulus) * kept + wheel->rankOf[multiplied % modulus];
+		wheel->multiplyDelta[j] = (m - 1) * rankOfOne - m * idx + multipliedOffset;
+	}
+	
+	groupDeltas(wheel, wheel->multiplyDelta, m, &wheel->multiplyDeltaGroups, &wheel->multiplyGroupDelta, &wheel->multiplyMasks);
+	
+	return wheel;
+}
+
+void destroyResidueWheel(struct residueWheel *wheel) {
+	if (wheel == nullptr) return;
+	
+	delete[] wheel->rankOf;
+	delete[] wheel->residueAt;
+	delete[] wheel->multiplyDelta;
+	delete[] wheel->multiplyGroupDelta;
+	delete[] wheel->multiplyMasks;
+	delete wheel;
+}
+
+struct residueWheelShift *createResidueWheelShift(const struct residueWheel *wheel, int shift) {
+	if (shift < 0 || shift >= wheel->modulus) {
+		throw out_of_range("shift must be 0 to modulus - 1");
+	}
+	
+	int kept = wheel->kept;
+	int modulus = wheel->modulus;
+	int rankOfOne = wheel->rankOf[1];
+	
+	// Bit j is block position j + rankOfOne, i.e. residue residueAt[(j + rankOfOne) % kept]
+	int *delta = new int[kept];
+	for (int j = 0; j < kept; j++) {
+		int idx = (j + rankOfOne) % kept;
+		int shifted = wheel->residueAt[idx] + shift;
+		int residue = shifted % modulus;
+		
+		if (wheel->rankOf[residue] < 0) {
+			delta[j] = INT32_MIN;
+		} else {
+			delta[j] = (shifted / modulus) * kept + wheel->rankOf[residue] - idx;
+		}
+	}
+	
+	struct residueWheelShift *wheelShift = new struct residueWheelShift;
+	wheelShift->shift = shift;
+	groupDeltas(wheel, delta, 1, &wheelShift->deltaGroups, &wheelShift->groupDelta, &wheelShift->masks);
+	delete[] delta;
+	
+	return wheelShift;
+}
+
+void destroyResidueWheelShift(struct residueWheelShift *wheelShift) {
+	if (wheelShift == nullptr) return;
+	
+	delete[] wheelShift->groupDelta;
+	delete[] wheelShift->masks;
+	delete wheelShift;
+}
+
+bool residueWheelFitsKernels(const struct residueWheel *wheel) {
+	for (int g = 0; g < wheel->multiplyDeltaGroups; g++) {
+		if (wheel->multiplyGroupDelta[g] <= -CHUNK_BITS || wheel->multiplyGroupDelta[g] >= CHUNK_BITS) return false;
+	}
+	
+	// The sieve shifts by S^k % modulus between columns (see wheel-column-sieve.h), and those
+	// repeat once a power does
+	int modulus = wheel->modulus;
+	vector<bool> seen(modulus, false);
+	for (int power = wheel->s % modulus; !seen[power]; power = (int)(((int64_t)power * wheel->s) % modulus)) {
+		seen[power] = true;
+		
+		struct residueWheelShift *wheelShift = createResidueWheelShift(wheel, power);
+		bool fits = true;
+		for (int g = 0; g < wheelShift->deltaGroups; g++) {
+			if (wheelShift->groupDelta[g] >= CHUNK_BITS) fits = false;
+		}
+		destroyResidueWheelShift(wheelShift);
+		if (!fits) return false;
+	}
+	
+	return true;
+}
+
+double residueWheelDensity(const struct residueWheel *wheel) {
+	return (double)wheel->kept / wheel->modulus;
+}
+
+struct residueWheel *detectResidueWheel(int m, int s, int maxModulus, const uint64_t *probeReachable, uint64_t probeCount) {
+	struct residueWheel *best = nullptr;
+	
+	vector<bool> hit;
+	for (int modulus = 2; modulus <= maxModulus; modulus++) {
+		// Everything the probe hits is reachable, so its count is a lower bound on kept
+		if (best != nullptr) {
+			hit.assign(modulus, false);
+			int probeKept = 0;
+			for (uint64_t i = 0; i < probeCount; i++) {
+				int r = probeReachable[i] % modulus;
+				if (!hit[r]) {
+					hit[r] = true;
+					probeKept++;
+				}
+			}
+			if ((int64_t)probeKept * best->modulus >= (int64_t)best->kept * modulus) continue;
+		}
+		
+		struct residueWheel *candidate = createResidueWheel(m, s, modulus);
+		bool better = best == nullptr || (int64_t)candidate->kept * best->modulus < (int64_t)best->kept * modulus;
+		if (better && residueWheelFitsKernels(candidate)) {
+			destroyResidueWheel(best);
+			best = candidate;
+		} else {
+			destroyResidueWheel(candidate);
+		}
+	}
+	
+	return best;
+}
\ No newline at end of file
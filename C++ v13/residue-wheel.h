@@ -0,0 +1,79 @@
+#include <stdint.h>
+
+#ifndef RESIDUE_WHEEL_H
+#define RESIDUE_WHEEL_H
+
+// A wheel of residue classes mod `modulus` that are worth storing, for "multiply by M or add the
+// next power of S". This generalises mapToAvoidMult3s() (which is the wheel mod 3 for M = 2, S = 3)
+// and the compile-time mod S layout in ms-kernels.h, to any modulus, e.g. M = 4, S = 3 only needs
+// 3 of every 12 values, and M = 3, S = 6 only 25 of every 216.
+//
+// The classes are exact, not guesses: findReachableResidues() follows the residues of
+// (value, next power of S) mod `modulus` until nothing new turns up, which gives every residue
+// some reachable value has. All other classes are trivial zeros.
+
+struct residueWheel {
+	int m;
+	int s;
+	int modulus;
+	int kept; // bits stored per block of `modulus` values
+	int *rankOf; // bit within a block for each residue, or -1 if it's never reachable
+	int *residueAt; // inverse of rankOf, `kept` long
+	
+	// Multiplying by M maps bit p to M * p + multiplyDelta[p % kept], as in ms-kernels.h. The
+	// masks are grouped by delta, per phase = (64 * chunk) % kept, and already spread M-way.
+	int *multiplyDelta;
+	int multiplyDeltaGroups;
+	int *multiplyGroupDelta;
+	uint64_t *multiplyMasks; // [phase][group][word], kept * multiplyDeltaGroups * m long
+};
+
+// Same idea for adding `shift` (0 to modulus - 1) to every value, which moves bit p to
+// p + groupDelta[g] for its group g, with every groupDelta[g] >= 0. Bits whose residue isn't kept
+// once shifted are in no group, as the sieve only shifts when those bits can't be ON.
+struct residueWheelShift {
+	int shift;
+	int deltaGroups;
+	int *groupDelta;
+	uint64_t *masks; // [phase][group], kept * deltaGroups long
+};
+
+// reachable must be `modulus` long
+void findReachableResidues(int m, int s, int modulus, bool *reachable);
+
+struct residueWheel *createResidueWheel(int m, int s, int modulus);
+void destroyResidueWheel(struct residueWheel *wheel);
+
+struct residueWheelShift *createResidueWheelShift(const struct residueWheel *wheel, int shift);
+void destroyResidueWheelShift(struct residueWheelShift *wheelShift);
+
+// Whether every bit moves less than 64 positions, for multiplying and for each shift the sieve will
+// use, so the chunk kernels only ever touch neighbouring chunks
+bool residueWheelFitsKernels(const struct residueWheel *wheel);
+
+// The bits saved by wheel, compared to storing every value
+double residueWheelDensity(const struct residueWheel *wheel);
+
+// Picks the wheel with the fewest bits per value that residueWheelFitsKernels(), with modulus 2 to
+// maxModulus, or nullptr if there's none. probeReachable is some reachable values, e.g. everything
+// a small msColumnSieve<M, S> finds: moduli where the probe already hits as big a fraction of the
+// classes as the best wheel so far can't do better, so only the rest are checked exactly with
+// findReachableResidues().
+struct residueWheel *detectResidueWheel(int m, int s, int maxModulus, const uint64_t *probeReachable, uint64_t probeCount);
+
+// These are accurate when the first bit represents the value 1, like numToBitPos() and bitPosToNum().
+// Only valid for values whose residue is kept.
+inline uint64_t wheelPositionOf(const struct residueWheel *wheel, uint64_t number) {
+	return (number / wheel->modulus) * wheel->kept + wheel->rankOf[number % wheel->modulus] - wheel->rankOf[1];
+}
+
+inline uint64_t wheelValueAt(const struct residueWheel *wheel, uint64_t bitPos) {
+	uint64_t blockPos = bitPos + wheel->rankOf[1];
+	return (blockPos / wheel->kept) * wheel->modulus + wheel->residueAt[blockPos % wheel->kept];
+}
+
+inline bool wheelKeeps(const struct residueWheel *wheel, uint64_t number) {
+	return wheel->rankOf[number % wheel->modulus] >= 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "column-kernels.h"
+#include "path-count-sieve.h"
+#include "result-set.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+static uint64_t alignUp(uint64_t offset) {
+	return (offset + RESULT_SET_ALIGNMENT - 1) / RESULT_SET_ALIGNMENT * RESULT_SET_ALIGNMENT;
+}
+
+// Pads with 0s up to offset, which is where the file is expected to be
+static void padTo(ofstream &file, uint64_t offset) {
+	static const char zeros[RESULT_SET_ALIGNMENT] = {};
+	uint64_t at = file.tellp();
+	file.write(zeros, offset - at);
+}
+
+void writeResultSet(const string &path, const struct reachabilityBitView &aggregate, const struct pathCountSieve *counts) {
+	if (counts != nullptr && !counts->finished) {
+		throw logic_error("Error: the counts aren't final until runPathCountSieve() has returned");
+	}
+	
+	vector<uint64_t> zeros;
+	for (uint64_t i = 0; i < aggregate.chunkCount; i++) {
+		uint64_t offBits = ~aggregate.chunks[i];
+		while (offBits != 0) {
+			uint64_t value = bitPosToNum(i * CHUNK_BITS + __builtin_ctzll(offBits));
+			if (value > aggregate.maxValue) break;
+			
+			zeros.push_back(value);
+			offBits &= offBits - 1;
+		}
+	}
+	
+	struct resultSetHeader header;
+	memcpy(header.magic, RESULT_SET_MAGIC, sizeof(RESULT_SET_MAGIC));
+	header.maxValue = aggregate.maxValue;
+	header.chunkCount = aggregate.chunkCount;
+	header.aggregateOffset = alignUp(sizeof(header));
+	header.zeroCount = zeros.size();
+	header.zerosOffset = alignUp(header.aggregateOffset + aggregate.chunkCount * sizeof(uint64_t));
+	header.countsMaxValue = counts == nullptr ? 0 : counts->maxValueRepresentable;
+	header.countLaneBytes = counts == nullptr ? 0 : counts->laneBytes;
+	header.countsOffset = alignUp(header.zerosOffset + zeros.size() * sizeof(uint64_t));
+	
+	ofstream file(path, ios::binary | ios::trunc);
+	if (!file.is_open()) {
+		throw runtime_error("Error: couldn't open '" + path + "' to write the result set to");
+	}
+	
+	file.write((const char *)&header, sizeof(header));
+	padTo(file, header.aggregateOffset);
+	file.write((const char *)aggregate.chunks, aggregate.chunkCount * sizeof(uint64_t));
+	padTo(file, header.zerosOffset);
+	file.write((const char *)zeros.data(), zeros.size() * sizeof(uint64_t));
+	padTo(file, header.countsOffset);
+	if (counts != nullptr) {
+		uint64_t lanes = numToBitPos(counts->maxValueRepresentable) + 1;
+		file.write((const char *)counts->aggregateCounts, lanes * counts->laneBytes);
+	}
+	file.flush();
+	
+	if (!file.good()) {
+		throw runtime_error("Error: couldn't write to '" + path + "'");
+	}
+}
+
+struct resultSet *openResultSet(const string &path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw runtime_error("Error: couldn't open '" + path + "': " + strerror(errno));
+	}
+	
+	struct stat status;
+	if (fstat(fd, &status) != 0 || status.st_size < (off_t)sizeof(struct resultSetHeader)) {
+		close(fd);
+		throw runtime_error("Error: '" + path + "' isn't a result set");
+	}
+	
+	// The mapping keeps the file open, so the descriptor isn't needed past here
+	void *mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		throw runtime_error("Error: couldn't map '" + path + "': " + strerror(errno));
+	}
+	
+	struct resultSet *results = new struct resultSet;
+	results->path = path;
+	results->mapping = (const uint8_t *)mapping;
+	results->mappingBytes = status.st_size;
+	results->header = (const struct resultSetHeader *)mapping;
+	
+	const struct resultSetHeader &header = *results->header;
+	uint64_t countLanes = header.countsMaxValue == 0 ? 0 : numToBitPos(header.countsMaxValue) + 1;
+	if (memcmp(header.magic, RESULT_SET_MAGIC, sizeof(RESULT_SET_MAGIC)) != 0
+		|| header.aggregateOffset + header.chunkCount * sizeof(uint64_t) > results->mappingBytes
+		|| header.zerosOffset + header.zeroCount * sizeof(uint64_t) > results->mappingBytes
+		|| header.countsOffset + countLanes * header.countLaneBytes > results->mappingBytes) {
+		closeResultSet(results);
+		throw runtime_error("Error: '" + path + "' isn't a result set, or has been cut short");
+	}
+	
+	results->aggregate.chunks = (const uint64_t *)(results->mapping + header.aggregateOffset);
+	results->aggregate.chunkCount = header.chunkCount;
+	results->aggregate.maxValue = header.maxValue;
+	results->zeros = (const uint64_t *)(results->mapping + header.zerosOffset);
+	results->counts = header.countsMaxValue == 0 ? nullptr : results->mapping + header.countsOffset;
+	
+	return results;
+}
+
+void closeResultSet(struct resultSet *results) {
+	if (results == nullptr) return;
+	
+	munmap((void *)results->mapping, results->mappingBytes);
+	delete results;
+}
+
+uint64_t getNextStoredZero(const struct resultSet *results, uint64_t value) {
+	const uint64_t *zerosEnd = results->zeros + results->header->zeroCount;
+	const uint64_t *next = upper_bound(results->zeros, zerosEnd, value);
+	return next == zerosEnd ? 0 : *next;
+}
+
+uint64_t getStoredPathCount(const struct resultSet *results, uint64_t value) {
+	uint64_t countsMaxValue = results->header->countsMaxValue;
+	if (value > countsMaxValue) {
+		throw out_of_range(
+			string("Error: value '")
+			+ to_string(value)
+			+ "' is beyond the max value counted '"
+			+ to_string(countsMaxValue)
+			+ "'."
+		);
+	}
+	if (value == 0 || value % 3 == 0) return 0;
+	
+	uint64_t bitPos = numToBitPos(value);
+	switch (results->header->countLaneBytes) {
+		case 1: return ((const uint8_t *)results->counts)[bitPos];
+		case 2: return ((const uint16_t *)results->counts)[bitPos];
+		case 4: return ((const uint32_t *)results->counts)[bitPos];
+		default: return ((const uint64_t *)results->counts)[bitPos];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include <stdint.h>
+#include <string>
+#include "bit-view.h"
+#include "path-count-sieve.h"
+
+#ifndef RESULT_SET_H
+#define RESULT_SET_H
+
+// The final results of a run, in a file laid out to be memory-mapped and used as it is, so opening
+// one takes the same time however big it is, and a lookup only reads the pages it needs. Unlike
+// column-store.h, nothing is coded, and only the final answers are kept. The file is, with each
+// section starting on a RESULT_SET_ALIGNMENT boundary:
+//  - a resultSetHeader
+//  - the aggregate, in the sieve's layout (multiples of 3 omitted, bit numToBitPos(value))
+//  - every zero up to maxValue (i.e. every OFF bit), in increasing order, as uint64_t's, so the
+//    next zero after a value is a binary search away rather than a scan of the aggregate
+//  - optionally, path counts from path-count-sieve.h, a countLaneBytes-wide lane per bit position,
+//    up to countsMaxValue (which needn't match maxValue, as counting needs far more memory)
+
+const char RESULT_SET_MAGIC[8] = { 'T', 'T', 'D', 'R', 'S', 'E', 'T', '1' };
+
+const uint64_t RESULT_SET_ALIGNMENT = 4096;
+
+struct resultSetHeader {
+	char magic[8];
+	uint64_t maxValue;
+	uint64_t chunkCount;
+	uint64_t aggregateOffset; // in bytes, from the start of the file
+	uint64_t zeroCount;
+	uint64_t zerosOffset;
+	uint64_t countsMaxValue; // 0 if there are no counts
+	uint64_t countLaneBytes;
+	uint64_t countsOffset;
+};
+
+struct resultSet {
+	std::string path;
+	const uint8_t *mapping;
+	uint64_t mappingBytes;
+	const struct resultSetHeader *header;
+	struct reachabilityBitView aggregate;
+	const uint64_t *zeros;
+	const void *counts; // nullptr if there are none
+};
+
+// counts can be null. Throws std::runtime_error if the file can't be written.
+void writeResultSet(const std::string &path, const struct reachabilityBitView &aggregate, const struct pathCountSieve *counts);
+
+// Maps the file read-only, reading nothing but the header. Throws std::runtime_error if it can't
+// be mapped or isn't a (complete) result set.
+struct resultSet *openResultSet(const std::string &path);
+void closeResultSet(struct resultSet *results);
+
+// The first zero above value, or 0 if there isn't one up to maxValue
+uint64_t getNextStoredZero(const struct resultSet *results, uint64_t value);
+
+// Throws std::out_of_range beyond countsMaxValue (including when there are no counts)
+uint64_t getStoredPathCount(const struct resultSet *results, uint64_t value);
+
+#endif
\ No newline at end of file
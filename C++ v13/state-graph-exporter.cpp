@@ -0,0 +1,459 @@
+#include "math-utils.h"
+#include "column-kernels.h"
+#include "state-graph-exporter.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const uint64_t MAX_GRAPH_VALUE = 1ULL << 62;
+
+// Output is built up in a string, and written out whenever it gets to this
+const uint64_t GRAPH_WRITE_BYTES = 1 << 20;
+
+const uint64_t GRAPH_READ_BYTES = 1 << 20;
+
+struct graphPlanes {
+	uint64_t max;
+	uint64_t bitCount; // numToBitPos(max) + 1
+	int powOf3; // -1 before the first plane is made
+	vector<uint64_t> plane;
+	vector<uint64_t> heads; // the bits of plane an add step lands on, or just 1 for plane 0
+};
+
+struct graphWriter {
+	struct stateGraphConfig config;
+	ofstream file;
+	string buffer;
+	struct stateGraphStats stats;
+	uint64_t lastSource; // of the plane being written, for the edge list's gaps
+};
+
+static void initGraphPlanes(struct graphPlanes &planes, uint64_t max) {
+	planes.max = max;
+	planes.bitCount = numToBitPos(max) + 1;
+	planes.powOf3 = -1;
+	planes.plane.assign((planes.bitCount + CHUNK_BITS - 1) / CHUNK_BITS, 0);
+	planes.heads.assign(planes.plane.size(), 0);
+}
+
+// 1 + 3 + ... + 3^powOf3, the smallest value with 3^powOf3 as the last power, or 0 if that would be
+// past max
+static uint64_t smallestWithPow(int powOf3, uint64_t max) {
+	uint64_t sum = 0;
+	for (int i = 0; i <= powOf3; i++) {
+		if (i >= 40 || threeToThe(i) > max - sum) return 0;
+		sum += threeToThe(i);
+	}
+	return sum;
+}
+
+// Makes the next plane from the one before, returning false (and leaving it) if it'd be empty
+static bool makeNextPlane(struct graphPlanes &planes) {
+	int powOf3 = planes.powOf3 + 1;
+	if (smallestWithPow(powOf3, planes.max) == 0) return false;
+	
+	uint64_t words = planes.plane.size();
+	if (powOf3 == 0) {
+		planes.heads[0] = 1; // value 1
+	} else {
+		// Adding 3^powOf3 moves every bit the same 2 * 3^(powOf3 - 1) along
+		uint64_t shift = 2 * threeToThe(powOf3 - 1);
+		uint64_t wordShift = shift / CHUNK_BITS;
+		int bitShift = shift % CHUNK_BITS;
+		for (uint64_t i = 0; i < words; i++) {
+			uint64_t word = 0;
+			if (i >= wordShift) {
+				word = planes.plane[i - wordShift] << bitShift;
+				if (bitShift != 0 && i > wordShift) word |= planes.plane[i - wordShift - 1] >> (CHUNK_BITS - bitShift);
+			}
+			planes.heads[i] = word;
+		}
+		uint64_t bitsLeft = planes.bitCount % CHUNK_BITS;
+		if (bitsLeft != 0) planes.heads[words - 1] &= (1ULL << bitsLeft) - 1;
+	}
+	planes.plane = planes.heads;
+	
+	// Every doubling is further along, so it's picked up by the same sweep that sets it. Bits set in
+	// the word being swept are picked up by rereading it.
+	uint64_t maxToDouble = planes.max / 2;
+	for (uint64_t i = 0; i < words; i++) {
+		uint64_t done = 0;
+		uint64_t word;
+		while ((word = planes.plane[i] & ~done) != 0) {
+			int bit = __builtin_ctzll(word);
+			done |= 1ULL << bit;
+			
+			uint64_t value = bitPosToNum(i * CHUNK_BITS + bit);
+			if (value > maxToDouble) break;
+			uint64_t doubledPos = numToBitPos(2 * value);
+			planes.plane[doubledPos / CHUNK_BITS] |= 1ULL << (doubledPos % CHUNK_BITS);
+		}
+	}
+	
+	planes.powOf3 = powOf3;
+	return true;
+}
+
+// Calls bitFound(value) for every ON bit of bits, in increasing order
+template<typename Function>
+static void forEachValue(const vector<uint64_t> &bits, Function bitFound) {
+	for (uint64_t i = 0; i < bits.size(); i++) {
+		uint64_t word = bits[i];
+		while (word != 0) {
+			int bit = __builtin_ctzll(word);
+			word &= word - 1;
+			bitFound(bitPosToNum(i * CHUNK_BITS + bit));
+		}
+	}
+}
+
+static const vector<uint64_t> &graphNodes(const struct graphPlanes &planes, bool collapseDoublings) {
+	return collapseDoublings ? planes.heads : planes.plane;
+}
+
+static uint64_t countBits(const vector<uint64_t> &bits) {
+	uint64_t count = 0;
+	for (uint64_t word : bits) {
+		count += __builtin_popcountll(word);
+	}
+	return count;
+}
+
+static void flushGraphWriter(struct graphWriter &writer) {
+	writer.file.write(writer.buffer.data(), writer.buffer.size());
+	writer.buffer.clear();
+	if (!writer.file.good()) {
+		throw runtime_error("Error: couldn't write to '" + writer.config.path + "'");
+	}
+}
+
+static void appendVarint(string &buffer, uint64_t value) {
+	while (value >= 0x80) {
+		buffer += (char)((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	buffer += (char)value;
+}
+
+// Hand rolled, as the text formats are tens of bytes per edge and this is most of the time taken
+static void appendDecimal(string &buffer, uint64_t value) {
+	char digits[20];
+	int count = 0;
+	do {
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	} while (value != 0);
+	while (count > 0) {
+		buffer += digits[--count];
+	}
+}
+
+// "value:powOf3"
+static void appendNodeName(string &buffer, uint64_t value, int powOf3) {
+	appendDecimal(buffer, value);
+	buffer += ':';
+	appendDecimal(buffer, powOf3);
+}
+
+static void writeGraphStart(struct graphWriter &writer) {
+	if (writer.config.format == GRAPH_DOT) {
+		// So a graph of just the start still has it
+		writer.buffer += "digraph g {\n\t\"1:0\";\n";
+	} else if (writer.config.format == GRAPH_GEXF) {
+		writer.buffer +=
+			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			"<gexf xmlns=\"http://gexf.net/1.3\" version=\"1.3\">\n"
+			"\t<graph defaultedgetype=\"directed\">\n"
+			"\t\t<attributes class=\"node\">\n"
+			"\t\t\t<attribute id=\"0\" title=\"value\" type=\"long\"/>\n"
+			"\t\t\t<attribute id=\"1\" title=\"lastPowOf3\" type=\"integer\"/>\n"
+			"\t\t</attributes>\n";
+	} else {
+		// Filled in once the counts are known
+		struct stateGraphFileHeader header;
+		memset(&header, 0, sizeof(header));
+		writer.buffer.append((const char *)&header, sizeof(header));
+	}
+}
+
+static void writeGexfNode(struct graphWriter &writer, uint64_t value, int powOf3) {
+	writer.buffer += "\t\t\t<node id=\"";
+	appendNodeName(writer.buffer, value, powOf3);
+	writer.buffer += "\" label=\"";
+	appendNodeName(writer.buffer, value, powOf3);
+	writer.buffer += "\"><attvalues><attvalue for=\"0\" value=\"";
+	appendDecimal(writer.buffer, value);
+	writer.buffer += "\"/><attvalue for=\"1\" value=\"";
+	appendDecimal(writer.buffer, powOf3);
+	writer.buffer += "\"/></attvalues></node>\n";
+}
+
+static void writePlaneStart(struct graphWriter &writer, int powOf3) {
+	if (writer.config.format == GRAPH_EDGE_LIST) {
+		appendVarint(writer.buffer, 0);
+		appendVarint(writer.buffer, powOf3);
+		writer.lastSource = 0;
+	}
+}
+
+// doublings from source, then an add if add
+static void writeEdge(struct graphWriter &writer, uint64_t source, int powOf3, int doublings, bool add) {
+	uint64_t target = source << doublings;
+	int targetPow = powOf3;
+	if (add) {
+		targetPow++;
+		target += threeToThe(targetPow);
+	}
+	
+	if (writer.config.format == GRAPH_EDGE_LIST) {
+		appendVarint(writer.buffer, source - writer.lastSource + 1);
+		appendVarint(writer.buffer, (uint64_t)doublings << 1 | (add ? 1 : 0));
+		writer.lastSource = source;
+	} else if (writer.config.format == GRAPH_DOT) {
+		writer.buffer += "\t\"";
+		appendNodeName(writer.buffer, source, powOf3);
+		writer.buffer += "\" -> \"";
+		appendNodeName(writer.buffer, target, targetPow);
+		writer.buffer += '"';
+		if (writer.config.collapseDoublings) {
+			writer.buffer += " [weight=";
+			appendDecimal(writer.buffer, doublings);
+			writer.buffer += ", label=\"";
+			appendDecimal(writer.buffer, doublings);
+			writer.buffer += "\"]";
+		}
+		writer.buffer += ";\n";
+	} else {
+		writer.buffer += "\t\t\t<edge id=\"";
+		appendDecimal(writer.buffer, writer.stats.edges);
+		writer.buffer += "\" source=\"";
+		appendNodeName(writer.buffer, source, powOf3);
+		writer.buffer += "\" target=\"";
+		appendNodeName(writer.buffer, target, targetPow);
+		writer.buffer += '"';
+		if (writer.config.collapseDoublings) {
+			writer.buffer += " weight=\"";
+			appendDecimal(writer.buffer, doublings);
+			writer.buffer += '"';
+		}
+		writer.buffer += "/>\n";
+	}
+	
+	writer.stats.edges++;
+	if (writer.buffer.size() >= GRAPH_WRITE_BYTES) flushGraphWriter(writer);
+}
+
+static void writePlaneEdges(struct graphWriter &writer, const struct graphPlanes &planes) {
+	int powOf3 = planes.powOf3;
+	uint64_t max = planes.max;
+	// 0 where there's no next power (that fits)
+	uint64_t nextPower = powOf3 + 1 < 40 && threeToThe(powOf3 + 1) < max ? threeToThe(powOf3 + 1) : 0;
+	
+	writePlaneStart(writer, powOf3);
+	if (writer.config.collapseDoublings) {
+		if (nextPower == 0) return;
+		forEachValue(planes.heads, [&](uint64_t value) {
+			for (int doublings = 0; (value << doublings) <= max - nextPower; doublings++) {
+				writeEdge(writer, value, powOf3, doublings, true);
+			}
+		});
+	} else {
+		forEachValue(planes.plane, [&](uint64_t value) {
+			if (value <= max / 2) writeEdge(writer, value, powOf3, 1, false);
+			if (nextPower != 0 && value <= max - nextPower) writeEdge(writer, value, powOf3, 0, true);
+		});
+	}
+}
+
+static void writeGraphEnd(struct graphWriter &writer) {
+	if (writer.config.format == GRAPH_DOT) {
+		writer.buffer += "}\n";
+	} else if (writer.config.format == GRAPH_GEXF) {
+		writer.buffer += "\t\t</edges>\n\t</graph>\n</gexf>\n";
+	}
+	flushGraphWriter(writer);
+	
+	if (writer.config.format == GRAPH_EDGE_LIST) {
+		struct stateGraphFileHeader header;
+		memcpy(header.magic, STATE_GRAPH_MAGIC, sizeof(STATE_GRAPH_MAGIC));
+		header.max = writer.config.max;
+		header.collapsed = writer.config.collapseDoublings ? 1 : 0;
+		header.nodeCount = writer.stats.nodes;
+		header.edgeCount = writer.stats.edges;
+		writer.file.seekp(0);
+		writer.file.write((const char *)&header, sizeof(header));
+	}
+	
+	writer.file.flush();
+	if (!writer.file.good()) {
+		throw runtime_error("Error: couldn't write to '" + writer.config.path + "'");
+	}
+}
+
+struct stateGraphConfig defaultStateGraphConfig(const string &path, uint64_t max) {
+	auto endsWith = [&](const string &suffix) {
+		return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+	};
+	
+	struct stateGraphConfig config;
+	config.path = path;
+	config.max = max;
+	config.collapseDoublings = false;
+	if (endsWith(".dot") || endsWith(".gv")) {
+		config.format = GRAPH_DOT;
+	} else if (endsWith(".gexf")) {
+		config.format = GRAPH_GEXF;
+	} else {
+		config.format = GRAPH_EDGE_LIST;
+	}
+	return config;
+}
+
+struct stateGraphStats exportStateGraph(struct stateGraphConfig config, const struct stateGraphCallbacks &callbacks) {
+	if (config.max < 1 || config.max > MAX_GRAPH_VALUE) {
+		throw out_of_range(
+			string("Error: the max value of the graph '")
+			+ to_string(config.max)
+			+ "' isn't between 1 and 2^62."
+		);
+	}
+	
+	struct graphWriter writer;
+	writer.config = config;
+	writer.stats.nodes = 0;
+	writer.stats.edges = 0;
+	writer.lastSource = 0;
+	writer.file.open(config.path, ios::binary | ios::trunc);
+	if (!writer.file.is_open()) {
+		throw runtime_error("Error: couldn't open '" + config.path + "' to write the graph to");
+	}
+	writeGraphStart(writer);
+	
+	struct graphPlanes planes;
+	
+	// GEXF wants every node before any edge, so the planes are made once for each
+	if (config.format == GRAPH_GEXF) {
+		writer.buffer += "\t\t<nodes>\n";
+		initGraphPlanes(planes, config.max);
+		while (makeNextPlane(planes)) {
+			forEachValue(graphNodes(planes, config.collapseDoublings), [&](uint64_t value) {
+				writeGexfNode(writer, value, planes.powOf3);
+				if (writer.buffer.size() >= GRAPH_WRITE_BYTES) flushGraphWriter(writer);
+			});
+		}
+		writer.buffer += "\t\t</nodes>\n\t\t<edges>\n";
+	}
+	
+	initGraphPlanes(planes, config.max);
+	while (makeNextPlane(planes)) {
+		uint64_t nodes = countBits(graphNodes(planes, config.collapseDoublings));
+		uint64_t edgesBefore = writer.stats.edges;
+		writePlaneEdges(writer, planes);
+		writer.stats.nodes += nodes;
+		
+		if (callbacks.planeWritten) {
+			callbacks.planeWritten(planes.powOf3, nodes, writer.stats.edges - edgesBefore);
+		}
+	}
+	
+	writeGraphEnd(writer);
+	return writer.stats;
+}
+
+struct graphReader {
+	string path;
+	ifstream file;
+	vector<char> buffer;
+	uint64_t position;
+	uint64_t filled;
+};
+
+// Returns false at the end of the file (but throws if it ends partway through the varint)
+static bool readVarint(struct graphReader &reader, uint64_t *value) {
+	*value = 0;
+	for (int shift = 0; true; shift += 7) {
+		if (reader.position == reader.filled) {
+			reader.file.read(reader.buffer.data(), reader.buffer.size());
+			reader.filled = reader.file.gcount();
+			reader.position = 0;
+			if (reader.filled == 0) {
+				if (shift == 0) return false;
+				throw runtime_error("Error: '" + reader.path + "' has been cut short");
+			}
+		}
+		if (shift > 63) {
+			throw runtime_error("Error: '" + reader.path + "' has a number too big for 64 bits");
+		}
+		
+		uint8_t byte = reader.buffer[reader.position++];
+		*value |= (uint64_t)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) return true;
+	}
+}
+
+struct stateGraphFileHeader readStateGraphEdges(const string &path, const function<void(const struct stateGraphEdge &edge)> &edgeRead) {
+	struct graphReader reader;
+	reader.path = path;
+	reader.file.open(path, ios::binary);
+	if (!reader.file.is_open()) {
+		throw runtime_error("Error: couldn't open '" + path + "'");
+	}
+	
+	struct stateGraphFileHeader header;
+	reader.file.read((char *)&header, sizeof(header));
+	if (!reader.file.good() || memcmp(header.magic, STATE_GRAPH_MAGIC, sizeof(STATE_GRAPH_MAGIC)) != 0) {
+		throw runtime_error("Error: '" + path + "' isn't a state graph edge list");
+	}
+	reader.buffer.resize(GRAPH_READ_BYTES);
+	reader.position = 0;
+	reader.filled = 0;
+	
+	auto corrupt = [&]() {
+		return runtime_error("Error: '" + path + "' isn't a valid state graph edge list");
+	};
+	
+	struct stateGraphEdge edge;
+	edge.sourcePow = -1;
+	uint64_t lastSource = 0;
+	uint64_t edgeCount = 0;
+	uint64_t gap;
+	while (readVarint(reader, &gap)) {
+		if (gap == 0) {
+			uint64_t powOf3;
+			if (!readVarint(reader, &powOf3) || powOf3 >= 39) throw corrupt();
+			edge.sourcePow = powOf3;
+			lastSource = 0;
+			continue;
+		}
+		
+		uint64_t code;
+		if (!readVarint(reader, &code)) throw corrupt();
+		edge.source = lastSource + gap - 1;
+		edge.doublings = code >> 1;
+		if (edge.sourcePow < 0 || edge.source < lastSource || edge.source == 0 || edge.doublings > 62
+			|| edge.source > (header.max >> edge.doublings)) {
+			throw corrupt();
+		}
+		
+		edge.target = edge.source << edge.doublings;
+		edge.targetPow = edge.sourcePow;
+		if (code & 1) {
+			edge.targetPow++;
+			edge.target += threeToThe(edge.targetPow);
+		}
+		lastSource = edge.source;
+		edgeCount++;
+		edgeRead(edge);
+	}
+	
+	if (edgeCount != header.edgeCount) {
+		throw runtime_error("Error: '" + path + "' has been cut short");
+	}
+	return header;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+#ifndef STATE_GRAPH_EXPORTER_H
+#define STATE_GRAPH_EXPORTER_H
+
+// Writes the graph of states reachable from (1, 3^0) up to max, for layout tools. A node is
+// (value, k), for 3^k being the last power added, named "value:k" as in the Prolog's .gv files, and
+// the edges are the two steps, doubling to (2 * value, k) and adding to (value + 3^(k + 1), k + 1),
+// wherever they stay <= max. Unlike the Prolog's makeGraphUpTo(), the steps aren't also followed
+// backwards, and nothing is searched for, so the graph is complete whatever the size.
+//
+// The states with 3^k as the last power are a plane of bits in the sieve's layout (multiples of 3
+// omitted, which no state's value ever is). Adding 3^(k + 1) moves every bit of plane k the same
+// 2 * 3^k bits along, so plane k + 1 is plane k shifted, plus every doubling of what's already in
+// it, which are further along. Only one plane is kept, with the bits of it that add steps land on
+// (the heads), about max / 6 bytes in all, and the graph is written out plane by plane as each is
+// made.
+//
+// With collapseDoublings, the chain of doublings from each state an add step lands on (or the
+// start) is folded into that state: the nodes are just those states, and each has an edge to
+// (2^j * value + 3^(k + 1), k + 1) weighted j, for every j where that's <= max.
+//
+// Formats:
+//  - GRAPH_DOT: a digraph, with weight & label attributes when collapsed
+//  - GRAPH_GEXF: GEXF 1.3, nodes (with value & k attributes) then edges, so the planes are made twice
+//  - GRAPH_EDGE_LIST: a stateGraphFileHeader (written last), then each plane's edges as varints:
+//    0 then k to start plane k, then for each edge the gap from the previous edge's source value
+//    (or from 0) plus 1, then (doublings << 1 | 1 if it ends with an add). The targets follow from
+//    those. Every node but (1, 0) is the target of an edge, so nothing else is needed. About 2.5
+//    bytes per edge.
+
+enum graphFormat {
+	GRAPH_DOT,
+	GRAPH_GEXF,
+	GRAPH_EDGE_LIST
+};
+
+const char STATE_GRAPH_MAGIC[8] = { 'T', 'T', 'D', 'E', 'D', 'G', 'E', '1' };
+
+struct stateGraphFileHeader {
+	char magic[8];
+	uint64_t max;
+	uint64_t collapsed;
+	uint64_t nodeCount;
+	uint64_t edgeCount;
+};
+
+struct stateGraphConfig {
+	std::string path;
+	enum graphFormat format;
+	uint64_t max;
+	bool collapseDoublings;
+};
+
+// Any of these can be left empty
+struct stateGraphCallbacks {
+	// Called after the edges out of every state with 3^powOf3 as the last power have been written
+	std::function<void(int powOf3, uint64_t nodes, uint64_t edges)> planeWritten;
+};
+
+struct stateGraphStats {
+	uint64_t nodes;
+	uint64_t edges;
+};
+
+// DOT for paths ending ".dot" or ".gv", GEXF for ".gexf", otherwise an edge list. Not collapsed.
+struct stateGraphConfig defaultStateGraphConfig(const std::string &path, uint64_t max);
+
+// Throws std::out_of_range for a max below 1 or past 2^62, and std::runtime_error if the file
+// can't be written
+struct stateGraphStats exportStateGraph(struct stateGraphConfig config, const struct stateGraphCallbacks &callbacks);
+
+struct stateGraphEdge {
+	uint64_t source;
+	int sourcePow;
+	uint64_t target;
+	int targetPow;
+	int doublings; // from source, before the add if there is one
+};
+
+// Calls edgeRead for every edge in an edge list file, in the order written. Throws
+// std::runtime_error if the file can't be read or isn't an edge list.
+struct stateGraphFileHeader readStateGraphEdges(const std::string &path, const std::function<void(const struct stateGraphEdge &edge)> &edgeRead);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,339 @@
+#include "column-kernels.h"
+#include "column-store.h"
+#include "tile-renderer.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The most a stored (uncompressed) deflate block can hold
+const uint64_t MAX_STORED_BLOCK = 65535;
+
+// Adler-32 sums can be left this many bytes before they're reduced, without overflowing 32 bits
+const uint64_t ADLER_BYTES_PER_REDUCTION = 5552;
+
+const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+struct imageWriter {
+	struct tileRendererConfig config;
+	ofstream file;
+	uint32_t crcTable[256];
+	uint32_t adlerA;
+	uint32_t adlerB;
+	vector<uint8_t> chunkData; // of the PNG chunk being written
+};
+
+static void initCrcTable(struct imageWriter &writer) {
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 1) ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+		}
+		writer.crcTable[i] = crc;
+	}
+}
+
+static void appendBigEndian32(vector<uint8_t> &data, uint32_t value) {
+	data.push_back(value >> 24);
+	data.push_back(value >> 16);
+	data.push_back(value >> 8);
+	data.push_back(value);
+}
+
+// Writes writer.chunkData as a PNG chunk of the given type
+static void writePngChunk(struct imageWriter &writer, const char *type) {
+	vector<uint8_t> lengthAndType;
+	appendBigEndian32(lengthAndType, writer.chunkData.size());
+	lengthAndType.insert(lengthAndType.end(), type, type + 4);
+	
+	uint32_t crc = 0xffffffff;
+	for (int i = 4; i < 8; i++) {
+		crc = writer.crcTable[(crc ^ lengthAndType[i]) & 0xff] ^ (crc >> 8);
+	}
+	for (uint8_t byte : writer.chunkData) {
+		crc = writer.crcTable[(crc ^ byte) & 0xff] ^ (crc >> 8);
+	}
+	
+	vector<uint8_t> crcBytes;
+	appendBigEndian32(crcBytes, crc ^ 0xffffffff);
+	
+	writer.file.write((const char *)lengthAndType.data(), lengthAndType.size());
+	writer.file.write((const char *)writer.chunkData.data(), writer.chunkData.size());
+	writer.file.write((const char *)crcBytes.data(), crcBytes.size());
+}
+
+static void updateAdler(struct imageWriter &writer, const uint8_t *bytes, uint64_t count) {
+	while (count > 0) {
+		uint64_t n = min(count, ADLER_BYTES_PER_REDUCTION);
+		for (uint64_t i = 0; i < n; i++) {
+			writer.adlerA += bytes[i];
+			writer.adlerB += writer.adlerA;
+		}
+		writer.adlerA %= 65521;
+		writer.adlerB %= 65521;
+		bytes += n;
+		count -= n;
+	}
+}
+
+static void writeImageHeader(struct imageWriter &writer, struct tileSize size) {
+	bool grey = writer.config.reduction == TILE_POPCOUNT;
+	
+	if (writer.config.format == TILE_NETPBM) {
+		writer.file << (grey ? "P5\n" : "P4\n") << size.width << " " << size.height << "\n";
+		if (grey) writer.file << "255\n";
+		return;
+	}
+	
+	writer.file.write((const char *)PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
+	
+	writer.chunkData.clear();
+	appendBigEndian32(writer.chunkData, size.width);
+	appendBigEndian32(writer.chunkData, size.height);
+	writer.chunkData.push_back(grey ? 8 : 1); // bit depth
+	writer.chunkData.push_back(0); // greyscale
+	writer.chunkData.push_back(0); // deflate
+	writer.chunkData.push_back(0); // no filtering beyond the per-row filter type
+	writer.chunkData.push_back(0); // not interlaced
+	writePngChunk(writer, "IHDR");
+	
+	// The zlib stream header (deflate, 32K window, no preset dictionary) goes at the front of the
+	// first row's IDAT
+	writer.chunkData.clear();
+	writer.chunkData.push_back(0x78);
+	writer.chunkData.push_back(0x01);
+	writer.adlerA = 1;
+	writer.adlerB = 0;
+}
+
+// pixels is a row in the netpbm layout, where an ON bit is black
+static void writeImageRow(struct imageWriter &writer, vector<uint8_t> &pixels) {
+	if (writer.config.format == TILE_NETPBM) {
+		writer.file.write((const char *)pixels.data(), pixels.size());
+		return;
+	}
+	
+	// A 1-bit PNG has 0 as black. Each row starts with its filter type, 0 for none.
+	if (writer.config.reduction == TILE_OR) {
+		for (uint8_t &byte : pixels) byte = ~byte;
+	}
+	pixels.insert(pixels.begin(), 0);
+	updateAdler(writer, pixels.data(), pixels.size());
+	
+	// Each row is one IDAT of as many stored blocks as it takes, none of them final, so nothing has
+	// to be held back until the last row is known
+	for (uint64_t first = 0; first < pixels.size(); first += MAX_STORED_BLOCK) {
+		uint64_t length = min(MAX_STORED_BLOCK, pixels.size() - first);
+		writer.chunkData.push_back(0x00);
+		writer.chunkData.push_back(length & 0xff);
+		writer.chunkData.push_back(length >> 8);
+		writer.chunkData.push_back(~length & 0xff);
+		writer.chunkData.push_back((~length >> 8) & 0xff);
+		writer.chunkData.insert(writer.chunkData.end(), pixels.begin() + first, pixels.begin() + first + length);
+	}
+	writePngChunk(writer, "IDAT");
+	writer.chunkData.clear();
+}
+
+static void finishImage(struct imageWriter &writer) {
+	if (writer.config.format == TILE_PNG) {
+		// An empty final stored block, then the Adler-32 of everything
+		writer.chunkData.clear();
+		writer.chunkData.push_back(0x01);
+		writer.chunkData.push_back(0x00);
+		writer.chunkData.push_back(0x00);
+		writer.chunkData.push_back(0xff);
+		writer.chunkData.push_back(0xff);
+		appendBigEndian32(writer.chunkData, (writer.adlerB << 16) | writer.adlerA);
+		writePngChunk(writer, "IDAT");
+		
+		writer.chunkData.clear();
+		writePngChunk(writer, "IEND");
+	}
+	
+	writer.file.flush();
+	if (!writer.file.good()) {
+		throw runtime_error("Error: couldn't write to '" + writer.config.path + "'");
+	}
+}
+
+// Word wordNum of the source, in the aggregate's layout
+static uint64_t getSourceWord(struct tileSource &source, uint64_t wordNum) {
+	if (source.store != nullptr) {
+		if (wordNum >= source.store->header.chunkCount) return 0;
+		
+		uint64_t chunksPerBlock = source.store->header.chunksPerBlock;
+		uint64_t blockNum = wordNum / chunksPerBlock;
+		if (blockNum != source.blockNum) {
+			readStoreBlock(source.store, source.powOf3, blockNum, source.block.data());
+			source.blockNum = blockNum;
+		}
+		return source.block[wordNum % chunksPerBlock];
+	}
+	
+	uint64_t chunksOffset = source.bitOffset / CHUNK_BITS;
+	int bitsOffset = source.bitOffset % CHUNK_BITS;
+	if (wordNum < chunksOffset) return 0;
+	
+	uint64_t chunkNum = wordNum - chunksOffset;
+	uint64_t word = chunkNum < source.chunkCount ? source.chunks[chunkNum] << bitsOffset : 0;
+	if (bitsOffset != 0 && chunkNum > 0 && chunkNum - 1 < source.chunkCount) {
+		word |= source.chunks[chunkNum - 1] >> (CHUNK_BITS - bitsOffset);
+	}
+	return word;
+}
+
+// ON bits at positions [lowBit, highBit)
+static uint64_t countOnBits(struct tileSource &source, uint64_t lowBit, uint64_t highBit) {
+	uint64_t count = 0;
+	while (lowBit < highBit) {
+		int shift = lowBit % CHUNK_BITS;
+		uint64_t bits = min(highBit - lowBit, (uint64_t)(CHUNK_BITS - shift));
+		
+		uint64_t word = getSourceWord(source, lowBit / CHUNK_BITS) >> shift;
+		if (bits < CHUNK_BITS) word &= (1ULL << bits) - 1;
+		
+		count += __builtin_popcountll(word);
+		lowBit += bits;
+	}
+	return count;
+}
+
+// Bits for the values below value, i.e. the values in [1, value) that aren't multiples of 3
+static uint64_t bitsBelow(uint64_t value) {
+	return (value - 1) - (value - 1) / 3;
+}
+
+struct tileSource tileSourceFromChunks(const uint64_t *chunks, uint64_t chunkCount, uint64_t bitOffset, uint64_t maxValue) {
+	struct tileSource source;
+	source.chunks = chunks;
+	source.chunkCount = chunkCount;
+	source.bitOffset = bitOffset;
+	source.store = nullptr;
+	source.powOf3 = 0;
+	source.blockNum = UINT64_MAX;
+	source.maxValue = maxValue;
+	return source;
+}
+
+struct tileSource tileSourceFromStore(struct columnStoreReader *store, int powOf3) {
+	if (powOf3 != STORE_AGGREGATE && (powOf3 < 0 || (uint64_t)powOf3 >= store->header.columnCount)) {
+		throw out_of_range("Error: the column store only has columns 3^0 to 3^" + to_string(store->header.columnCount - 1));
+	}
+	
+	struct tileSource source;
+	source.chunks = nullptr;
+	source.chunkCount = 0;
+	source.bitOffset = 0;
+	source.store = store;
+	source.powOf3 = powOf3;
+	source.block.resize(store->header.chunksPerBlock);
+	source.blockNum = UINT64_MAX;
+	source.maxValue = store->header.maxValue;
+	return source;
+}
+
+struct tileRendererConfig defaultTileRendererConfig(const string &path, uint64_t rowWidth) {
+	struct tileRendererConfig config;
+	config.path = path;
+	bool png = path.size() >= 4 && path.compare(path.size() - 4, 4, ".png") == 0;
+	config.format = png ? TILE_PNG : TILE_NETPBM;
+	config.reduction = TILE_OR;
+	config.firstValue = 1;
+	config.rowWidth = rowWidth;
+	config.zoom = 1;
+	config.rows = 0;
+	return config;
+}
+
+struct tileSize renderTile(struct tileRendererConfig config, struct tileSource &source) {
+	if (config.firstValue < 1) {
+		throw out_of_range("firstValue < 1");
+	}
+	if (config.rowWidth < 1) {
+		throw out_of_range("rowWidth < 1");
+	}
+	if (config.zoom < 1) {
+		throw out_of_range("zoom < 1");
+	}
+	
+	uint64_t rowsAvailable = config.firstValue > source.maxValue ? 0 : (source.maxValue - config.firstValue + 1) / config.rowWidth;
+	if (config.rows == 0) {
+		config.rows = rowsAvailable;
+	} else if (config.rows > rowsAvailable) {
+		throw out_of_range(
+			string("Error: ")
+			+ to_string(config.rows)
+			+ " rows of "
+			+ to_string(config.rowWidth)
+			+ " values go past the max value stored '"
+			+ to_string(source.maxValue)
+			+ "'."
+		);
+	}
+	
+	struct tileSize size;
+	size.width = (config.rowWidth + config.zoom - 1) / config.zoom;
+	size.height = config.rows / config.zoom;
+	if (size.height == 0) {
+		throw out_of_range("Error: there isn't a whole row of pixels below the max value stored '" + to_string(source.maxValue) + "'");
+	}
+	
+	struct imageWriter writer;
+	writer.config = config;
+	writer.file.open(config.path, ios::binary | ios::trunc);
+	if (!writer.file.is_open()) {
+		throw runtime_error("Error: couldn't open '" + config.path + "' to write the image to");
+	}
+	initCrcTable(writer);
+	writeImageHeader(writer, size);
+	
+	vector<uint64_t> onCounts(size.width);
+	vector<uint64_t> bitCounts(size.width);
+	vector<uint8_t> pixels;
+	
+	for (uint64_t pixelRow = 0; pixelRow < size.height; pixelRow++) {
+		fill(onCounts.begin(), onCounts.end(), 0);
+		fill(bitCounts.begin(), bitCounts.end(), 0);
+		
+		// The zoom rows of values this row of pixels covers are one after another, so the source
+		// is read in order
+		for (uint64_t row = pixelRow * config.zoom; row < (pixelRow + 1) * config.zoom; row++) {
+			uint64_t rowStart = config.firstValue + row * config.rowWidth;
+			uint64_t rowEnd = rowStart + config.rowWidth;
+			
+			for (uint64_t x = 0; x < size.width; x++) {
+				uint64_t low = rowStart + x * config.zoom;
+				uint64_t high = min(low + config.zoom, rowEnd);
+				
+				uint64_t lowBit = bitsBelow(low);
+				uint64_t highBit = bitsBelow(high);
+				onCounts[x] += countOnBits(source, lowBit, highBit);
+				bitCounts[x] += highBit - lowBit;
+			}
+		}
+		
+		if (config.reduction == TILE_OR) {
+			pixels.assign((size.width + 7) / 8, 0);
+			for (uint64_t x = 0; x < size.width; x++) {
+				if (onCounts[x] != 0) pixels[x / 8] |= 0x80 >> (x % 8);
+			}
+		} else {
+			pixels.resize(size.width);
+			for (uint64_t x = 0; x < size.width; x++) {
+				// rounded to the nearest level, with a pixel of only multiples of 3 left white
+				uint64_t level = bitCounts[x] == 0 ? 0 : (255 * onCounts[x] + bitCounts[x] / 2) / bitCounts[x];
+				pixels[x] = 255 - level;
+			}
+		}
+		
+		writeImageRow(writer, pixels);
+	}
+	
+	finishImage(writer);
+	return size;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "column-store.h"
+
+#ifndef TILE_RENDERER_H
+#define TILE_RENDERER_H
+
+// Pictures of a column or the aggregate, as PBM/PGM or PNG, written straight from the bits rather
+// than from printed text (as v11's "3^7 column sample" files were). Value v is at column
+// (v - firstValue) % rowWidth, row (v - firstValue) / rowWidth, so a rowWidth of 3^k lines up
+// values that differ by a multiple of 3^k, which is where the column patterns repeat.
+//
+// Each pixel is a zoom x zoom square of those values, reduced to:
+//  - TILE_OR: black if any is ON (1-bit PBM or PNG)
+//  - TILE_POPCOUNT: a grey level for the fraction that are ON, from white for none to black for
+//    all (8-bit PGM or PNG). Multiples of 3 can never be ON, so they aren't counted.
+// At zoom 1 both are just the bits, ON in black.
+//
+// The picture is made one row of pixels at a time, from a word of the bits at a time, so the only
+// memory used is a row of pixels and (from a column store) one decoded block. A pixel covering
+// whole words of bits is counted with popcounts, so once zoomed out, 10^10 values take seconds.
+// PNGs are written with uncompressed deflate blocks, as there's no zlib here; they can be made far
+// smaller afterwards by any image tool.
+
+enum tileReduction {
+	TILE_OR,
+	TILE_POPCOUNT
+};
+
+enum tileFormat {
+	TILE_NETPBM, // PBM for TILE_OR, PGM for TILE_POPCOUNT
+	TILE_PNG
+};
+
+// The bits to render, in the aggregate's layout (multiples of 3 omitted, bit numToBitPos(value)).
+// Read in increasing order only.
+struct tileSource {
+	// In memory (e.g. a columnSieve's expRegCol or colsAggregate): bit i of chunks is bit
+	// i + bitOffset of the aggregate, and anything past chunkCount chunks is OFF.
+	const uint64_t *chunks;
+	uint64_t chunkCount;
+	uint64_t bitOffset;
+	
+	// Otherwise, column powOf3 (or STORE_AGGREGATE) of a column store, a block at a time
+	struct columnStoreReader *store;
+	int powOf3;
+	std::vector<uint64_t> block;
+	uint64_t blockNum; // of the block decoded, or UINT64_MAX for none
+	
+	uint64_t maxValue;
+};
+
+struct tileRendererConfig {
+	std::string path;
+	enum tileFormat format;
+	enum tileReduction reduction;
+	uint64_t firstValue; // >= 1
+	uint64_t rowWidth; // in values
+	uint64_t zoom; // values along each side of a pixel
+	
+	// Rows of values (not pixels) to render, rounded down to a multiple of zoom. 0 renders every
+	// whole row of pixels up to the source's max value.
+	uint64_t rows;
+};
+
+struct tileSize {
+	uint64_t width; // pixels
+	uint64_t height;
+};
+
+struct tileSource tileSourceFromChunks(const uint64_t *chunks, uint64_t chunkCount, uint64_t bitOffset, uint64_t maxValue);
+
+// The store has to stay open until the source is finished with
+struct tileSource tileSourceFromStore(struct columnStoreReader *store, int powOf3);
+
+// PNG if path ends in ".png", otherwise netpbm. Everything from the first value, at zoom 1 with TILE_OR.
+struct tileRendererConfig defaultTileRendererConfig(const std::string &path, uint64_t rowWidth);
+
+// Throws std::out_of_range if the rows asked for go past the source's max value (or there isn't a
+// whole row of pixels below it), and std::runtime_error if the file can't be written
+struct tileSize renderTile(struct tileRendererConfig config, struct tileSource &source);
+
+#endif
\ No newline at end of file
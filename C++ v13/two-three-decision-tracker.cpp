@@ -0,0 +1,38 @@
+// C# version has more comments & explanation; this is just the same thing with some further optimisations
+
+#include "math-utils.h"
+#include "two-three-decision-tracker.h"
+#include <stdexcept>
+#include <stdint.h>
+
+using namespace std;
+
+void initDecisionTracker(struct decisionTracker *tracker, uint64_t maximum) {
+	// Checked once here, so that threeToThe() doesn't need to on every tryAddNextPowerOf3()
+	if (getRequiredCapacity(maximum) > 40) {
+		throw out_of_range("Error: max too large, would overflow in 3^n function");
+	}
+	
+	tracker->max = maximum;
+	tracker->capacity = getRequiredCapacity(maximum);
+	tracker->doublingsSinceLastPowerOfThree = new int[tracker->capacity]();
+	tracker->count = 1;
+	tracker->current = 1;
+	tracker->repeatedDoublingOps = 0;
+}
+
+void destructDecisionTracker(struct decisionTracker *tracker) {
+	delete[] tracker->doublingsSinceLastPowerOfThree;
+	tracker->doublingsSinceLastPowerOfThree = nullptr;
+}
+
+int getRequiredCapacity(uint64_t max) {
+	uint64_t x = 1;
+	int i = 1;
+	while (x <= max) {
+		if (i >= 40) return i + 1; // past the end of threePowers, which initDecisionTracker() rejects
+		x += threeToThe(i);
+		i++;
+	}
+	return i; //might be one higher than needed, idk, but that's fine anyway
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+// C# version has more comments & explanation; this is the same thing as in v3, but with the
+// state held in a struct rather than globals, so each search (or thread) can have its own
+
+#include <stdint.h>
+#include "math-utils.h"
+
+#ifndef TWO_THREE_DECISION_TRACKER_H
+#define TWO_THREE_DECISION_TRACKER_H
+
+struct decisionTracker {
+	uint64_t max;
+	int *doublingsSinceLastPowerOfThree;
+	int capacity;
+	int count;
+	uint64_t current;
+	
+	uint64_t repeatedDoublingOps;
+};
+
+void initDecisionTracker(struct decisionTracker *tracker, uint64_t maximum);
+void destructDecisionTracker(struct decisionTracker *tracker);
+int getRequiredCapacity(uint64_t max);
+
+inline bool trackerAtRoot(const struct decisionTracker *tracker) {
+	return tracker->count == 1 && tracker->doublingsSinceLastPowerOfThree[0] == 0;
+}
+
+// Back at the point just after 3^(rootCount - 1) was added, for walking a subtree that starts there
+inline bool trackerAtSubtreeRoot(const struct decisionTracker *tracker, int rootCount) {
+	return tracker->count == rootCount && tracker->doublingsSinceLastPowerOfThree[rootCount - 1] == 0;
+}
+
+inline int lastAddedThreeExponent(const struct decisionTracker *tracker) {
+	return tracker->count - 1;
+}
+
+inline void doubleNTimes(struct decisionTracker *tracker, int n) {
+	tracker->doublingsSinceLastPowerOfThree[tracker->count - 1] += n;
+	tracker->current <<= n;
+}
+
+inline void halve(struct decisionTracker *tracker) {
+	tracker->doublingsSinceLastPowerOfThree[tracker->count - 1]--;
+	tracker->current /= 2;
+}
+
+inline bool tryAddNextPowerOf3(struct decisionTracker *tracker) {
+	uint64_t next = tracker->current + threeToThe(tracker->count);
+	if (next <= tracker->max) {
+		tracker->count++;
+		tracker->current = next;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+inline bool backtrackAndCheckIfWasDoublingOp(struct decisionTracker *tracker) {
+	if (tracker->doublingsSinceLastPowerOfThree[tracker->count - 1] > 0) {
+		tracker->current /= 2;
+		tracker->doublingsSinceLastPowerOfThree[tracker->count - 1]--;
+		return true;
+	} else {
+		tracker->count--;
+		tracker->current -= threeToThe(tracker->count);
+		return false;
+	}
+}
+
+inline int getNumDoublingsBeforeExceedingMax(const struct decisionTracker *tracker) {
+	return (int)floorLog2_64bit(tracker->max / tracker->current);
+}
+
+inline void doubleRepeatedlyUpToMax(struct decisionTracker *tracker) {
+	tracker->repeatedDoublingOps++;
+	doubleNTimes(tracker, getNumDoublingsBeforeExceedingMax(tracker));
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,986 @@
+// Command line front end for the library, printing the same "found zero:" lines as v12
+//
+// Usage:
+//   a.out [sieve [colLength]]   - column sieve (v12 engine), colLength in 64-bit chunks
+//   a.out dfs max [threads]     - depth first search (C++/ and v3 engine) up to max, on every core by default
+//   a.out ms M S [colLength]    - column sieve for multiplier M (2 to 4) and summand S (2 to 7)
+//   a.out wheel M S [colLength] - same, but only storing the residue classes detectResidueWheel() finds
+//   a.out increasing M S max [values|zeros] - the variant multiplying by M^n on the n-th multiply (see increasing-multiplier.h), printing counts,
+//                               and every reachable value & its path count, or every zero in a class mod S that can be reached, if asked
+//   a.out sweep maxM maxS maxZ [threads] - zeros up to maxZ for every M from 2 to maxM & S from 2 to maxS, as a CSV row per pair (see ms-sweep.h)
+//   a.out count [colLength [countsFile]] - path counts (see path-count-sieve.h), printing values with exactly 1 path & a histogram
+//   a.out backward Z [Z ...]    - whether each Z (up to 2^128 - 1) is reachable, by searching backwards from it
+//   a.out batch file [threads]  - same for every value in a file (one per line), in parallel
+//   a.out paths Z [Z ...]       - the number of paths to each Z (up to 2^128 - 1), counted backwards from it
+//   a.out mitm [count] Z [Z ...] - whether each Z is reachable (or the number of paths), meeting a table of small values in the middle
+//   a.out window lo hi [count] - zeros (or a histogram of path counts) in [lo, hi] only, for hi up to 2^63 - 1
+//   a.out store file [colLength] - column sieve, also writing every column & the aggregate to file (see column-store.h)
+//   a.out stored file Z [Z ...] - which columns in a file written by store reach each Z, reading just the blocks holding Z
+//   a.out render file k|agg out rowWidth [zoom [popcount]] - picture of column 3^k or the aggregate from a file written by store (see tile-renderer.h)
+//   a.out image k|agg out rowWidth [zoom [popcount [colLength]]] - same, from a column sieve run's memory
+//                               (out is PNG if it ends in .png, otherwise PBM/PGM, and rowWidth can be given as 3^k)
+//   a.out results file [colLength [countColLength]] - column sieve (and path counts, if countColLength is given), writing the final results to file (see result-set.h)
+//                               and a rank index of them to file.rank (see rank-index.h)
+//   a.out rank file [x ...]     - reachable values & zeros up to each power of 10 (and each x) in a file written by results
+//   a.out nth file n [n ...]    - the n-th reachable value and n-th zero in a file written by results
+//   a.out serve file socket     - answers queries about a file written by results on a Unix domain socket (see query-daemon.h), until interrupted
+//   a.out graph max out [collapse] - the graph of (value, last power) states up to max (see state-graph-exporter.h), as DOT if out ends in .dot or .gv,
+//                               GEXF if .gexf, otherwise a binary edge list, with chains of doublings folded into weighted edges if collapse is given
+//   a.out from max v:k [v:k ...] [labels] [zeros] - everything reachable up to max from the states (v, 3^k) (see multi-source-sieve.h), with counts per
+//                               starting state if labels is given, and every zero printed if zeros is
+
+#include "math-utils.h"
+#include "backward-path-count.h"
+#include "backward-search.h"
+#include "batch-verifier.h"
+#include "column-sieve.h"
+#include "column-store.h"
+#include "decision-tree-search.h"
+#include "increasing-multiplier.h"
+#include "meet-in-the-middle.h"
+#include "ms-column-sieve.h"
+#include "ms-sweep.h"
+#include "multi-source-sieve.h"
+#include "path-count-sieve.h"
+#include "query-daemon.h"
+#include "rank-index.h"
+#include "residue-wheel.h"
+#include "result-set.h"
+#include "state-graph-exporter.h"
+#include "tile-renderer.h"
+#include "wheel-column-sieve.h"
+#include "window-search.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void printTime() {
+	time_t time_now = chrono::system_clock::to_time_t(chrono::system_clock::now());
+	
+	// from https://stackoverflow.com/a/44360248/4149474 and https://stackoverflow.com/a/9101683/4149474
+	auto gmt_time = gmtime(&time_now);
+	auto timestamp = std::put_time(gmt_time, "%c");
+	cout << timestamp;
+}
+
+void printFoundZero(uint64_t value) {
+	cout << "\r";
+	printTime();
+	cout << ": found zero: " << value << endl;
+}
+
+// Column 0 is set up inside runColumnSieve(), and never reported, so it's made separately
+vector<uint64_t> makePowersOf2Column(const struct columnSieve *sieve) {
+	vector<uint64_t> powersOf2(sieve->config.colLength, 0);
+	for (uint64_t i = 1; i <= sieve->maxValueRepresentable; i *= 2) {
+		powersOf2[numToBitPos(i) / CHUNK_BITS] |= 1ULL << (numToBitPos(i) % CHUNK_BITS);
+		if (i > sieve->maxValueRepresentable / 2) break;
+	}
+	return powersOf2;
+}
+
+// With a storePath, every column and the aggregate are also written there as a column store
+void findAndPrintZeros_sieve(struct columnSieveConfig config, const string &storePath) {
+	struct columnSieve *sieve = createColumnSieve(config);
+	
+	cout << "Col length = " << config.colLength << "\r\n";
+	cout << "Max value representable = " << sieve->maxValueRepresentable << "\r\n";
+	cout << "\r\n";
+	
+	struct columnStoreWriter *store = nullptr;
+	if (!storePath.empty()) {
+		store = createColumnStoreWriter(defaultColumnStoreConfig(storePath), config.colLength, sieve->maxValueRepresentable);
+		
+		vector<uint64_t> powersOf2 = makePowersOf2Column(sieve);
+		writeStoreColumn(store, 0, powersOf2.data(), 0);
+	}
+	
+	struct columnSieveCallbacks callbacks;
+	callbacks.zeroFound = printFoundZero;
+	callbacks.columnFinished = [sieve, store](int powOf3, uint64_t firstValueRepresented) {
+		cout << "\r";
+		printTime();
+		cout << ": finished column for shift of 3^" << powOf3 << endl;
+		
+		// The column's bit 0 is firstValueRepresented
+		if (store != nullptr) {
+			writeStoreColumn(store, powOf3, sieve->expRegCol, numToBitPos(firstValueRepresented));
+		}
+	};
+	// Note: Don't print progress too often, or flush, as either may slow things
+	callbacks.progress = [](int powOf3, uint64_t chunk) {
+		cout << "\r" << "at: " << powOf3 << ", " << (chunk * 64);
+	};
+	
+	runColumnSieve(sieve, callbacks);
+	
+	cout << endl;
+	printTime();
+	cout << ": finished computing aggregate" << endl;
+	
+	if (store != nullptr) {
+		writeStoreAggregate(store, sieve->colsAggregate);
+		finishColumnStore(store);
+		cout << "Column store written to '" << storePath << "'" << endl;
+		destroyColumnStoreWriter(store);
+	}
+	
+	destroyColumnSieve(sieve);
+}
+
+void printStoredColumns(const string &storePath, int valueCount, char **values) {
+	struct columnStoreReader *store = openColumnStore(storePath);
+	
+	cout << "Max value stored = " << store->header.maxValue << "\r\n";
+	cout << "Columns = 3^0 to 3^" << (store->header.columnCount - 1) << "\r\n";
+	cout << "\r\n";
+	
+	for (int i = 0; i < valueCount; i++) {
+		uint64_t value = strtoull(values[i], nullptr, 10);
+		
+		cout << value << ": " << (isSetInStore(store, STORE_AGGREGATE, value) ? "reachable" : "zero");
+		string separator = ", with last power ";
+		for (uint64_t powOf3 = 0; powOf3 < store->header.columnCount; powOf3++) {
+			if (isSetInStore(store, (int)powOf3, value)) {
+				cout << separator << "3^" << powOf3;
+				separator = ", ";
+			}
+		}
+		cout << endl;
+	}
+	
+	closeColumnStore(store);
+}
+
+void printTileRendered(const struct tileRendererConfig &config, struct tileSize size) {
+	printTime();
+	cout << ": wrote " << size.width << " x " << size.height << " image to '" << config.path << "'" << endl;
+}
+
+void renderStoredTile(const string &storePath, int powOf3, struct tileRendererConfig config) {
+	struct columnStoreReader *store = openColumnStore(storePath);
+	struct tileSource source = tileSourceFromStore(store, powOf3);
+	
+	printTileRendered(config, renderTile(config, source));
+	
+	closeColumnStore(store);
+}
+
+// Renders column 3^powOf3 (or the aggregate, for STORE_AGGREGATE) as soon as the sieve has it
+void findAndPrintZeros_sieveTile(struct columnSieveConfig config, int powOf3, struct tileRendererConfig tileConfig) {
+	struct columnSieve *sieve = createColumnSieve(config);
+	
+	cout << "Col length = " << config.colLength << "\r\n";
+	cout << "Max value representable = " << sieve->maxValueRepresentable << "\r\n";
+	cout << "\r\n";
+	
+	if (powOf3 == 0) {
+		vector<uint64_t> powersOf2 = makePowersOf2Column(sieve);
+		struct tileSource source = tileSourceFromChunks(powersOf2.data(), config.colLength, 0, sieve->maxValueRepresentable);
+		printTileRendered(tileConfig, renderTile(tileConfig, source));
+	}
+	
+	struct columnSieveCallbacks callbacks;
+	callbacks.zeroFound = printFoundZero;
+	callbacks.columnFinished = [sieve, powOf3, &tileConfig](int columnPowOf3, uint64_t firstValueRepresented) {
+		cout << "\r";
+		printTime();
+		cout << ": finished column for shift of 3^" << columnPowOf3 << endl;
+		
+		if (columnPowOf3 == powOf3) {
+			struct tileSource source = tileSourceFromChunks(sieve->expRegCol, sieve->config.colLength, numToBitPos(firstValueRepresented), sieve->maxValueRepresentable);
+			printTileRendered(tileConfig, renderTile(tileConfig, source));
+		}
+	};
+	callbacks.progress = [](int powOf3, uint64_t chunk) {
+		cout << "\r" << "at: " << powOf3 << ", " << (chunk * 64);
+	};
+	
+	runColumnSieve(sieve, callbacks);
+	
+	cout << endl;
+	printTime();
+	cout << ": finished computing aggregate" << endl;
+	
+	if (powOf3 == STORE_AGGREGATE) {
+		struct tileSource source = tileSourceFromChunks(sieve->colsAggregate, config.colLength, 0, sieve->maxValueRepresentable);
+		printTileRendered(tileConfig, renderTile(tileConfig, source));
+	}
+	
+	destroyColumnSieve(sieve);
+}
+
+// argv is k or agg, out, rowWidth [zoom [popcount]], where rowWidth is either a number or 3^k
+struct tileRendererConfig parseTileRendererConfig(int argc, char **argv) {
+	uint64_t rowWidth = strtoull(argv[2], nullptr, 10);
+	if (strncmp(argv[2], "3^", 2) == 0) {
+		rowWidth = 1;
+		for (int i = atoi(argv[2] + 2); i > 0; i--) rowWidth *= 3;
+	}
+	
+	struct tileRendererConfig config = defaultTileRendererConfig(argv[1], rowWidth);
+	if (argc >= 4) {
+		config.zoom = strtoull(argv[3], nullptr, 10);
+	}
+	if (argc >= 5 && strcmp(argv[4], "popcount") == 0) {
+		config.reduction = TILE_POPCOUNT;
+	}
+	return config;
+}
+
+int parseTileColumn(const char *column) {
+	return strcmp(column, "agg") == 0 ? STORE_AGGREGATE : atoi(column);
+}
+
+// countColLength can be 0, for no path counts
+void findAndWriteResults(struct columnSieveConfig config, uint64_t countColLength, const string &resultsPath) {
+	struct columnSieve *sieve = createColumnSieve(config);
+	
+	cout << "Col length = " << config.colLength << "\r\n";
+	cout << "Max value representable = " << sieve->maxValueRepresentable << "\r\n";
+	cout << "\r\n";
+	
+	struct columnSieveCallbacks callbacks;
+	callbacks.zeroFound = printFoundZero;
+	callbacks.columnFinished = [](int powOf3, uint64_t firstValueRepresented) {
+		cout << "\r";
+		printTime();
+		cout << ": finished column for shift of 3^" << powOf3 << endl;
+	};
+	
+	runColumnSieve(sieve, callbacks);
+	
+	struct pathCountSieve *counts = nullptr;
+	if (countColLength != 0) {
+		struct pathCountSieveConfig countConfig;
+		countConfig.colLength = countColLength;
+		counts = createPathCountSieve(countConfig);
+		
+		struct pathCountCallbacks countCallbacks;
+		countCallbacks.lanesWidened = [](int laneBytes) {
+			printTime();
+			cout << ": widened counts to " << (laneBytes * 8) << " bits" << endl;
+		};
+		runPathCountSieve(counts, countCallbacks);
+		
+		printTime();
+		cout << ": finished counting paths up to " << counts->maxValueRepresentable << endl;
+	}
+	
+	writeResultSet(resultsPath, getAggregateView(sieve), counts);
+	saveRankIndex(sieve->rankIndex, resultsPath + ".rank");
+	printTime();
+	cout << ": results written to '" << resultsPath << "', and a rank index of them to '" << resultsPath << ".rank'" << endl;
+	
+	if (counts != nullptr) destroyPathCountSieve(counts);
+	destroyColumnSieve(sieve);
+}
+
+void printRankCounts(const struct rankIndex *index, const struct reachabilityBitView *view, uint64_t value) {
+	uint64_t reachable = countReachableUpTo(index, view, value);
+	uint64_t zeros = countZerosUpTo(index, view, value);
+	cout << "up to " << value << ": " << reachable << " reachable, " << zeros << " zeros";
+	cout << " (density " << setprecision(10) << (double)reachable / (reachable + zeros) << " excluding multiples of 3)" << endl;
+}
+
+// With no values given, prints the counts up to each power of 10
+void printRankedResults(const string &resultsPath, int valueCount, char **values) {
+	struct resultSet *results = openResultSet(resultsPath);
+	struct rankIndex *index = loadRankIndex(resultsPath + ".rank");
+	
+	cout << "Max value = " << index->maxValue << "\r\n";
+	cout << "\r\n";
+	
+	if (valueCount == 0) {
+		for (uint64_t value = 10; value <= index->maxValue; value *= 10) {
+			printRankCounts(index, &results->aggregate, value);
+			if (value > index->maxValue / 10) break;
+		}
+		printRankCounts(index, &results->aggregate, index->maxValue);
+	}
+	for (int i = 0; i < valueCount; i++) {
+		printRankCounts(index, &results->aggregate, strtoull(values[i], nullptr, 10));
+	}
+	
+	destroyRankIndex(index);
+	closeResultSet(results);
+}
+
+void printNthResults(const string &resultsPath, int valueCount, char **values) {
+	struct resultSet *results = openResultSet(resultsPath);
+	struct rankIndex *index = loadRankIndex(resultsPath + ".rank");
+	
+	cout << "Max value = " << index->maxValue << ", reachable = " << index->onCount << ", zeros = " << (index->bitCount - index->onCount) << "\r\n";
+	cout << "\r\n";
+	
+	for (int i = 0; i < valueCount; i++) {
+		// n counts from 1, so 0 (or anything that isn't a number) is turned away before the lookups
+		char *end;
+		uint64_t n = strtoull(values[i], &end, 10);
+		if (end == values[i] || *end != '\0' || n == 0) {
+			cout << values[i] << ": (not a whole number from 1 up)" << endl;
+			continue;
+		}
+		
+		cout << n << ": ";
+		if (n <= index->onCount) {
+			cout << "reachable " << getNthReachable(index, &results->aggregate, n);
+		} else {
+			cout << "(no reachable)";
+		}
+		if (n <= index->bitCount - index->onCount) {
+			cout << ", zero " << getNthZero(index, &results->aggregate, n);
+		}
+		cout << endl;
+	}
+	
+	destroyRankIndex(index);
+	closeResultSet(results);
+}
+
+void exportGraph(struct stateGraphConfig config) {
+	struct stateGraphCallbacks callbacks;
+	callbacks.planeWritten = [](int powOf3, uint64_t nodes, uint64_t edges) {
+		cout << "\r3^" << powOf3 << ": " << nodes << " nodes, " << edges << " edges" << endl;
+	};
+	
+	struct stateGraphStats stats = exportStateGraph(config, callbacks);
+	
+	printTime();
+	cout << ": " << stats.nodes << " nodes and " << stats.edges << " edges written to '" << config.path << "'" << endl;
+}
+
+void findAndPrintMultiSource(struct multiSourceSieveConfig config, bool printZeros) {
+	struct multiSourceSieve *sieve = createMultiSourceSieve(config);
+	
+	cout << "Max value = " << config.maxValue << ", seeds = " << config.seeds.size() << (config.perSourceLabels ? ", labelled" : "") << "\r\n";
+	cout << "Memory = " << (sieve->plane.size() + sieve->aggregate.size()) * sizeof(uint64_t) << " bytes" << (sieve->storesMultiplesOf3 ? ", multiples of 3 stored" : "") << "\r\n";
+	cout << "\r\n";
+	
+	struct multiSourceSieveCallbacks callbacks;
+	if (printZeros) {
+		callbacks.zeroFound = printFoundZero;
+	}
+	callbacks.planeFinished = [](int powOf3, uint64_t states) {
+		cout << "\r";
+		printTime();
+		cout << ": 3^" << powOf3 << ": " << states << " states" << endl;
+	};
+	
+	runMultiSourceSieve(sieve, callbacks);
+	
+	cout << endl;
+	cout << "States = " << sieve->stateCount << "\r\n";
+	cout << "Reachable = " << sieve->reachableCount << ", zeros = " << sieve->zeroCount << "\r\n";
+	if (config.perSourceLabels) {
+		for (uint64_t i = 0; i < config.seeds.size(); i++) {
+			cout << "From " << config.seeds[i].value << ":" << config.seeds[i].lastPow << ": " << sieve->reachableCountPerSource[i] << " reachable\r\n";
+		}
+		cout << "From every seed: " << sieve->reachedByEverySource << " reachable\r\n";
+	}
+	cout << endl;
+	
+	destroyMultiSourceSieve(sieve);
+}
+
+struct queryDaemon *runningDaemon = nullptr;
+
+void stopRunningDaemon(int signal) {
+	stopQueryDaemon(runningDaemon);
+}
+
+void serveResults(const string &resultsPath, const string &socketPath) {
+	auto openStart = chrono::steady_clock::now();
+	struct resultSet *results = openResultSet(resultsPath);
+	auto openTime = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - openStart);
+	
+	cout << "Opened '" << resultsPath << "' in " << openTime.count() << " us\r\n";
+	cout << "Max value = " << results->header->maxValue << ", zeros = " << results->header->zeroCount << "\r\n";
+	cout << "Max value counted = " << results->header->countsMaxValue << "\r\n";
+	cout << "\r\n";
+	
+	runningDaemon = createQueryDaemon(defaultQueryDaemonConfig(socketPath), results);
+	signal(SIGINT, stopRunningDaemon);
+	signal(SIGTERM, stopRunningDaemon);
+	
+	printTime();
+	cout << ": listening on '" << socketPath << "'" << endl;
+	
+	runQueryDaemon(runningDaemon, queryDaemonCallbacks());
+	
+	printTime();
+	cout << ": stopped, " << runningDaemon->requestsAnswered << " requests answered (" << runningDaemon->valuesAnswered << " values, " << runningDaemon->fallbacks << " beyond the results)" << endl;
+	
+	destroyQueryDaemon(runningDaemon);
+	runningDaemon = nullptr;
+	closeResultSet(results);
+}
+
+void findAndPrintZeros_dfs(struct treeSearchConfig config) {
+	struct treeSearch *search = createTreeSearch(config);
+	
+	cout << "Max = " << config.max << "\r\n";
+	cout << "Threads = " << config.threads << "\r\n";
+	cout << "Visited store = " << getVisitedStoreBytes(search->visited) / (1024 * 1024) << " MB\r\n";
+	cout << "\r\n";
+	
+	struct treeSearchCallbacks callbacks;
+	callbacks.zeroFound = printFoundZero;
+	if (config.threads > 1) {
+		callbacks.progress = [](int subtreesLeft) {
+			cout << "\r" << "subtrees left: " << subtreesLeft << "   " << flush;
+		};
+	} else {
+		callbacks.progress = [](int doublingsBeforeFirstPowerOf3) {
+			cout << "\r" << "at: " << doublingsBeforeFirstPowerOf3 << " doublings before 3^1   " << flush;
+		};
+	}
+	
+	runTreeSearch(search, callbacks);
+	
+	destroyTreeSearch(search);
+}
+
+void findAndPrintZeros_window(struct windowSearchConfig config) {
+	struct windowSearch *search = createWindowSearch(config);
+	
+	cout << "Window = [" << config.lo << ", " << config.hi << "]\r\n";
+	cout << "\r\n";
+	
+	struct windowSearchCallbacks callbacks;
+	callbacks.zeroFound = printFoundZero;
+	callbacks.progress = [](uint64_t done, uint64_t total) {
+		cout << "\r" << "at: " << done << " / " << total << "   " << flush;
+	};
+	
+	runWindowSearch(search, callbacks);
+	
+	cout << endl;
+	printTime();
+	cout << ": finished, " << search->pathsFound << " paths found, states visited: " << search->statesVisited << ", memo hits: " << search->memoHits << endl;
+	
+	if (config.countPaths) {
+		vector<uint64_t> histogram;
+		for (uint64_t value = config.lo; value <= config.hi; value++) {
+			if (value % 3 == 0) continue;
+			
+			uint64_t count = getWindowPathCount(search, value);
+			if (count >= histogram.size()) histogram.resize(count + 1, 0);
+			histogram[count]++;
+		}
+		
+		cout << endl;
+		cout << "paths: values (excluding multiples of 3)" << endl;
+		for (uint64_t count = 0; count < histogram.size(); count++) {
+			if (histogram[count] != 0) {
+				cout << count << ": " << histogram[count] << endl;
+			}
+		}
+	}
+	
+	destroyWindowSearch(search);
+}
+
+template <int M, int S>
+void findAndPrintZeros_ms(struct columnSieveConfig config) {
+	struct msColumnSieve<M, S> *sieve = createMSColumnSieve<M, S>(config);
+	
+	cout << "M = " << M << ", S = " << S << "\r\n";
+	cout << "Col length = " << config.colLength << "\r\n";
+	cout << "Max value representable = " << sieve->maxValueRepresentable << "\r\n";
+	cout << "\r\n";
+	
+	struct columnSieveCallbacks callbacks;
+	callbacks.zeroFound = printFoundZero;
+	callbacks.columnFinished = [](int powOfS, uint64_t firstValueRepresented) {
+		cout << "\r";
+		printTime();
+		cout << ": finished column for shift of " << S << "^" << powOfS << endl;
+	};
+	callbacks.progress = [](int powOfS, uint64_t chunk) {
+		cout << "\r" << "at: " << powOfS << ", " << (chunk * 64);
+	};
+	
+	runMSColumnSieve(sieve, callbacks);
+	
+	cout << endl;
+	printTime();
+	cout << ": finished computing aggregate" << endl;
+	
+	destroyMSColumnSieve(sieve);
+}
+
+void printBackwardReachability(int valueCount, char *values[]) {
+	struct backwardSearch *search = createBackwardSearch(defaultBackwardSearchConfig());
+	
+	for (int i = 0; i < valueCount; i++) {
+		uint128_t value;
+		if (!parseUInt128(values[i], &value)) {
+			cout << "Error: '" << values[i] << "' isn't a whole number below 2^128" << endl;
+			continue;
+		}
+		
+		vector<uint128_t> path;
+		if (isReachableBackward(search, value, &path)) {
+			cout << uint128ToString(value) << ": reachable:";
+			for (uint128_t n : path) cout << " " << uint128ToString(n);
+			cout << endl;
+		} else {
+			cout << uint128ToString(value) << ": not reachable" << endl;
+		}
+	}
+	
+	cout << "States searched: " << search->statesVisited << ", memo hits: " << search->memoHits << endl;
+	
+	destroyBackwardSearch(search);
+}
+
+void printBackwardPathCounts(int valueCount, char *values[]) {
+	struct backwardPathCounterConfig config = defaultBackwardPathCounterConfig();
+	struct backwardPathCounter *counter = createBackwardPathCounter(config);
+	
+	cout << "Threads = " << config.threads << "\r\n";
+	cout << "\r\n";
+	
+	for (int i = 0; i < valueCount; i++) {
+		uint128_t value;
+		if (!parseUInt128(values[i], &value)) {
+			cout << "Error: '" << values[i] << "' isn't a whole number below 2^128" << endl;
+			continue;
+		}
+		
+		uint128_t count = countPathsBackward(counter, value);
+		printTime();
+		cout << ": " << uint128ToString(value) << ": " << uint128ToString(count) << " paths" << endl;
+	}
+	
+	cout << "States memoised: " << counter->statesVisited << ", memo hits: " << counter->memoHits << ", evicted: " << counter->memoEvictions << endl;
+	
+	destroyBackwardPathCounter(counter);
+}
+
+void printMeetInTheMiddle(bool countPaths, int valueCount, char *values[]) {
+	struct meetInTheMiddleConfig config = defaultMeetInTheMiddleConfig(countPaths);
+	cout << "Low half max = " << config.lowMax << "\r\n";
+	struct meetInTheMiddle *mitm = createMeetInTheMiddle(config);
+	
+	printTime();
+	cout << ": built low half" << endl;
+	cout << endl;
+	
+	for (int i = 0; i < valueCount; i++) {
+		uint128_t value;
+		if (!parseUInt128(values[i], &value)) {
+			cout << "Error: '" << values[i] << "' isn't a whole number below 2^128" << endl;
+			continue;
+		}
+		
+		printTime();
+		if (countPaths) {
+			cout << ": " << uint128ToString(value) << ": " << uint128ToString(countPathsMeetInTheMiddle(mitm, value)) << " paths" << endl;
+		} else {
+			cout << ": " << uint128ToString(value) << (isReachableMeetInTheMiddle(mitm, value) ? ": reachable" : ": not reachable") << endl;
+		}
+	}
+	
+	cout << "States above the low half: " << mitm->statesVisited << ", lookups: " << mitm->tableLookups << ", memo hits: " << mitm->memoHits << endl;
+	
+	destroyMeetInTheMiddle(mitm);
+}
+
+void printBatchReachability(const string &candidatesPath, struct batchVerifierConfig config) {
+	vector<uint128_t> candidates = readCandidateFile(candidatesPath);
+	struct batchVerifier *verifier = createBatchVerifier(config);
+	
+	cout << "Candidates = " << candidates.size() << "\r\n";
+	cout << "Threads = " << config.threads << "\r\n";
+	cout << "\r\n";
+	
+	uint64_t unreachableCount = 0;
+	struct batchVerifierCallbacks callbacks;
+	callbacks.result = [&unreachableCount](uint64_t index, uint128_t value, bool reachable) {
+		cout << uint128ToString(value) << (reachable ? ": reachable" : ": not reachable") << "\n";
+		if (!reachable) unreachableCount++;
+	};
+	
+	runBatchVerifier(verifier, candidates, callbacks);
+	
+	cout << endl;
+	printTime();
+	cout << ": " << unreachableCount << " of " << candidates.size() << " not reachable" << endl;
+	cout << "States searched: " << verifier->statesVisited << ", memo hits: " << verifier->memoHits << endl;
+	
+	destroyBatchVerifier(verifier);
+}
+
+void findAndPrintIncreasingMultiplier(struct increasingMultiplierConfig config, bool printValues, bool printZeros) {
+	struct increasingMultiplierSieve *sieve = createIncreasingMultiplierSieve(config);
+	
+	cout << "M = " << config.m << ", S = " << config.s << ", max value = " << config.maxValue << "\r\n";
+	cout << "\r\n";
+	
+	struct increasingMultiplierCallbacks callbacks;
+	if (printValues) {
+		callbacks.reachableFound = [](uint64_t value, uint64_t paths) {
+			cout << value << ": " << paths << "\n";
+		};
+	}
+	if (printZeros) {
+		callbacks.zeroFound = printFoundZero;
+	}
+	callbacks.rowFinished = [](int adds, uint64_t states) {
+		cout << "\r";
+		printTime();
+		cout << ": " << adds << " powers added: " << states << " states" << endl;
+	};
+	
+	runIncreasingMultiplierSieve(sieve, callbacks);
+	
+	cout << endl;
+	cout << "States = " << sieve->stateCount << ", most adds = " << sieve->maxAdds << ", most multiplies = " << sieve->maxMultiplies << "\r\n";
+	cout << "Reachable = " << sieve->reachableCount << ", paths = " << sieve->pathCount << "\r\n";
+	cout << "Most paths = " << sieve->mostPaths << ", to " << sieve->mostPathsValue << "\r\n";
+	cout << "Zeros = " << sieve->zeroCount << ", of which in classes mod " << config.s << " that are never reached = " << sieve->trivialZeroCount << endl;
+	
+	destroyIncreasingMultiplierSieve(sieve);
+}
+
+void printMSSweep(const vector<struct msSweepJob> &jobs, struct msSweepConfig config) {
+	cout << "Jobs = " << jobs.size() << "\r\n";
+	cout << "Threads = " << config.threads << "\r\n";
+	cout << "\r\n";
+	cout << msSweepCsvHeader() << endl;
+	
+	struct msSweepCallbacks callbacks;
+	callbacks.rowFinished = [](const struct msSweepRow &row) {
+		cout << msSweepCsvRow(row) << endl;
+	};
+	runMSSweep(jobs, config, callbacks);
+}
+
+void findAndPrintPathCounts(struct pathCountSieveConfig config) {
+	struct pathCountSieve *sieve = createPathCountSieve(config);
+	
+	cout << "Col length = " << config.colLength << "\r\n";
+	cout << "Max value representable = " << sieve->maxValueRepresentable << "\r\n";
+	cout << "\r\n";
+	
+	struct pathCountCallbacks callbacks;
+	callbacks.singlePathFound = [](uint64_t value) {
+		cout << "\r";
+		printTime();
+		cout << ": found single path: " << value << endl;
+	};
+	callbacks.columnFinished = [](int powOf3, uint64_t firstValueRepresented) {
+		cout << "\r";
+		printTime();
+		cout << ": finished column for shift of 3^" << powOf3 << endl;
+	};
+	callbacks.lanesWidened = [](int laneBytes) {
+		cout << "\r";
+		printTime();
+		cout << ": widened counts to " << (laneBytes * 8) << " bits" << endl;
+	};
+	
+	runPathCountSieve(sieve, callbacks);
+	
+	cout << endl;
+	printTime();
+	cout << ": finished counting" << endl;
+	
+	cout << endl;
+	cout << "paths: values (excluding multiples of 3)" << endl;
+	for (uint64_t count = 0; count < sieve->histogram.size(); count++) {
+		if (sieve->histogram[count] != 0) {
+			cout << count << ": " << sieve->histogram[count] << endl;
+		}
+	}
+	
+	destroyPathCountSieve(sieve);
+}
+
+// The wheel is detected from a probe run of the plain M/S sieve, 8 chunks long
+template <int M, int S>
+void findAndPrintZeros_wheel(struct columnSieveConfig config) {
+	struct columnSieveConfig probeConfig;
+	probeConfig.colLength = 8;
+	probeConfig.buildRankIndex = false;
+	struct msColumnSieve<M, S> *probe = createMSColumnSieve<M, S>(probeConfig);
+	runMSColumnSieve(probe, columnSieveCallbacks());
+	
+	struct reachabilityBitView probeView = getMSAggregateView(probe);
+	vector<uint64_t> probeReachable;
+	for (uint64_t i = 1; i <= probeView.maxValue; i++) {
+		if (isReachableMS<M, S>(&probeView, i)) probeReachable.push_back(i);
+	}
+	destroyMSColumnSieve(probe);
+	
+	// The compile-time tables are faster, so only use the wheel when it actually saves memory
+	struct residueWheel *wheel = detectResidueWheel(M, S, 256, probeReachable.data(), probeReachable.size());
+	if (wheel == nullptr || (int64_t)wheel->kept * S >= (int64_t)msTables<M, S>.kept * wheel->modulus) {
+		cout << "No wheel stores less than the one mod " << S << ", so running the plain sieve\r\n";
+		destroyResidueWheel(wheel);
+		findAndPrintZeros_ms<M, S>(config);
+		return;
+	}
+	
+	struct wheelColumnSieve<M> *sieve = createWheelColumnSieve<M>(config, wheel);
+	
+	cout << "M = " << M << ", S = " << S << "\r\n";
+	cout << "Wheel = " << wheel->kept << " of every " << wheel->modulus << " values (vs " << msTables<M, S>.kept << " of every " << S << ")\r\n";
+	cout << "Col length = " << config.colLength << "\r\n";
+	cout << "Max value representable = " << sieve->maxValueRepresentable << "\r\n";
+	cout << "\r\n";
+	
+	struct columnSieveCallbacks callbacks;
+	callbacks.zeroFound = printFoundZero;
+	callbacks.columnFinished = [](int powOfS, uint64_t firstValueRepresented) {
+		cout << "\r";
+		printTime();
+		cout << ": finished column for shift of " << S << "^" << powOfS << endl;
+	};
+	callbacks.progress = [](int powOfS, uint64_t chunk) {
+		cout << "\r" << "at: " << powOfS << ", " << (chunk * 64);
+	};
+	
+	runWheelColumnSieve(sieve, callbacks);
+	
+	cout << endl;
+	printTime();
+	cout << ": finished computing aggregate" << endl;
+	
+	destroyWheelColumnSieve(sieve);
+	destroyResidueWheel(wheel);
+}
+
+template <int M, int S>
+void findAndPrintZeros_ms(struct columnSieveConfig config, bool useWheel) {
+	if (useWheel) {
+		findAndPrintZeros_wheel<M, S>(config);
+	} else {
+		findAndPrintZeros_ms<M, S>(config);
+	}
+}
+
+// M and S have to be known at compile time, so only these combinations are built in
+template <int M>
+bool findAndPrintZeros_ms(int s, struct columnSieveConfig config, bool useWheel) {
+	switch (s) {
+		case 2: findAndPrintZeros_ms<M, 2>(config, useWheel); return true;
+		case 3: findAndPrintZeros_ms<M, 3>(config, useWheel); return true;
+		case 4: findAndPrintZeros_ms<M, 4>(config, useWheel); return true;
+		case 5: findAndPrintZeros_ms<M, 5>(config, useWheel); return true;
+		case 6: findAndPrintZeros_ms<M, 6>(config, useWheel); return true;
+		case 7: findAndPrintZeros_ms<M, 7>(config, useWheel); return true;
+		default: return false;
+	}
+}
+
+bool findAndPrintZeros_ms(int m, int s, struct columnSieveConfig config, bool useWheel) {
+	switch (m) {
+		case 2: return findAndPrintZeros_ms<2>(s, config, useWheel);
+		case 3: return findAndPrintZeros_ms<3>(s, config, useWheel);
+		case 4: return findAndPrintZeros_ms<4>(s, config, useWheel);
+		default: return false;
+	}
+}
+
+// Runs the mode argv asks for, returning -1 if the arguments don't make sense
+int runMode(int argc, char *argv[]) {
+	if (argc >= 2 && strcmp(argv[1], "dfs") == 0) {
+		if (argc < 3) return -1;
+		
+		struct treeSearchConfig config;
+		config.max = strtoull(argv[2], nullptr, 10);
+		config.threads = max(1u, thread::hardware_concurrency());
+		if (argc >= 4) {
+			config.threads = atoi(argv[3]);
+		}
+		findAndPrintZeros_dfs(config);
+	} else if (argc >= 2 && strcmp(argv[1], "window") == 0) {
+		if (argc < 4) return -1;
+		
+		bool countPaths = argc >= 5 && strcmp(argv[4], "count") == 0;
+		findAndPrintZeros_window(defaultWindowSearchConfig(strtoull(argv[2], nullptr, 10), strtoull(argv[3], nullptr, 10), countPaths));
+	} else if (argc >= 2 && strcmp(argv[1], "store") == 0) {
+		if (argc < 3) return -1;
+		
+		struct columnSieveConfig config = defaultColumnSieveConfig();
+		if (argc >= 4) {
+			config.colLength = strtoull(argv[3], nullptr, 10);
+		}
+		findAndPrintZeros_sieve(config, argv[2]);
+	} else if (argc >= 2 && strcmp(argv[1], "stored") == 0) {
+		if (argc < 4) return -1;
+		
+		printStoredColumns(argv[2], argc - 3, argv + 3);
+	} else if (argc >= 2 && strcmp(argv[1], "render") == 0) {
+		if (argc < 6) return -1;
+		
+		renderStoredTile(argv[2], parseTileColumn(argv[3]), parseTileRendererConfig(argc - 3, argv + 3));
+	} else if (argc >= 2 && strcmp(argv[1], "image") == 0) {
+		if (argc < 5) return -1;
+		
+		struct columnSieveConfig config = defaultColumnSieveConfig();
+		if (argc >= 8) {
+			config.colLength = strtoull(argv[7], nullptr, 10);
+		}
+		findAndPrintZeros_sieveTile(config, parseTileColumn(argv[2]), parseTileRendererConfig(min(argc - 2, 5), argv + 2));
+	} else if (argc >= 2 && strcmp(argv[1], "results") == 0) {
+		if (argc < 3) return -1;
+		
+		struct columnSieveConfig config = defaultColumnSieveConfig();
+		if (argc >= 4) {
+			config.colLength = strtoull(argv[3], nullptr, 10);
+		}
+		config.buildRankIndex = true;
+		uint64_t countColLength = argc >= 5 ? strtoull(argv[4], nullptr, 10) : 0;
+		findAndWriteResults(config, countColLength, argv[2]);
+	} else if (argc >= 2 && strcmp(argv[1], "rank") == 0) {
+		if (argc < 3) return -1;
+		
+		printRankedResults(argv[2], argc - 3, argv + 3);
+	} else if (argc >= 2 && strcmp(argv[1], "nth") == 0) {
+		if (argc < 4) return -1;
+		
+		printNthResults(argv[2], argc - 3, argv + 3);
+	} else if (argc >= 2 && strcmp(argv[1], "serve") == 0) {
+		if (argc < 4) return -1;
+		
+		serveResults(argv[2], argv[3]);
+	} else if (argc >= 2 && strcmp(argv[1], "graph") == 0) {
+		if (argc < 4) return -1;
+		
+		struct stateGraphConfig config = defaultStateGraphConfig(argv[3], strtoull(argv[2], nullptr, 10));
+		config.collapseDoublings = argc >= 5 && strcmp(argv[4], "collapse") == 0;
+		exportGraph(config);
+	} else if (argc >= 2 && strcmp(argv[1], "from") == 0) {
+		if (argc < 4) return -1;
+		
+		struct multiSourceSieveConfig config;
+		config.maxValue = strtoull(argv[2], nullptr, 10);
+		config.perSourceLabels = false;
+		bool printZeros = false;
+		for (int i = 3; i < argc; i++) {
+			if (strcmp(argv[i], "labels") == 0) {
+				config.perSourceLabels = true;
+			} else if (strcmp(argv[i], "zeros") == 0) {
+				printZeros = true;
+			} else {
+				struct sieveSeed seed;
+				seed.value = strtoull(argv[i], nullptr, 10);
+				const char *lastPow = strchr(argv[i], ':');
+				seed.lastPow = lastPow != nullptr ? atoi(lastPow + 1) : 0;
+				config.seeds.push_back(seed);
+			}
+		}
+		findAndPrintMultiSource(config, printZeros);
+	} else if (argc >= 2 && strcmp(argv[1], "backward") == 0) {
+		if (argc < 3) return -1;
+		
+		printBackwardReachability(argc - 2, argv + 2);
+	} else if (argc >= 2 && strcmp(argv[1], "paths") == 0) {
+		if (argc < 3) return -1;
+		
+		printBackwardPathCounts(argc - 2, argv + 2);
+	} else if (argc >= 2 && strcmp(argv[1], "mitm") == 0) {
+		bool countPaths = argc >= 3 && strcmp(argv[2], "count") == 0;
+		if (argc < (countPaths ? 4 : 3)) return -1;
+		
+		printMeetInTheMiddle(countPaths, argc - (countPaths ? 3 : 2), argv + (countPaths ? 3 : 2));
+	} else if (argc >= 2 && strcmp(argv[1], "batch") == 0) {
+		if (argc < 3) return -1;
+		
+		struct batchVerifierConfig config = defaultBatchVerifierConfig();
+		if (argc >= 4) {
+			config.threads = atoi(argv[3]);
+		}
+		printBatchReachability(argv[2], config);
+	} else if (argc >= 2 && strcmp(argv[1], "increasing") == 0) {
+		if (argc < 5) return -1;
+		
+		struct increasingMultiplierConfig config;
+		config.m = atoi(argv[2]);
+		config.s = atoi(argv[3]);
+		config.maxValue = strtoull(argv[4], nullptr, 10);
+		bool printValues = argc >= 6 && strcmp(argv[5], "values") == 0;
+		bool printZeros = argc >= 6 && strcmp(argv[5], "zeros") == 0;
+		findAndPrintIncreasingMultiplier(config, printValues, printZeros);
+	} else if (argc >= 2 && strcmp(argv[1], "sweep") == 0) {
+		if (argc < 5) return -1;
+		
+		struct msSweepConfig config = defaultMSSweepConfig();
+		if (argc >= 6) {
+			config.threads = atoi(argv[5]);
+		}
+		printMSSweep(makeMSSweepGrid(atoi(argv[2]), atoi(argv[3]), strtoull(argv[4], nullptr, 10)), config);
+	} else if (argc >= 2 && strcmp(argv[1], "count") == 0) {
+		struct pathCountSieveConfig config;
+		config.colLength = defaultColumnSieveConfig().colLength / 8; // 2 byte-or-more lanes per 64 values, rather than 2 bits
+		if (argc >= 3) {
+			config.colLength = strtoull(argv[2], nullptr, 10);
+		}
+		if (argc >= 4) {
+			config.countsFilePath = argv[3];
+		}
+		findAndPrintPathCounts(config);
+	} else if (argc >= 2 && (strcmp(argv[1], "ms") == 0 || strcmp(argv[1], "wheel") == 0)) {
+		if (argc < 4) return -1;
+		
+		struct columnSieveConfig config = defaultColumnSieveConfig();
+		if (argc >= 5) {
+			config.colLength = strtoull(argv[4], nullptr, 10);
+		}
+		if (!findAndPrintZeros_ms(atoi(argv[2]), atoi(argv[3]), config, strcmp(argv[1], "wheel") == 0)) {
+			cout << "Error: M = " << argv[2] << ", S = " << argv[3] << " isn't one of the combinations built in" << endl;
+			return -1;
+		}
+	} else {
+		struct columnSieveConfig config = defaultColumnSieveConfig();
+		if (argc >= 3) {
+			config.colLength = strtoull(argv[2], nullptr, 10);
+		}
+		findAndPrintZeros_sieve(config, "");
+	}
+	
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	
+	if (sizeof(uint64_t) != 8) {
+		cout << "Error: unexpected uint64_t size '" << sizeof(uint64_t) << "', must be 8 bytes" << endl;
+		return -1;
+	}
+	
+	cout << "Started at: ";
+	printTime();
+	cout << endl;
+	cout << endl;
+	
+	// The library throws for bad input (a malformed candidate file, a max out of range, ...), with
+	// messages starting "Error:" to be shown as they are
+	try {
+		int result = runMode(argc, argv);
+		if (result != 0) return result;
+	} catch (const exception &e) {
+		cout << endl << e.what() << endl;
+		return -1;
+	}
+	
+	cout << endl;
+	cout << "Finished at: ";
+	printTime();
+	cout << endl;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "math-utils.h"
+#include "column-kernels.h"
+#include "visited-store.h"
+#include <stdexcept>
+#include <stdint.h>
+
+using namespace std;
+
+struct visitedStore *createVisitedStore(uint64_t max) {
+	if (max < 1) {
+		throw out_of_range("max < 1");
+	}
+	
+	struct visitedStore *store = new struct visitedStore;
+	store->max = max;
+	store->wordCount = numToBitPos(max) / CHUNK_BITS + 1;
+	store->planeCount = 0;
+	
+	uint64_t minSum = 0;
+	for (int k = 0; k < MAX_VISITED_PLANES - 1; k++) {
+		minSum += threeToThe(k);
+		if (minSum > max) break;
+		
+		store->firstWord[k] = numToBitPos(minSum) / CHUNK_BITS;
+		store->planes[k] = new uint64_t[store->wordCount - store->firstWord[k]]();
+		store->planeCount++;
+	}
+	
+	return store;
+}
+
+void destroyVisitedStore(struct visitedStore *store) {
+	if (store == nullptr) return;
+	
+	for (int k = 0; k < store->planeCount; k++) {
+		delete[] store->planes[k];
+	}
+	delete store;
+}
+
+uint64_t getVisitedStoreBytes(const struct visitedStore *store) {
+	uint64_t words = 0;
+	for (int k = 0; k < store->planeCount; k++) {
+		words += store->wordCount - store->firstWord[k];
+	}
+	return words * sizeof(uint64_t);
+}
+
+void mergeVisitedPlanes(struct visitedStore *store) {
+	uint64_t *merged = store->planes[0];
+	for (int k = 1; k < store->planeCount; k++) {
+		const uint64_t *plane = store->planes[k];
+		uint64_t firstWord = store->firstWord[k];
+		for (uint64_t word = firstWord; word < store->wordCount; word++) {
+			merged[word] |= plane[word - firstWord];
+		}
+		
+		delete[] plane;
+		store->planes[k] = nullptr;
+	}
+	store->planeCount = 1;
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include <stdint.h>
+#include "column-kernels.h"
+#include "math-utils.h"
+
+#ifndef VISITED_STORE_H
+#define VISITED_STORE_H
+
+// The depth-first search's record of which (value, last added power of 3) states it's already
+// explored. C++/ keeps a 64-bit element per value (multiples of 3 included) just for these flags,
+// when there are only log3(max) or so powers that can ever be set. This keeps one bit plane per
+// power instead, in the sieve's layout (multiples of 3 omitted, bit numToBitPos(value)). Plane k
+// starts at 1 + 3 + ... + 3^k, the smallest value with 3^k as the last power, and planes are only
+// allocated for powers where that's <= max. Up to 2^32 that's about 13 bits per value rather than
+// 64 (or 43 with multiples of 3 omitted, as decision-tree-search.cpp had it).
+
+const int MAX_VISITED_PLANES = 41; // one more than threePowers has
+
+struct visitedStore {
+	uint64_t max;
+	uint64_t wordCount; // words in plane 0, which covers every value up to max
+	int planeCount;
+	
+	// planes[k] holds words firstWord[k] to wordCount - 1 of plane k
+	uint64_t *planes[MAX_VISITED_PLANES];
+	uint64_t firstWord[MAX_VISITED_PLANES];
+};
+
+struct visitedStore *createVisitedStore(uint64_t max);
+void destroyVisitedStore(struct visitedStore *store);
+
+uint64_t getVisitedStoreBytes(const struct visitedStore *store);
+
+// ORs every plane into plane 0 and frees the rest, leaving plane 0 as one bit per value
+// reachable with any last power, in the same layout as the column sieve's aggregate
+void mergeVisitedPlanes(struct visitedStore *store);
+
+// Whether (value, lastPowOf3) has a bit in the store: a plane was allocated for the power, and value
+// is between the start of that plane and max. Below the start, the word offset would wrap.
+inline bool isInVisitedStore(const struct visitedStore *store, uint64_t value, int lastPowOf3) {
+	return lastPowOf3 < store->planeCount && value >= 1 && value <= store->max
+		&& numToBitPos(value) / CHUNK_BITS >= store->firstWord[lastPowOf3];
+}
+
+// Every state the search reaches has value >= 1 + 3 + ... + 3^lastPowOf3, so is inside its plane
+// (isInVisitedStore() is always true), and hasVisited() & markVisited() don't check again
+inline uint64_t *visitedWord(const struct visitedStore *store, uint64_t value, int lastPowOf3) {
+	return &store->planes[lastPowOf3][numToBitPos(value) / CHUNK_BITS - store->firstWord[lastPowOf3]];
+}
+
+// SHARED is for several threads marking the same store. Relaxed is enough, as a thread only ever
+// skips a state that another has finished with, and the whole store is only read after every
+// thread has been joined.
+template <bool SHARED>
+inline bool hasVisited(const struct visitedStore *store, uint64_t value, int lastPowOf3) {
+	const uint64_t *word = visitedWord(store, value, lastPowOf3);
+	uint64_t bits = SHARED ? __atomic_load_n(word, __ATOMIC_RELAXED) : *word;
+	return (bits >> (numToBitPos(value) % CHUNK_BITS)) & 1;
+}
+
+template <bool SHARED>
+inline void markVisited(struct visitedStore *store, uint64_t value, int lastPowOf3) {
+	uint64_t *word = visitedWord(store, value, lastPowOf3);
+	uint64_t bit = 1ULL << (numToBitPos(value) % CHUNK_BITS);
+	if (SHARED) {
+		if ((__atomic_load_n(word, __ATOMIC_RELAXED) & bit) == 0) {
+			__atomic_fetch_or(word, bit, __ATOMIC_RELAXED);
+		}
+	} else {
+		*word |= bit;
+	}
+}
+
+// For a state that'll be checked soon. The planes are far bigger than cache past a few million,
+// and the values the search jumps between are far apart, so nearly every check is a cache miss.
+inline void prefetchVisited(const struct visitedStore *store, uint64_t value, int lastPowOf3) {
+	if (isInVisitedStore(store, value, lastPowOf3)) {
+		__builtin_prefetch(visitedWord(store, value, lastPowOf3));
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,351 @@
+#include <stdint.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "bit-view.h"
+#include "column-sieve.h"
+#include "ms-kernels.h"
+#include "residue-wheel.h"
+
+#ifndef WHEEL_COLUMN_SIEVE_H
+#define WHEEL_COLUMN_SIEVE_H
+
+// msColumnSieve<M, S>, but storing only the residue classes of a runtime residueWheel (see
+// residue-wheel.h), e.g. from detectResidueWheel(). For M = 3, S = 6 that's 25 bits per 216 values
+// rather than 2 per 6, so the same memory covers 2.88x as far. Only M has to be known at compile
+// time (for the bit spreads); S comes from the wheel.
+//
+// The one complication is that the column can no longer start at exactly 1 + S + ... + S^k, as
+// the wheel's blocks are `modulus` values long. So column k is relative to E_k, the start of a
+// block, with E_(k+1) = E_k + modulus * (S^(k+1) / modulus). Going from column k to k+1 then moves
+// every value up by S^(k+1) % modulus, which is done in place as each chunk is finished with.
+//
+// The wheel must outlive the sieve, and isn't destroyed with it.
+
+template <int M>
+struct wheelColumnSieve {
+	struct columnSieveConfig config;
+	const struct residueWheel *wheel;
+	uint64_t maxValueRepresentable;
+	uint64_t *expRegCol;
+	uint64_t *colsAggregate;
+	bool finished;
+};
+
+template <int M>
+struct wheelColumnSieve<M> *createWheelColumnSieve(struct columnSieveConfig config, const struct residueWheel *wheel) {
+	if (config.colLength < 1) {
+		throw std::out_of_range("colLength < 1");
+	}
+	if (wheel->m != M) {
+		throw std::logic_error("Error: the wheel is for M = " + std::to_string(wheel->m) + ", not " + std::to_string(M));
+	}
+	if (!residueWheelFitsKernels(wheel)) {
+		throw std::logic_error("Error: the wheel mod " + std::to_string(wheel->modulus) + " moves bits too far for the chunk kernels");
+	}
+	
+	struct wheelColumnSieve<M> *sieve = new struct wheelColumnSieve<M>;
+	sieve->config = config;
+	sieve->wheel = wheel;
+	sieve->maxValueRepresentable = wheelValueAt(wheel, config.colLength * CHUNK_BITS - 1);
+	sieve->expRegCol = new uint64_t[config.colLength + M + 2](); // overflow for copyAlongToMultiplyWheel()
+	sieve->colsAggregate = new uint64_t[config.colLength + 1](); // 1 chunk of overflow, as the bit-adjusted aggregating can spill one past the end
+	sieve->finished = false;
+	
+	return sieve;
+}
+
+template <int M>
+void destroyWheelColumnSieve(struct wheelColumnSieve<M> *sieve) {
+	if (sieve == nullptr) return;
+	
+	delete[] sieve->expRegCol;
+	delete[] sieve->colsAggregate;
+	delete sieve;
+}
+
+// Only valid after runWheelColumnSieve() has returned, and until destroyWheelColumnSieve().
+// Bits are in the wheel's layout, so read it with isReachableWheel() rather than isReachable().
+template <int M>
+struct reachabilityBitView getWheelAggregateView(const struct wheelColumnSieve<M> *sieve) {
+	if (!sieve->finished) {
+		throw std::logic_error("Error: the aggregate isn't final until runWheelColumnSieve() has returned");
+	}
+	
+	struct reachabilityBitView view;
+	view.chunks = sieve->colsAggregate;
+	view.chunkCount = sieve->config.colLength;
+	view.maxValue = sieve->maxValueRepresentable;
+	return view;
+}
+
+inline bool isReachableWheel(const struct reachabilityBitView *view, const struct residueWheel *wheel, uint64_t value) {
+	if (value > view->maxValue) {
+		throw std::out_of_range(
+			std::string("Error: value '")
+			+ std::to_string(value)
+			+ "' is beyond the max value stored '"
+			+ std::to_string(view->maxValue)
+			+ "'."
+		);
+	}
+	if (value == 0 || !wheelKeeps(wheel, value)) return false;
+	
+	uint64_t bitPos = wheelPositionOf(wheel, value);
+	return (view->chunks[bitPos / CHUNK_BITS] >> (bitPos % CHUNK_BITS)) & 1;
+}
+
+// copyAlongToMultiplyCurrentPos<M, S>() with the wheel's tables. As the deltas aren't known at
+// compile time, all M + 2 output chunks are always written.
+template <int M>
+inline void copyAlongToMultiplyWheel(uint64_t *col, const struct residueWheel *wheel, uint64_t sourceChunkNum, int phase, uint64_t chunksAdjustment, uint64_t bitsAdjustment) {
+	uint64_t spread[M];
+	spreadBits<M>(col[sourceChunkNum], spread);
+	
+	const uint64_t *masks = wheel->multiplyMasks + (uint64_t)phase * wheel->multiplyDeltaGroups * M;
+	uint64_t out[M + 2] = {};
+	for (int g = 0; g < wheel->multiplyDeltaGroups; g++) {
+		int delta = wheel->multiplyGroupDelta[g];
+		for (int w = 0; w < M; w++) {
+			uint64_t part = spread[w] & masks[g * M + w];
+			if (delta > 0) {
+				out[w + 1] |= part << delta;
+				out[w + 2] |= part >> (CHUNK_BITS - delta);
+			} else if (delta < 0) {
+				out[w + 1] |= part >> -delta;
+				out[w] |= part << (CHUNK_BITS + delta);
+			} else {
+				out[w + 1] |= part;
+			}
+		}
+	}
+	
+	uint64_t *dest = col + M * sourceChunkNum + chunksAdjustment - 1;
+	uint64_t carry = 0;
+	for (int k = 0; k <= M + 1; k++) {
+		dest[k] |= (out[k] << bitsAdjustment) | carry;
+		carry = (out[k] >> 1) >> (CHUNK_BITS - 1 - bitsAdjustment);
+	}
+	dest[M + 2] |= carry;
+}
+
+// Replaces col[chunk] with its bits moved along by wheelShift, plus the carry from the chunk before,
+// and sets carry to the bits that go into the next chunk. As every delta is >= 0, that's all the
+// shifted bits.
+inline void shiftWheelChunk(uint64_t *col, const struct residueWheelShift *wheelShift, uint64_t chunk, int phase, uint64_t &carry) {
+	const uint64_t *masks = wheelShift->masks + (uint64_t)phase * wheelShift->deltaGroups;
+	uint64_t low = carry;
+	uint64_t high = 0;
+	for (int g = 0; g < wheelShift->deltaGroups; g++) {
+		int delta = wheelShift->groupDelta[g];
+		uint64_t part = col[chunk] & masks[g];
+		low |= part << delta;
+		high |= (part >> 1) >> (CHUNK_BITS - 1 - delta);
+	}
+	col[chunk] = low;
+	carry = high;
+}
+
+// Multiplies along the first two chunks bit by bit, as a multiplied bit can land in the same or the
+// next chunk there. From chunk 2 on, copyAlongToMultiplyWheel() only ever writes to later chunks.
+template <int M>
+void initialiseWheelColFirstChunks(uint64_t *col, const struct residueWheel *wheel, uint64_t colBits, uint64_t multiplyAdjustment) {
+	uint64_t lastBit = std::min((uint64_t)(2 * CHUNK_BITS), colBits);
+	for (uint64_t j = 0; j < lastBit; j++) {
+		if ((col[j / CHUNK_BITS] & (1ULL << (j % CHUNK_BITS))) == 0) continue;
+		
+		uint64_t multipliedBit = wheelPositionOf(wheel, M * wheelValueAt(wheel, j)) + multiplyAdjustment;
+		if (multipliedBit < colBits) {
+			col[multipliedBit / CHUNK_BITS] |= 1ULL << (multipliedBit % CHUNK_BITS);
+		}
+	}
+}
+
+inline void reportWheelZeros(const struct residueWheel *wheel, uint64_t chunk, uint64_t bitOffset, const struct columnSieveCallbacks &callbacks) {
+	if (!callbacks.zeroFound) return;
+	
+	// Find & report the position of the OFF bits, offset by bitOffset
+	for (uint64_t i = 0; i < CHUNK_BITS; i++) {
+		if ((~chunk) & (1ULL << i)) {
+			callbacks.zeroFound(wheelValueAt(wheel, bitOffset + i));
+		}
+	}
+}
+
+template <int M>
+void runWheelColumnSieve(struct wheelColumnSieve<M> *sieve, const struct columnSieveCallbacks &callbacks) {
+	if (sieve->finished) {
+		throw std::logic_error("Error: runWheelColumnSieve() has already been run on this sieve");
+	}
+	
+	const struct residueWheel *wheel = sieve->wheel;
+	uint64_t modulus = wheel->modulus;
+	int kept = wheel->kept;
+	uint64_t colLength = sieve->config.colLength;
+	uint64_t maxValueRepresentable = sieve->maxValueRepresentable;
+	uint64_t *expRegCol = sieve->expRegCol;
+	uint64_t *colsAggregate = sieve->colsAggregate;
+	
+	// One per shift, i.e. per distinct S^k % modulus, made when first needed
+	struct residueWheelShift **shifts = new struct residueWheelShift *[modulus]();
+	
+	// Setup column 0, i.e. ON at every power of M
+	for (uint64_t i = 1; i <= maxValueRepresentable; i *= M) {
+		uint64_t bitPos = wheelPositionOf(wheel, i);
+		expRegCol[bitPos / CHUNK_BITS] |= 1ULL << (bitPos % CHUNK_BITS);
+		
+		if (i > maxValueRepresentable / M) break;
+	}
+	
+	// Overlay column 0 onto the aggregate
+	for (uint64_t i = 0; i < colLength; i++) {
+		colsAggregate[i] |= expRegCol[i];
+	}
+	
+	// chunks of the aggregate before this have had their zeros reported
+	uint64_t zerosReportedUpToChunk = 0;
+	
+	// Everything below the first value of the next column is final, so report zeros up to there
+	#define reportFinalZeros(nextFirstValueRepresented) { \
+		uint64_t finalUpToChunk = colLength; \
+		if ((nextFirstValueRepresented) <= maxValueRepresentable) { \
+			uint64_t nextFirst = (nextFirstValueRepresented); \
+			while (!wheelKeeps(wheel, nextFirst)) nextFirst++; \
+			finalUpToChunk = std::min(colLength, wheelPositionOf(wheel, nextFirst) / CHUNK_BITS); \
+		} \
+		for (; zerosReportedUpToChunk < finalUpToChunk; zerosReportedUpToChunk++) { \
+			if (~colsAggregate[zerosReportedUpToChunk] != 0) { \
+				reportWheelZeros(wheel, colsAggregate[zerosReportedUpToChunk], zerosReportedUpToChunk * CHUNK_BITS, callbacks); \
+			} \
+		} \
+	}
+	
+	// Moves the column on to be relative to the next E_k, once chunk has been multiplied & aggregated
+	#define shiftToNextColumn() { \
+		if (shift != nullptr) shiftWheelChunk(expRegCol, shift, chunk, phase, shiftCarry); \
+	}
+	
+	uint64_t firstBitValueRepresented = 1;
+	uint64_t colStart = 0; // E_k, see above
+	uint64_t powerOfS = 1;
+	for (int powOfS = 1; true; powOfS++) {
+		if (powerOfS > UINT64_MAX / wheel->s) break;
+		powerOfS *= wheel->s;
+		if (powerOfS > maxValueRepresentable) break;
+		
+		reportFinalZeros(firstBitValueRepresented + powerOfS);
+		
+		firstBitValueRepresented += powerOfS;
+		if (firstBitValueRepresented > maxValueRepresentable) break;
+		
+		// Move the previous column's bits up by S^k % modulus, to be relative to the new colStart. The
+		// previous column has already done this for every chunk it got to, except for column 0.
+		colStart += modulus * (powerOfS / modulus);
+		if (powOfS == 1 && powerOfS % modulus != 0) {
+			struct residueWheelShift *shift = createResidueWheelShift(wheel, powerOfS % modulus);
+			uint64_t shiftCarry = 0;
+			int phase = 0;
+			for (uint64_t chunk = 0; chunk < colLength; chunk++) {
+				shiftToNextColumn();
+				phase = (phase + CHUNK_BITS % kept) % kept;
+			}
+			destroyResidueWheelShift(shift);
+		}
+		
+		// The shift at the end of this column, for the next one
+		uint64_t nextShift = (powerOfS % modulus) * (wheel->s % modulus) % modulus;
+		if (nextShift != 0 && shifts[nextShift] == nullptr) {
+			shifts[nextShift] = createResidueWheelShift(wheel, (int)nextShift);
+		}
+		const struct residueWheelShift *shift = shifts[nextShift];
+		uint64_t shiftCarry = 0;
+		
+		// As colStart is a multiple of modulus, column bit j is just aggAdjustment bits along in the
+		// aggregate, and M - 1 times as many when multiplying along the column
+		uint64_t aggAdjustment = (colStart / modulus) * kept;
+		uint64_t aggChunksAdjustment = aggAdjustment / CHUNK_BITS;
+		uint64_t aggBitsAdjustment = aggAdjustment % CHUNK_BITS;
+		uint64_t mulAdjustment = (M - 1) * aggAdjustment;
+		uint64_t mulChunksAdjustment = mulAdjustment / CHUNK_BITS;
+		uint64_t mulBitsAdjustment = mulAdjustment % CHUNK_BITS;
+		
+		// Chunks of the column beyond this are past the end of the aggregate, and as later columns start
+		// later still (and only shift bits up), nothing will ever need them
+		uint64_t lastChunkToAggregate = colLength - aggChunksAdjustment;
+		
+		// Chunks from this one on only multiply into chunks at or beyond lastChunkToAggregate
+		uint64_t lastChunkToMultiply = 0;
+		if (lastChunkToAggregate + 1 > mulChunksAdjustment) {
+			lastChunkToMultiply = std::min(lastChunkToAggregate, (lastChunkToAggregate + 1 - mulChunksAdjustment + M - 1) / M);
+		}
+		
+		initialiseWheelColFirstChunks<M>(expRegCol, wheel, lastChunkToAggregate * CHUNK_BITS, mulAdjustment);
+		
+		#define aggregate() { \
+			uint64_t *aggChunks = colsAggregate + chunk + aggChunksAdjustment; \
+			aggChunks[0] |= expRegCol[chunk] << aggBitsAdjustment; \
+			aggChunks[1] |= (expRegCol[chunk] >> 1) >> (CHUNK_BITS - 1 - aggBitsAdjustment); \
+		}
+		
+		#define multiply() { \
+			copyAlongToMultiplyWheel<M>(expRegCol, wheel, chunk, phase, mulChunksAdjustment, mulBitsAdjustment); \
+		}
+		
+		#define nextChunk() { \
+			phase = (phase + CHUNK_BITS % kept) % kept; \
+			if ((chunk & 0xFFFF) == 0 && callbacks.progress) { \
+				callbacks.progress(powOfS, chunk); \
+			} \
+		}
+		
+		uint64_t chunk = 0;
+		int phase = 0;
+		for (; chunk < std::min((uint64_t)2, lastChunkToAggregate); chunk++) {
+			aggregate();
+			shiftToNextColumn();
+			nextChunk();
+		}
+		
+		uint64_t firstLimit = std::min(lastChunkToMultiply, lastChunkToAggregate);
+		for (; chunk < firstLimit; chunk++) {
+			multiply();
+			aggregate();
+			shiftToNextColumn();
+			nextChunk();
+		}
+		
+		// Either done multiplying or done aggregating, so carry on with whichever isn't
+		for (; chunk < lastChunkToMultiply; chunk++) {
+			multiply();
+			nextChunk();
+		}
+		for (; chunk < lastChunkToAggregate; chunk++) {
+			aggregate();
+			shiftToNextColumn();
+			nextChunk();
+		}
+		
+		#undef aggregate
+		#undef multiply
+		#undef nextChunk
+		
+		if (callbacks.columnFinished) {
+			callbacks.columnFinished(powOfS, firstBitValueRepresented);
+		}
+	}
+	
+	// Nothing further can be reached, so the rest of the aggregate is final too
+	reportFinalZeros(maxValueRepresentable + 1);
+	
+	#undef reportFinalZeros
+	#undef shiftToNextColumn
+	
+	for (uint64_t i = 0; i < modulus; i++) {
+		destroyResidueWheelShift(shifts[i]);
+	}
+	delete[] shifts;
+	
+	sieve->finished = true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "math-utils.h"
+#include "backward-search.h"
+#include "meet-in-the-middle.h"
+#include "window-search.h"
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Small enough to build in well under a second either way, which for a narrow window can be most
+// of the time taken. meet-in-the-middle.h's bigger table when deciding is for values up to 2^128.
+const uint64_t WINDOW_LOW_MAX = 1ull << 22;
+
+// Counting, intervals narrower than this are split into single values. Makes 10^12 about 25%
+// faster than going on down to 1, and 10^9 5x faster than splitting the whole window.
+const uint64_t SPLIT_WIDTH = 16;
+
+// How many values are decided between calls to the progress callback
+const uint64_t VALUES_PER_PROGRESS = 1 << 16;
+
+// The window values base + scale * y for y in [low, high]
+struct windowInterval {
+	uint64_t base;
+	uint64_t scale;
+	uint64_t low;
+	uint64_t high;
+};
+
+static void reach(struct windowSearch *search, uint64_t value, uint64_t paths) {
+	uint64_t offset = value - search->config.lo;
+	search->pathsFound += paths;
+	if (search->config.countPaths) {
+		search->pathCounts[offset] += paths;
+	} else {
+		search->reachedBits[offset / 64] |= 1ull << (offset % 64);
+	}
+}
+
+// The paths to value with 3^lastPowOf3 as the last power added, or when deciding, nonzero if
+// there's any. Searched (and memoised) by meet-in-the-middle.h, with the low half's table.
+static uint64_t countSingle(struct windowSearch *search, uint64_t value, int lastPowOf3) {
+	return (uint64_t)countPathsFrom(search->lowHalf, value, lastPowOf3, !search->config.countPaths);
+}
+
+// Counts the paths to every y in the interval with 3^lastPowOf3 as the last power added
+static void countInterval(struct windowSearch *search, const struct windowInterval &interval, int lastPowOf3) {
+	uint64_t minSum = (uint64_t)pow3_128.minSums[lastPowOf3];
+	if (interval.high < minSum) return;
+	
+	// Only a few values left, so they're counted one by one, which lets the states they go through
+	// be memoised (they'll be met again from other branches)
+	if (interval.high - interval.low < SPLIT_WIDTH) {
+		for (uint64_t y = interval.low; y <= interval.high; y++) {
+			uint64_t count = countSingle(search, y, lastPowOf3);
+			if (count != 0) reach(search, interval.base + interval.scale * y, count);
+		}
+		return;
+	}
+	
+	search->statesVisited++;
+	
+	if (interval.high <= search->config.lowMax) {
+		for (uint64_t y = max(interval.low, minSum); y <= interval.high; y++) {
+			if (y % 3 == 0) continue;
+			
+			uint64_t count = lowHalfPaths(search->lowHalf, y, lastPowOf3);
+			if (count != 0) reach(search, interval.base + interval.scale * y, count);
+		}
+		return;
+	}
+	
+	if (lastPowOf3 == 0) {
+		// Only 2^e_0 left
+		int e = interval.low <= 1 ? 0 : floorLog2_64bit(interval.low - 1) + 1;
+		for (; e <= floorLog2_64bit(interval.high); e++) {
+			reach(search, interval.base + interval.scale * (1ull << e), 1);
+		}
+		return;
+	}
+	
+	// Every value with 3^lastPowOf3 as the last power is 2^e_k times at least minSum, so e_k only
+	// goes up to where that's past the top of the interval
+	uint64_t powOf3 = (uint64_t)pow3_128.powers[lastPowOf3];
+	int maxExp = floorLog2_64bit(interval.high / minSum);
+	for (int e = 0; e <= maxExp; e++) {
+		uint64_t low = ((interval.low - 1) >> e) + 1; // ceil(low / 2^e), as low >= 1
+		uint64_t high = interval.high >> e;
+		
+		struct windowInterval rest;
+		rest.base = interval.base + interval.scale * (powOf3 << e);
+		rest.scale = interval.scale << e;
+		rest.low = max(low, minSum) - powOf3;
+		rest.high = high - powOf3;
+		if (rest.low > rest.high) continue; // no multiple of 2^e in the interval
+		
+		countInterval(search, rest, lastPowOf3 - 1);
+	}
+}
+
+struct windowSearchConfig defaultWindowSearchConfig(uint64_t lo, uint64_t hi, bool countPaths) {
+	struct windowSearchConfig config;
+	config.lo = lo;
+	config.hi = hi;
+	config.countPaths = countPaths;
+	config.lowMax = min(WINDOW_LOW_MAX, max(hi, (uint64_t)2));
+	config.maxMemoEntries = 4000000; // about 300MB
+	return config;
+}
+
+struct windowSearch *createWindowSearch(struct windowSearchConfig config) {
+	if (config.lo < 1) {
+		throw out_of_range("lo < 1");
+	}
+	if (config.hi < config.lo) {
+		throw out_of_range("hi < lo");
+	}
+	if (config.hi >= 1ull << 63) {
+		throw out_of_range("hi >= 2^63");
+	}
+	
+	struct meetInTheMiddleConfig lowHalfConfig;
+	lowHalfConfig.lowMax = config.lowMax;
+	lowHalfConfig.countPaths = config.countPaths;
+	lowHalfConfig.maxHighMemoEntries = config.maxMemoEntries;
+	
+	struct windowSearch *search = new struct windowSearch;
+	search->config = config;
+	search->lowHalf = createMeetInTheMiddle(lowHalfConfig);
+	
+	uint64_t width = config.hi - config.lo + 1;
+	if (config.countPaths) {
+		search->pathCounts.assign(width, 0);
+	} else {
+		search->reachedBits.assign(width / 64 + 1, 0);
+	}
+	
+	search->statesVisited = 0;
+	search->memoHits = 0;
+	search->pathsFound = 0;
+	search->finished = false;
+	
+	return search;
+}
+
+void runWindowSearch(struct windowSearch *search, const struct windowSearchCallbacks &callbacks) {
+	if (search->finished) {
+		throw logic_error("Error: runWindowSearch() has already been run on this search");
+	}
+	
+	uint64_t lo = search->config.lo;
+	uint64_t hi = search->config.hi;
+	
+	if (search->config.countPaths) {
+		int maxPowOf3 = maxLastPowOf3(hi);
+		for (int lastPowOf3 = maxPowOf3; lastPowOf3 >= 0; lastPowOf3--) {
+			struct windowInterval window = { 0, 1, lo, hi };
+			countInterval(search, window, lastPowOf3);
+			
+			if (callbacks.progress) {
+				callbacks.progress(maxPowOf3 + 1 - lastPowOf3, maxPowOf3 + 1);
+			}
+		}
+	} else {
+		for (uint64_t value = lo; value <= hi; value++) {
+			for (int lastPowOf3 = maxLastPowOf3(value); lastPowOf3 >= 0; lastPowOf3--) {
+				if (countSingle(search, value, lastPowOf3) != 0) {
+					reach(search, value, 1);
+					break;
+				}
+			}
+			
+			if (callbacks.progress && ((value - lo + 1) % VALUES_PER_PROGRESS == 0 || value == hi)) {
+				callbacks.progress(value - lo + 1, hi - lo + 1);
+			}
+		}
+	}
+	
+	// The single values' states were counted by the low half
+	search->statesVisited += search->lowHalf->statesVisited;
+	search->memoHits += search->lowHalf->memoHits;
+	search->finished = true;
+	
+	if (callbacks.zeroFound) {
+		for (uint64_t value = lo; value <= hi; value++) {
+			if (value % 3 != 0 && !isReachableInWindow(search, value)) {
+				callbacks.zeroFound(value);
+			}
+		}
+	}
+}
+
+void destroyWindowSearch(struct windowSearch *search) {
+	if (search == nullptr) return;
+	
+	destroyMeetInTheMiddle(search->lowHalf);
+	delete search;
+}
+
+static void checkInWindow(const struct windowSearch *search, uint64_t value) {
+	if (!search->finished) {
+		throw logic_error("Error: the search result isn't final until runWindowSearch() has returned");
+	}
+	if (value < search->config.lo || value > search->config.hi) {
+		throw out_of_range(
+			string("Error: value '")
+			+ to_string(value)
+			+ "' is outside the window searched ["
+			+ to_string(search->config.lo)
+			+ ", "
+			+ to_string(search->config.hi)
+			+ "]."
+		);
+	}
+}
+
+bool isReachableInWindow(const struct windowSearch *search, uint64_t value) {
+	checkInWindow(search, value);
+	
+	uint64_t offset = value - search->config.lo;
+	if (search->config.countPaths) return search->pathCounts[offset] != 0;
+	return (search->reachedBits[offset / 64] >> (offset % 64)) & 1;
+}
+
+uint64_t getWindowPathCount(const struct windowSearch *search, uint64_t value) {
+	if (!search->config.countPaths) {
+		throw logic_error("Error: path counts weren't kept (countPaths = false)");
+	}
+	checkInWindow(search, value);
+	return search->pathCounts[value - search->config.lo];
+}
\ No newline at end of file
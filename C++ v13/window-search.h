@@ -0,0 +1,79 @@
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include "backward-search.h"
+#include "meet-in-the-middle.h"
+
+#ifndef WINDOW_SEARCH_H
+#define WINDOW_SEARCH_H
+
+// Zeros or path counts in just a window [lo, hi], anywhere below 2^63, with memory for just the
+// window. decision-tree-search.h can't do this cheaply: it can't skip anything below lo, as it
+// needs the states there to find the paths that go on into the window.
+//
+// Counting walks the decision tree from the other end instead. A path is sum(3^i * 2^e_i) for
+// i = 0 to k with e_0 >= ... >= e_k, and the exponents are picked from the last power down. Once
+// e_k is picked, everything left is 2^e_k * (a value with 3^(k-1) as the last power), so what's
+// left to find is the values in [ceil((lo - 3^k * 2^e_k) / 2^e_k), floor((hi - 3^k * 2^e_k) / 2^e_k)],
+// an interval about 2^e_k times narrower. A branch is cut off when:
+//  - its smallest completion, adding all the remaining powers with no more doublings, is past the
+//    top of the interval
+//  - the interval has no multiple of 2^e_k in it, so no completion can land in the window
+// Once an interval is down to a few values, each is counted on its own (memoised, as in
+// meet-in-the-middle.cpp), and below lowMax, counts come from meet-in-the-middle.h's low half table.
+//
+// Deciding goes straight to each value on its own, stopping at the first path, as there's no
+// early stop for a whole interval: at 10^9 that was 10x faster than walking the intervals.
+//
+// [10^9, 10^9 + 10^5] is decided in under a second, and [10^15, 10^15 + 300] in a few seconds.
+// Counting [10^9, 10^9 + 10^4] (11.6 million paths) takes about 3s. For wide windows (e.g. all of
+// [5 * 10^7, 1.3 * 10^8] takes about 10 minutes), the column sieve and path-count-sieve.h are far faster.
+
+struct windowSearchConfig {
+	uint64_t lo;
+	uint64_t hi; // < 2^63
+	bool countPaths; // count the paths to each value, rather than just whether there's one
+	uint64_t lowMax; // the largest value the low half table covers
+	
+	// Single value states already searched are remembered. The memo is cleared when it gets this
+	// big. 0 turns it off.
+	uint64_t maxMemoEntries;
+};
+
+// Any of these can be left empty
+struct windowSearchCallbacks {
+	// Called once for each non-trivial zero in the window, in increasing order, after the search has finished
+	std::function<void(uint64_t value)> zeroFound;
+	
+	// Counting, called after each last power of 3 is finished, out of every power up to the largest
+	// that fits below hi. Deciding, called every so often with how many values have been decided.
+	std::function<void(uint64_t done, uint64_t total)> progress;
+};
+
+struct windowSearch {
+	struct windowSearchConfig config;
+	
+	// Bit (or count) value - lo, only one of which is filled
+	std::vector<uint64_t> reachedBits;
+	std::vector<uint64_t> pathCounts;
+	
+	struct meetInTheMiddle *lowHalf; // created with the same countPaths, and memoising the single values' states
+	
+	uint64_t statesVisited; // above lowMax
+	uint64_t memoHits;
+	uint64_t pathsFound; // when deciding, just the number reached
+	bool finished;
+};
+
+struct windowSearchConfig defaultWindowSearchConfig(uint64_t lo, uint64_t hi, bool countPaths);
+
+struct windowSearch *createWindowSearch(struct windowSearchConfig config);
+void runWindowSearch(struct windowSearch *search, const struct windowSearchCallbacks &callbacks);
+void destroyWindowSearch(struct windowSearch *search);
+
+// Only valid after runWindowSearch() has returned. Throw std::out_of_range outside [lo, hi], and
+// getWindowPathCount() throws std::logic_error if the search wasn't counting.
+bool isReachableInWindow(const struct windowSearch *search, uint64_t value);
+uint64_t getWindowPathCount(const struct windowSearch *search, uint64_t value);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "work-queue.h"
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+void dealWork(vector<struct workQueue> &queues, uint64_t itemCount) {
+	for (uint64_t item = 0; item < itemCount; item++) {
+		queues[item % queues.size()].items.push_back(item);
+	}
+}
+
+bool takeWork(vector<struct workQueue> &queues, int thread, uint64_t *item) {
+	{
+		struct workQueue &own = queues[thread];
+		lock_guard<mutex> guard(own.lock);
+		if (!own.items.empty()) {
+			*item = own.items.front();
+			own.items.pop_front();
+			return true;
+		}
+	}
+	
+	int threads = queues.size();
+	for (int i = 1; i < threads; i++) {
+		struct workQueue &victim = queues[(thread + i) % threads];
+		lock_guard<mutex> guard(victim.lock);
+		if (!victim.items.empty()) {
+			*item = victim.items.back();
+			victim.items.pop_back();
+			return true;
+		}
+	}
+	
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+// Work items (just indexes, e.g. of blocks or subtrees) shared out between threads: each thread
+// has its own queue, taking from the front of it, and once that's empty steals from the back of
+// the others'. Used by batch-verifier.cpp and decision-tree-search.cpp, where every item is
+// queued before the threads start.
+
+struct workQueue {
+	std::mutex lock;
+	std::deque<uint64_t> items; // owner takes from the front, thieves from the back
+};
+
+// Deals items 0 to itemCount - 1 out in turn, so every queue gets a mix from the whole range
+void dealWork(std::vector<struct workQueue> &queues, uint64_t itemCount);
+
+// Takes the next item for thread, from its own queue or stolen from another. Returns false once
+// every queue is empty, which means the work's all taken, as nothing new is queued after dealWork().
+bool takeWork(std::vector<struct workQueue> &queues, int thread, uint64_t *item);
+
+#endif
\ No newline at end of file
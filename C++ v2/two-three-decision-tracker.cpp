@@ -7,9 +7,6 @@
 
 using namespace std;
 
-int tracker_n_copy;
-unsigned long long tracker_next;
-
 unsigned long long tracker_max;
 int* doublingsSinceLastPowerOfThree;
 int tracker_capacity; //TODO: will bounds checking be needed?
@@ -20,6 +17,13 @@ void initDecisionTracker(unsigned long long maximum) {
 	destructDecisionTracker(); // to be safe
 	
 	tracker_max = maximum;
+	
+	// Checked once here, so that threeToThe() doesn't need to on every tryAddNextPowerOf3()
+	if (getRequiredCapacity(tracker_max) > 40) {
+		cout << "Error: max too large, would overflow in 3^n function" << endl;
+		exit(-1);
+	}
+	
 	tracker_capacity = getRequiredCapacity(tracker_max);
 	doublingsSinceLastPowerOfThree = new int[tracker_capacity]();
 	tracker_count = 1;
@@ -34,7 +38,8 @@ int getRequiredCapacity(unsigned long long tracker_max) {
 	unsigned long long x = 1;
 	int i = 1;
 	while (x <= tracker_max) {
-		x += (unsigned long long)pow(3, i);
+		if (i >= 40) return i + 1; // past the end of threePowers, which initDecisionTracker() rejects
+		x += threeToThe(i);
 		i++;
 	}
 	return i; //might be one higher than needed, idk, but that's fine anyway
@@ -1,13 +1,12 @@
 // C# version has more comments & explanation; this is just the same thing with some further optimisations
 
+#include "math-utils.h"
+
 #ifndef TWO_THREE_DECISION_TRACKER_H
 #define TWO_THREE_DECISION_TRACKER_H
 
 extern unsigned long long tracker_current;
 
-extern int tracker_n_copy;
-extern unsigned long long tracker_next;
-
 extern unsigned long long tracker_max;
 extern int* doublingsSinceLastPowerOfThree;
 extern int tracker_capacity;
@@ -15,50 +14,92 @@ extern int tracker_count;
 
 extern unsigned long long repeated_doubling_ops;
 
+// What the progress poller sees. It runs on another thread, so rather than reading the globals above
+// while the search changes them, it reads a copy that the search publishes every
+// tracker_publish_interval backtracks, behind a seqlock (a sequence number that's odd while a copy
+// is being written, so a reader that sees it change mid-read just reads again). The search never
+// waits on the poller.
+struct trackerSnapshot {
+	unsigned long long max;
+	int capacity;
+	int count;
+	int doublings[40]; // doublingsSinceLastPowerOfThree, 0 past count
+	unsigned long long backtracks;
+	unsigned long long repeatedDoublingOps;
+	unsigned long long depthSamples[41]; // how many publishes found the tracker at each count
+	bool finished;
+};
+
+extern int tracker_publish_interval; // set before initDecisionTracker()
+extern int tracker_until_publish;
+extern unsigned long long tracker_depth_samples[41];
+
 void initDecisionTracker(unsigned long long maximum);
 void destructDecisionTracker();
 int getRequiredCapacity(unsigned long long max);
 
-#define trackerAtRoot() ( \
-	tracker_count == 1 && doublingsSinceLastPowerOfThree[0] == 0 \
-)
-
-#define lastAddedThreeExponent() ( \
-	tracker_count - 1 \
-)
-
-#define doubleNTimes(n) ( \
-	tracker_n_copy = n, \
-	doublingsSinceLastPowerOfThree[tracker_count - 1] += tracker_n_copy, \
-	tracker_current <<= tracker_n_copy \
-)
-
-#define halve() ( \
-	doublingsSinceLastPowerOfThree[tracker_count - 1]--, \
-	tracker_current /= 2 \
-)
-
-#define tryAddNextPowerOf3() ( \
-	tracker_next = tracker_current + threeToThe(tracker_count), ( \
-		tracker_next <= tracker_max \
-		? (tracker_count++, tracker_current = tracker_next, true) \
-		: false \
-	) \
-)
-
-#define backtrackAndCheckIfWasDoublingOp() ( \
-	doublingsSinceLastPowerOfThree[tracker_count - 1] > 0 \
-	? (tracker_current /= 2, doublingsSinceLastPowerOfThree[tracker_count - 1]--, true) \
-	: (tracker_count--, tracker_current -= threeToThe(tracker_count), false) \
-)
-
-#define getNumDoublingsBeforeExceedingMax() ( \
-	(int)floorLog2_64bit(tracker_max/tracker_current) \
-)
-
-#define doubleRepeatedlyUpToMax() ( \
-	repeated_doubling_ops++, \
-	doubleNTimes(getNumDoublingsBeforeExceedingMax()) \
-)
+void publishTrackerSnapshot(bool finished);
+
+// Returns false if nothing's been published yet
+bool readTrackerSnapshot(struct trackerSnapshot *snapshot);
+
+inline void countBacktrack() {
+	if (--tracker_until_publish == 0) {
+		tracker_depth_samples[tracker_count]++;
+		publishTrackerSnapshot(false);
+	}
+}
+
+inline bool trackerAtRoot() {
+	return tracker_count == 1 && doublingsSinceLastPowerOfThree[0] == 0;
+}
+
+inline int lastAddedThreeExponent() {
+	return tracker_count - 1;
+}
+
+inline void doubleNTimes(int n) {
+	doublingsSinceLastPowerOfThree[tracker_count - 1] += n;
+	tracker_current <<= n;
+}
+
+inline void halve() {
+	doublingsSinceLastPowerOfThree[tracker_count - 1]--;
+	tracker_current /= 2;
+}
+
+inline bool tryAddNextPowerOf3() {
+	unsigned long long next = tracker_current + threeToThe(tracker_count);
+	if (next <= tracker_max) {
+		tracker_count++;
+		tracker_current = next;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+inline bool backtrackAndCheckIfWasDoublingOp() {
+	countBacktrack();
+	
+	if (doublingsSinceLastPowerOfThree[tracker_count - 1] > 0) {
+		tracker_current /= 2;
+		doublingsSinceLastPowerOfThree[tracker_count - 1]--;
+		return true;
+	} else {
+		tracker_count--;
+		tracker_current -= threeToThe(tracker_count);
+		return false;
+	}
+}
+
+inline int getNumDoublingsBeforeExceedingMax() {
+	return floorLog2_64bit(tracker_max / tracker_current);
+}
+
+inline void doubleRepeatedlyUpToMax() {
+	repeated_doubling_ops++;
+	doubleNTimes(getNumDoublingsBeforeExceedingMax());
+}
 
 #endif
\ No newline at end of file
@@ -2,14 +2,13 @@
 
 #include "math-utils.h"
 #include "two-three-decision-tracker.h"
+#include <atomic>
+#include <cstring>
 #include <iostream>
 #include <cmath>
 
 using namespace std;
 
-int tracker_n_copy;
-unsigned long long tracker_next;
-
 unsigned long long tracker_max;
 int* doublingsSinceLastPowerOfThree;
 int tracker_capacity; //TODO: will bounds checking be needed?
@@ -18,17 +17,46 @@ unsigned long long tracker_current;
 
 unsigned long long repeated_doubling_ops;
 
+int tracker_publish_interval = 1 << 16;
+int tracker_until_publish;
+unsigned long long tracker_depth_samples[41];
+unsigned long long tracker_backtracks;
+
+// The snapshot is copied in and out as words, each an atomic, so that a torn read is only ever
+// thrown away rather than being a data race
+const int SNAPSHOT_WORDS = (sizeof(struct trackerSnapshot) + sizeof(unsigned long long) - 1) / sizeof(unsigned long long);
+atomic<unsigned int> snapshot_sequence(0); // 0 until the first publish
+atomic<unsigned long long> snapshot_words[SNAPSHOT_WORDS];
+
 void initDecisionTracker(unsigned long long maximum) {
 	destructDecisionTracker(); // to be safe
 	
 	tracker_max = maximum;
+	
+	// Checked once here, so that threeToThe() doesn't need to on every tryAddNextPowerOf3()
+	if (getRequiredCapacity(tracker_max) > 40) {
+		cout << "Error: max too large, would overflow in 3^n function" << endl;
+		exit(-1);
+	}
+	
 	tracker_capacity = getRequiredCapacity(tracker_max);
 	doublingsSinceLastPowerOfThree = new int[tracker_capacity]();
 	tracker_count = 1;
 	tracker_current = 1;
+	
+	repeated_doubling_ops = 0;
+	tracker_until_publish = tracker_publish_interval;
+	tracker_backtracks = 0;
+	memset(tracker_depth_samples, 0, sizeof(tracker_depth_samples));
+	
+	// Nothing's published until the search has backtracked, as the root alone would read as a
+	// path on its last branch
+	snapshot_sequence.store(0, memory_order_release);
 }
 
 void destructDecisionTracker() {
+	if (doublingsSinceLastPowerOfThree != nullptr) publishTrackerSnapshot(true);
+	
 	delete[] doublingsSinceLastPowerOfThree;
 	doublingsSinceLastPowerOfThree = nullptr;
 }
@@ -37,8 +65,56 @@ int getRequiredCapacity(unsigned long long tracker_max) {
 	unsigned long long x = 1;
 	int i = 1;
 	while (x <= tracker_max) {
-		x += (unsigned long long)pow(3, i);
+		if (i >= 40) return i + 1; // past the end of threePowers, which initDecisionTracker() rejects
+		x += threeToThe(i);
 		i++;
 	}
 	return i; //might be one higher than needed, idk, but that's fine anyway
+}
+
+void publishTrackerSnapshot(bool finished) {
+	tracker_backtracks += tracker_publish_interval - tracker_until_publish;
+	tracker_until_publish = tracker_publish_interval;
+	
+	struct trackerSnapshot snapshot = {};
+	snapshot.max = tracker_max;
+	snapshot.capacity = tracker_capacity;
+	snapshot.count = tracker_count;
+	memcpy(snapshot.doublings, doublingsSinceLastPowerOfThree, tracker_count * sizeof(int));
+	snapshot.backtracks = tracker_backtracks;
+	snapshot.repeatedDoublingOps = repeated_doubling_ops;
+	memcpy(snapshot.depthSamples, tracker_depth_samples, sizeof(tracker_depth_samples));
+	snapshot.finished = finished;
+	
+	unsigned long long words[SNAPSHOT_WORDS] = {};
+	memcpy(words, &snapshot, sizeof(snapshot));
+	
+	unsigned int sequence = snapshot_sequence.load(memory_order_relaxed);
+	snapshot_sequence.store(sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	
+	for (int i = 0; i < SNAPSHOT_WORDS; i++) {
+		snapshot_words[i].store(words[i], memory_order_relaxed);
+	}
+	
+	snapshot_sequence.store(sequence + 2, memory_order_release);
+}
+
+bool readTrackerSnapshot(struct trackerSnapshot *snapshot) {
+	unsigned long long words[SNAPSHOT_WORDS];
+	while (true) {
+		unsigned int sequence = snapshot_sequence.load(memory_order_acquire);
+		if (sequence == 0) return false;
+		if (sequence % 2 != 0) continue;
+		
+		for (int i = 0; i < SNAPSHOT_WORDS; i++) {
+			words[i] = snapshot_words[i].load(memory_order_relaxed);
+		}
+		
+		atomic_thread_fence(memory_order_acquire);
+		if (snapshot_sequence.load(memory_order_relaxed) == sequence) break;
+	}
+	
+	memcpy(snapshot, words, sizeof(*snapshot));
+	return true;
 }
\ No newline at end of file
@@ -17,7 +17,8 @@
 using namespace std;
 
 atomic_bool run_poll;
-atomic_bool ready_for_poll;
+
+const auto POLL_INTERVAL = 100ms;
 
 // 3 bytes is enough to go up to 3^1 + 3^2 + 3^3 + ... + 3^24 = 423,644,304,721
 // hopefully __attribute__((__packed__)) is enough to make this work in arrays, it seems to be so far
@@ -46,8 +47,6 @@ struct tripleByte *getExpansionRegister(unsigned long long max) {
 	std::chrono::duration<double> elapsed_seconds = alloc_end - alloc_start;
 	cout << "Allocation done in " << elapsed_seconds.count() << "s" << endl;
 	
-	ready_for_poll = true;
-	
 	// access the array using tripleByte size for indexing, then treat the resulting location as an unsigned int
 	#define curExpansionRegElement() ( \
 		*((unsigned int *)(expansionRegister + mapToAvoidMult3s(tracker_current))) \
@@ -105,7 +104,7 @@ vector<unsigned long long> *getNonTrivialZeros(unsigned long long max) {
 	for (unsigned long long i = 0; i < max + 1; i++) {
 		if (i % 3 != 0) {
 			struct tripleByte val = expansionRegister[mapToAvoidMult3s(i)];
-			if (val.bytes[0] == 0 && val.bytes[1] == 0 && val.bytes[2] == 0) {				
+			if (val.bytes[0] == 0 && val.bytes[1] == 0 && val.bytes[2] == 0) {
 				nonTrivialZeros->push_back(i);
 			}
 		}
@@ -117,11 +116,48 @@ vector<unsigned long long> *getNonTrivialZeros(unsigned long long max) {
 	return nonTrivialZeros;
 }
 
+// Treats every branch as the same size, at each level of the current path: the branches at a level
+// are its numbers of doublings, done from the most down to 0. Rough, as the subtrees with fewer
+// doublings near the top are far bigger, so it runs ahead early on.
+double estimateFractionDone(const struct trackerSnapshot &snapshot) {
+	if (snapshot.finished) return 1;
+	if (snapshot.backtracks == 0) return 0;
+	
+	double fraction = 0;
+	double weight = 1;
+	unsigned long long value = 1;
+	for (int i = 0; i < snapshot.count; i++) {
+		if (i > 0) value += threeToThe(i);
+		value <<= snapshot.doublings[i];
+		
+		int maxDoublings = snapshot.doublings[i] + floorLog2_64bit(snapshot.max / value);
+		fraction += weight * (maxDoublings - snapshot.doublings[i]) / (maxDoublings + 1);
+		weight /= maxDoublings + 1;
+	}
+	return fraction;
+}
+
+void printDepthSamples(const struct trackerSnapshot &snapshot) {
+	unsigned long long total = 0;
+	for (int i = 0; i <= snapshot.capacity; i++) total += snapshot.depthSamples[i];
+	if (total == 0) return;
+	
+	cout << "Powers of 3 on the path, sampled every " << tracker_publish_interval << " backtracks:" << endl;
+	for (int i = 0; i <= snapshot.capacity; i++) {
+		if (snapshot.depthSamples[i] == 0) continue;
+		
+		double share = (double)snapshot.depthSamples[i] / total;
+		printf("%3i | %6.2f%% | %s\n", i, share * 100, string((int)(share * 50 + 0.5), '#').c_str());
+	}
+	cout << endl;
+}
+
 void poll() {
-	while (run_poll && !ready_for_poll) { }
-	if (!run_poll) return;
-	
-	int prev_first = -1;
+	struct trackerSnapshot snapshot;
+	while (!readTrackerSnapshot(&snapshot)) {
+		if (!run_poll) return;
+		this_thread::sleep_for(POLL_INTERVAL);
+	}
 	
 	auto poll_start = chrono::system_clock::now();
 	time_t poll_start_time = chrono::system_clock::to_time_t(poll_start);
@@ -130,70 +166,62 @@ void poll() {
 	cout << endl << "Progress poll (started at " << poll_start_str << "):" << endl;
 	
 	string header1("x2 since last +3^n");
-	int leftover_length = max((int)(tracker_capacity * 3 - header1.length()), 0);
+	int leftover_length = max((int)(snapshot.capacity * 3 - header1.length()), 0);
 	cout << string((int)floor(leftover_length/2.0), ' ')
 		<< header1
 		<< string((int)ceil(leftover_length/2.0), ' ')
-		<< " |    rep x2 ops  |  sec elapsed"
+		<< " |  backtracks/s |  rep x2 ops/s |   done |  sec elapsed"
 		<< endl;
 	
+	int prev_first = snapshot.doublings[0];
 	auto prev_time = poll_start;
+	struct trackerSnapshot prev_snapshot = snapshot;
+	auto prev_snapshot_time = poll_start;
 	
-	while (run_poll && doublingsSinceLastPowerOfThree != nullptr) {
-		//	unsigned long long min_count = ULLONG_MAX;
-		//	unsigned long long min_current = ULLONG_MAX;
-		//	for (int i = 0; i < 1000000; i++) {
-		//		unsigned long long temp_count = tracker_count;
-		//		unsigned long long temp_current = tracker_current;
-		//		
-		//		if (temp_count < min_count) min_count = temp_count;
-		//		if (temp_current < min_current) min_current = temp_current;
-		//	}
-		//	
-		//	unsigned long long count_display = (unsigned long long)(pow(10, min_count + 1) - 1)/9;
-		//	
-		//	printf("%20llu %20llu\r", count_display, min_current);
+	while (true) {
+		this_thread::sleep_for(POLL_INTERVAL);
 		
-		this_thread::sleep_for(1ms);
+		// Read after run_poll, so that the last snapshot is always shown
+		bool stopping = !run_poll;
+		readTrackerSnapshot(&snapshot);
+		auto time_now = chrono::system_clock::now();
 		
-		bool first_changed;
-		for (int i = 0; i < tracker_capacity; i++) {
-			int* temp = doublingsSinceLastPowerOfThree;
-			if (doublingsSinceLastPowerOfThree == nullptr) goto stop_poll;
-			
-			int val = temp[i];
-			if (doublingsSinceLastPowerOfThree == nullptr) goto stop_poll;
-			
-			if (i == 0) {
-				first_changed = prev_first >= 0 && val != prev_first;
-				prev_first = val;
-				
-				if (first_changed) {
-					auto time_now = chrono::system_clock::now();
-					std::chrono::duration<double> elapsed_seconds = time_now - prev_time;
-					prev_time = time_now;
-					repeated_doubling_ops = 0;
-					cout << " |  " << elapsed_seconds.count() << "s" << endl;
-				}
-				printf("\r");
-			}
-			printf("%2i ", val);
+		if (snapshot.doublings[0] != prev_first) {
+			std::chrono::duration<double> elapsed_seconds = time_now - prev_time;
+			prev_time = time_now;
+			prev_first = snapshot.doublings[0];
+			cout << " |  " << elapsed_seconds.count() << "s" << endl;
+		}
+		
+		std::chrono::duration<double> interval_seconds = time_now - prev_snapshot_time;
+		double backtracks_per_sec = (snapshot.backtracks - prev_snapshot.backtracks) / interval_seconds.count();
+		double repeated_doubling_ops_per_sec =
+			(snapshot.repeatedDoublingOps - prev_snapshot.repeatedDoublingOps) / interval_seconds.count();
+		prev_snapshot = snapshot;
+		prev_snapshot_time = time_now;
+		
+		printf("\r");
+		for (int i = 0; i < snapshot.capacity; i++) {
+			printf("%2i ", snapshot.doublings[i]);
 		}
-		printf(" | %13llu ", repeated_doubling_ops);
+		printf(" | %13.4g | %13.4g | %6.2f%%",
+			backtracks_per_sec, repeated_doubling_ops_per_sec, estimateFractionDone(snapshot) * 100);
+		fflush(stdout);
+		
+		if (snapshot.finished || stopping) break;
 	}
 	
-stop_poll:
-	
 	auto time_now = chrono::system_clock::now();
 	std::chrono::duration<double> elapsed_seconds = time_now - prev_time;
 	cout << " |  " << elapsed_seconds.count() << endl;
 	
 	cout << endl;
+	
+	printDepthSamples(snapshot);
 }
 
 void printNonTrivialZeros(unsigned long long max) {
 	run_poll = true;
-	ready_for_poll = false;
 	thread poller(poll);
 	
 	vector<unsigned long long> *zeroes = getNonTrivialZeros(max);
@@ -210,7 +238,6 @@ void printNonTrivialZeros(unsigned long long max) {
 
 void printExpansionRegister(unsigned long long max) {
 	run_poll = true;
-	ready_for_poll = false;
 	thread poller(poll);
 	
 	struct tripleByte *expansionRegister = getExpansionRegister(max);
@@ -252,6 +279,15 @@ int main(int argc, char *argv[]) {
 	
 	unsigned long long max = strtoull(argv[1], nullptr, 10);
 	
+	// How many backtracks between snapshots for the progress poll
+	if (argc >= 3) {
+		tracker_publish_interval = atoi(argv[2]);
+		if (tracker_publish_interval < 1) {
+			cout << "Error: publish interval < 1" << endl;
+			return -1;
+		}
+	}
+	
 	auto start = chrono::system_clock::now();
 	time_t start_time = chrono::system_clock::to_time_t(start);
 	cout << "Started at: " << ctime(&start_time) << flush; // ctime() adds a newline
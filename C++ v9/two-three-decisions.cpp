@@ -2,25 +2,33 @@
 #include <atomic>
 #include <bitset>
 #include <chrono>
+#include <cerrno>
 #include <climits>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <vector>
 #include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace std;
 
 const int CHUNK_BITS = 64;
 
+// The array is a memfd mapped twice back to back, so array[capacity + i] is array[i], and a write
+// that wraps around the end of the ring is just a write past it. With the capacity a power of 2,
+// wrapping a position is a mask rather than a division.
 struct expansionRegisterColumn {
 	uint64_t *array;
-	uint64_t capacity; // measured in CHUNK_BITS-long chunks (i.e. the number of uint64_t's in the array)
-	uint64_t currentArrayPos; // measured in bits
+	int fd;
+	uint64_t capacity; // measured in CHUNK_BITS-long chunks (i.e. the number of uint64_t's in the array). A power of 2, and a whole number of pages
+	uint64_t currentArrayPos; // measured in bits, < capacity * CHUNK_BITS
 	uint64_t currentVal;
 	uint64_t size; // measured in CHUNK_BITS-long chunks
 };
@@ -70,6 +78,25 @@ bool hasONbitsAtMultiplesOf3(uint64_t x) {
 	//	return ((~x & mask) != mask) && ((~x & (mask << 1)) != (mask << 1)) && ((~x & (mask << 2)) != (mask << 2));
 }
 
+void throwSystemError(string call) {
+	throw runtime_error(string("Error: ") + call + " failed: " + strerror(errno));
+}
+
+// Maps fd from its start, bytes long, at the address at, replacing whatever was mapped there
+void mapView(uint64_t *at, uint64_t bytes, int fd) {
+	if (mmap(at, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		throwSystemError("mmap");
+	}
+}
+
+// The smallest power of 2 that's at least capacity and a whole number of pages (a double mapping
+// can't be any finer)
+uint64_t roundUpRingCapacity(uint64_t capacity) {
+	uint64_t pageChunks = sysconf(_SC_PAGESIZE) / sizeof(uint64_t);
+	capacity = max(capacity, pageChunks);
+	return isPowerOf2(capacity) ? capacity : 2ULL << floorLog2_64bit(capacity);
+}
+
 struct expansionRegisterColumn createExpansionRegCol(
 	uint64_t capacity,
 	uint64_t currentArrayPos,
@@ -77,7 +104,19 @@ struct expansionRegisterColumn createExpansionRegCol(
 	uint64_t firstChunkContents
 ) {
 	struct expansionRegisterColumn result;
-	result.array = new uint64_t[capacity]();
+	capacity = roundUpRingCapacity(capacity);
+	uint64_t bytes = capacity * sizeof(uint64_t);
+	
+	result.fd = memfd_create("expansionRegisterColumn", MFD_CLOEXEC);
+	if (result.fd == -1) throwSystemError("memfd_create");
+	if (ftruncate(result.fd, bytes) != 0) throwSystemError("ftruncate");
+	
+	// reserve room for both views first, so nothing else can be mapped in between them
+	void *reserved = mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (reserved == MAP_FAILED) throwSystemError("mmap");
+	result.array = (uint64_t *)reserved;
+	mapView(result.array, bytes, result.fd);
+	mapView(result.array + capacity, bytes, result.fd);
 	
 	result.capacity = capacity;
 	result.currentArrayPos = currentArrayPos;
@@ -100,7 +139,7 @@ void stepForwardChunk(struct expansionRegisterColumn *expRegCol) {
 	
 	uint64_t step = CHUNK_BITS;
 	expRegCol->currentVal += step;
-	expRegCol->currentArrayPos = (expRegCol->currentArrayPos + step) % (expRegCol->capacity * CHUNK_BITS);
+	expRegCol->currentArrayPos = (expRegCol->currentArrayPos + step) & (expRegCol->capacity * CHUNK_BITS - 1);
 }
 
 bool valueInWriteableRange(struct expansionRegisterColumn *expRegCol, uint64_t value) {
@@ -116,22 +155,43 @@ bool valueInWriteableRange(struct expansionRegisterColumn *expRegCol, uint64_t v
 	return distToVal < (expRegCol->capacity * CHUNK_BITS - unusableBits);
 }
 
+// Doubles the capacity in place. Growing the memfd and moving the first view with mremap() keeps
+// every chunk at the same offset, so the only chunks that need moving are those that had wrapped
+// around, or the ones before the wrap if there are fewer of those.
 void expand(struct expansionRegisterColumn *expRegCol) {
-	struct expansionRegisterColumn result;
-	result.array = new uint64_t[expRegCol->capacity * 2]();
-	
-	result.capacity = expRegCol->capacity * 2;
-	result.currentArrayPos = expRegCol->currentArrayPos % CHUNK_BITS;
-	result.currentVal = expRegCol->currentVal;
-	result.size = expRegCol->size;
-	
-	uint64_t copyStartPos = expRegCol->currentArrayPos / CHUNK_BITS;
-	for (uint64_t i = 0; i < expRegCol->size; i++) {
-		result.array[i] = expRegCol->array[(copyStartPos + i) % expRegCol->capacity];
+	uint64_t capacity = expRegCol->capacity;
+	uint64_t bytes = capacity * sizeof(uint64_t);
+	
+	if (ftruncate(expRegCol->fd, 2 * bytes) != 0) throwSystemError("ftruncate");
+	
+	// The second view is in the way, so this always moves, leaving the old second view to unmap.
+	// The first view is made big enough for both, and its top half then becomes the new second view.
+	void *moved = mremap(expRegCol->array, bytes, 4 * bytes, MREMAP_MAYMOVE);
+	if (moved == MAP_FAILED) throwSystemError("mremap");
+	if (munmap(expRegCol->array + capacity, bytes) != 0) throwSystemError("munmap");
+	
+	uint64_t *array = (uint64_t *)moved;
+	mapView(array + 2 * capacity, 2 * bytes, expRegCol->fd);
+	
+	// size can be more than the capacity (it's never stopped from going below 0 in stepForwardChunk()),
+	// but everything outside the used chunks is 0, so moving too many is harmless
+	uint64_t start = expRegCol->currentArrayPos / CHUNK_BITS;
+	uint64_t used = min(expRegCol->size, capacity);
+	if (start + used > capacity) {
+		uint64_t wrapped = start + used - capacity;
+		uint64_t beforeWrap = capacity - start;
+		if (wrapped <= beforeWrap) {
+			memcpy(array + capacity, array, wrapped * sizeof(uint64_t));
+			memset(array, 0, wrapped * sizeof(uint64_t));
+		} else {
+			memcpy(array + start + capacity, array + start, beforeWrap * sizeof(uint64_t));
+			memset(array + start, 0, beforeWrap * sizeof(uint64_t));
+			expRegCol->currentArrayPos += capacity * CHUNK_BITS;
+		}
 	}
 	
-	delete[] expRegCol->array;
-	*expRegCol = result;
+	expRegCol->array = array;
+	expRegCol->capacity = capacity * 2;
 }
 
 uint64_t *getChunkHolding(
@@ -157,8 +217,9 @@ uint64_t *getChunkHolding(
 	uint64_t distToVal = value - expRegCol->currentVal;
 	uint64_t valPos = expRegCol->currentArrayPos + distToVal;
 	
-	// we've already ensured that value is in the writeable range, so its safe to just wrap valPos around.
-	uint64_t *valChunk = expRegCol->array + ((valPos / CHUNK_BITS) % expRegCol->capacity);
+	// we've already ensured that value is in the writeable range, so valPos is less than a capacity past
+	// currentArrayPos, which puts it in the second view at worst, and no wrapping is needed.
+	uint64_t *valChunk = expRegCol->array + valPos / CHUNK_BITS;
 	
 	*offsetIntoChunk = valPos % CHUNK_BITS;
 	*minSizeIfWriteHere = valPos/CHUNK_BITS - expRegCol->currentArrayPos/CHUNK_BITS + 1;
@@ -222,31 +283,33 @@ void growExpRegIfLastColumn(vector<struct expansionRegisterColumn> *expReg, int
 	}
 }
 
-void copyAlongByPowerOfThree(vector<struct expansionRegisterColumn> *expReg, int colNum, uint64_t chunkContents, uint64_t startSize) {
-	uint64_t pow = threeToThe(colNum + 1);
-	
-	growExpRegIfLastColumn(expReg, colNum, pow, startSize);
-	
-	struct expansionRegisterColumn *currentCol = &((*expReg)[colNum]);
-	struct expansionRegisterColumn *nextCol = &((*expReg)[colNum + 1]);
-	
+// ORs chunkContents, from offsetIntoSourceChunk on, into destCol starting at destVal
+void copyChunkAlong(struct expansionRegisterColumn *destCol, uint64_t destVal, int offsetIntoSourceChunk, uint64_t chunkContents) {
 	uint64_t minSizeAfterWrite;
 	int offsetIntoDestChunk;
 	uint64_t *destChunkTwo = getChunkHolding(
-		nextCol,
-		currentCol->currentVal + pow + CHUNK_BITS,
+		destCol,
+		destVal + CHUNK_BITS,
 		&offsetIntoDestChunk, // will be the same for first and second dest chunks, i.e. regardless of adding any multiple of CHUNK_BITS
 		&minSizeAfterWrite
 	);
-	uint64_t offsetToTwo = destChunkTwo - nextCol->array;
-	uint64_t *destChunkOne = nextCol->array + (offsetToTwo + nextCol->capacity - 1) % nextCol->capacity;
+	uint64_t *destChunkOne = destChunkTwo - 1; // never before the current chunk, so still inside the mapping
 	
-	int offsetIntoCurrentChunk = currentCol->currentArrayPos % CHUNK_BITS;
+	*destChunkOne |= ((chunkContents >> offsetIntoSourceChunk) << offsetIntoDestChunk);
+	*destChunkTwo |= ((chunkContents >> offsetIntoSourceChunk) >> (CHUNK_BITS - offsetIntoDestChunk));
 	
-	*destChunkOne |= ((chunkContents >> offsetIntoCurrentChunk) << offsetIntoDestChunk);
-	*destChunkTwo |= ((chunkContents >> offsetIntoCurrentChunk) >> (CHUNK_BITS - offsetIntoDestChunk));
+	destCol->size = max(destCol->size, minSizeAfterWrite);
+}
+
+void copyAlongByPowerOfThree(vector<struct expansionRegisterColumn> *expReg, int colNum, uint64_t chunkContents, uint64_t startSize) {
+	uint64_t pow = threeToThe(colNum + 1);
+	
+	growExpRegIfLastColumn(expReg, colNum, pow, startSize);
 	
-	nextCol->size = max(nextCol->size, minSizeAfterWrite);
+	struct expansionRegisterColumn *currentCol = &((*expReg)[colNum]);
+	struct expansionRegisterColumn *nextCol = &((*expReg)[colNum + 1]);
+	
+	copyChunkAlong(nextCol, currentCol->currentVal + pow, currentCol->currentArrayPos % CHUNK_BITS, chunkContents);
 }
 
 void copyAlongToDoubleCurrentPos(struct expansionRegisterColumn *expRegCol, uint64_t chunkContents) {
@@ -258,8 +321,7 @@ void copyAlongToDoubleCurrentPos(struct expansionRegisterColumn *expRegCol, uint
 		&ignored,
 		&minSizeAfterWrite
 	);
-	uint64_t offsetToTwo = destChunkTwo - expRegCol->array;
-	uint64_t *destChunkOne = expRegCol->array + (offsetToTwo + expRegCol->capacity - 1) % expRegCol->capacity;
+	uint64_t *destChunkOne = destChunkTwo - 1; // at least the current chunk, as currentVal * 2 >= currentVal
 	
 	spreadAndOrBits(chunkContents, destChunkOne, destChunkTwo);
 	
@@ -285,6 +347,7 @@ void populateColOneChunk(uint64_t curValue, uint64_t* chunkAggregate) {
 		// whenever chunk number == 2^n for some non-negative integer n
 		if (isPowerOf2(chunkNum)) { // isPowerOf2() breaks for zero but we've already checked it's not zero
 			chunkContents |= 0b00000000'00000001'00000000'00000000'00000001'00000000'00010000'01001001;
+			*chunkAggregate |= chunkContents;
 			return; // already set the LSB ON, so no need to check the next rule, which just does that
 		}
 		
@@ -318,23 +381,23 @@ void populateColOneChunk(uint64_t curValue, uint64_t* chunkAggregate) {
 		// isPowerOf2_safe(adjMask) && isPowerOf2_safe(twoBitsCleared) || twoBitsCleared == 0 && isPowerOf2_safe(oneApartMask)
 		// Where oneApartMask = clearedBit1 & (clearedBit2 >> 2), so the same thing as adjMask but checking
 		// if they're separated by a single OFF bit
-		// 
+		//
 		// Then simplify:
 		//
 		// Note: isPowerOf2_safe(x) is implemented as: x && !(x & (x - 1))
 		// The part in brackets corresponds to "x, with the last ON bit cleared" (relevant for some of the simplification)
-		// 
+		//
 		// isPowerOf2_safe(adjMask) && isPowerOf2_safe(twoBitsCleared) || twoBitsCleared == 0 && isPowerOf2_safe(oneApartMask)
 		// (adjMask && !(adjMask & (adjMask - 1))) && (twoBitsCleared && !(twoBitsCleared & (twoBitsCleared - 1))) || twoBitsCleared == 0 && (oneApartMask && !(oneApartMask & (oneApartMask - 1)))
 		// adjMask && !(adjMask & (adjMask - 1)) && twoBitsCleared && !(twoBitsCleared & (twoBitsCleared - 1)) || !twoBitsCleared && oneApartMask && !(oneApartMask & (oneApartMask - 1))
 		// twoBitsCleared && adjMask && !(adjMask & (adjMask - 1)) && !(twoBitsCleared & (twoBitsCleared - 1)) || !twoBitsCleared && oneApartMask && !(oneApartMask & (oneApartMask - 1))
 		// twoBitsCleared && adjMask && !(adjMask & (adjMask - 1) | twoBitsCleared & (twoBitsCleared - 1)) || !twoBitsCleared && oneApartMask && !(oneApartMask & (oneApartMask - 1))
 		// twoBitsCleared && adjMask && !(adjMask & (adjMask - 1) || twoBitsCleared & (twoBitsCleared - 1)) || !twoBitsCleared && oneApartMask && !(oneApartMask & (oneApartMask - 1))
-		// 
+		//
 		// Now, notice that twoBitsCleared appears at the start of one one side of the ||, while
 		// !twoBitsCleared appears at the start of the other side. This means we can check
 		// twoBitsCleared first, and only need to compute oneApartMask if it's false
-		// 
+		//
 		// So we have:
 		if (twoBitsCleared) {
 			if (adjMask && !(adjMask & (adjMask - 1) || twoBitsCleared & (twoBitsCleared - 1))) {
@@ -347,9 +410,46 @@ void populateColOneChunk(uint64_t curValue, uint64_t* chunkAggregate) {
 				chunkContents |= 1;
 			}
 		}
-		
+	
+	}
+	*chunkAggregate |= chunkContents;
+}
+
+// The aggregate for the chunk starting at curValue before any stored column is ORed in:
+// multiples of 3, and columns 0 and 1, which are computed rather than stored
+uint64_t getComputedChunkAggregate(uint64_t curValue) {
+	uint64_t chunkAggregate = 0x9249249249249249 >> (curValue % 3);
+	// ^ Hex constant is 1001001...1001001
+	// The shift moves it so that the ON bits are the bits which, in the
+	// current chunk, correspond to values that are multiples of 3.
+	
+	//i == 0:
+	if (curValue == 0) {
+		chunkAggregate |= 0b00000000'00000000'00000000'00000001'00000000'00000001'00000001'00010110;
+	} else if (isPowerOf2(curValue / CHUNK_BITS)) {
+		chunkAggregate |= 1;
+	}
+	
+	//i == 1:
+	populateColOneChunk(curValue, &chunkAggregate);
+	
+	return chunkAggregate;
+}
+
+void printZerosInChunk(uint64_t curValue, uint64_t chunkAggregate) {
+	if (chunkAggregate != ~0) { // if there are any bits that haven't been set to one - i.e. a value that wasn't reachable
+		// then find those bits & print the values they correspond to
+		for (int i = 0; i < CHUNK_BITS; i++) {
+			if ((~chunkAggregate) & (1ULL << i)) {
+				time_t time_now = chrono::system_clock::to_time_t(chrono::system_clock::now());
+				
+				cout << "\r" << "found zero: " << (curValue + i) << " @ " << ctime(&time_now); // ctime() adds a newline
+			}
+		}
+	}
+	else if (curValue % 5000 == 0) { // print progress every so often. Don't print too often or flush as either may slow things
+		cout << "\r" << "at: " << curValue;
 	}
-	chunkAggregate* |= chunkContents;
 }
 
 void findAndPrintZeros(uint64_t startSize) {
@@ -363,20 +463,7 @@ void findAndPrintZeros(uint64_t startSize) {
 	
 	for (uint64_t curValue = 0; true; curValue += CHUNK_BITS) {
 		
-		uint64_t chunkAggregate = 0x9249249249249249 >> (curValue % 3);
-		// ^ Hex constant is 1001001...1001001
-		// The shift moves it so that the ON bits are the bits which, in the
-		// current chunk, correspond to values that are multiples of 3.
-		
-		//i == 0:
-		if (curValue == 0) {
-			chunkAggregate |= 0b00000000'00000000'00000000'00000001'00000000'00000001'00000001'00010110;
-		} else if (isPowerOf2(curValue / CHUNK_BITS)) {
-			chunkAggregate |= 1;
-		}
-		
-		//i == 1:
-		populateColOneChunk(curValue, &chunkAggregate);
+		uint64_t chunkAggregate = getComputedChunkAggregate(curValue);
 		
 		// TODO: Currently I don't think the values in col 1 are used in any way to affect col 2,
 		// they just contribute to the aggregate. For col 0 this is fine, but not col 1 (unless we compute col 2 of course).
@@ -398,34 +485,347 @@ void findAndPrintZeros(uint64_t startSize) {
 			#undef currentCol
 		}
 		
-		if (chunkAggregate != ~0) { // if there are any bits that haven't been set to one - i.e. a value that wasn't reachable
-			// then find those bits & print the values they correspond to
-			for (int i = 0; i < CHUNK_BITS; i++) {
-				if ((~chunkAggregate) & (1ULL << i)) {
-					time_t time_now = chrono::system_clock::to_time_t(chrono::system_clock::now());
-					
-					cout << "\r" << "found zero: " << (curValue + i) << " @ " << ctime(&time_now); // ctime() adds a newline
-				}
+		printZerosInChunk(curValue, chunkAggregate);
+	}
+}
+
+// Bounded single producer, single consumer queue of chunks. Each side keeps its own copy of the
+// other's position, and only reloads it when the queue looks full (or empty), so most pushes and
+// pops don't touch the other thread's cache line.
+const uint64_t CHUNK_QUEUE_CAPACITY = 1 << 12; // a power of 2
+
+struct chunkQueue {
+	uint64_t slots[CHUNK_QUEUE_CAPACITY];
+	
+	alignas(64) atomic<uint64_t> pushed;
+	uint64_t poppedSeenByProducer;
+	
+	alignas(64) atomic<uint64_t> popped;
+	uint64_t pushedSeenByConsumer;
+};
+
+void initChunkQueue(struct chunkQueue *queue) {
+	queue->pushed.store(0);
+	queue->poppedSeenByProducer = 0;
+	queue->popped.store(0);
+	queue->pushedSeenByConsumer = 0;
+}
+
+void pushChunk(struct chunkQueue *queue, uint64_t chunk) {
+	uint64_t pushed = queue->pushed.load(memory_order_relaxed);
+	while (pushed - queue->poppedSeenByProducer == CHUNK_QUEUE_CAPACITY) {
+		queue->poppedSeenByProducer = queue->popped.load(memory_order_acquire);
+		if (pushed - queue->poppedSeenByProducer == CHUNK_QUEUE_CAPACITY) this_thread::yield();
+	}
+	
+	queue->slots[pushed & (CHUNK_QUEUE_CAPACITY - 1)] = chunk;
+	queue->pushed.store(pushed + 1, memory_order_release);
+}
+
+uint64_t popChunk(struct chunkQueue *queue) {
+	uint64_t popped = queue->popped.load(memory_order_relaxed);
+	while (popped == queue->pushedSeenByConsumer) {
+		queue->pushedSeenByConsumer = queue->pushed.load(memory_order_acquire);
+		if (popped == queue->pushedSeenByConsumer) this_thread::yield();
+	}
+	
+	uint64_t chunk = queue->slots[popped & (CHUNK_QUEUE_CAPACITY - 1)];
+	queue->popped.store(popped + 1, memory_order_release);
+	return chunk;
+}
+
+// Column i only ever writes to itself (doubling) and to column i + 1 (adding 3^(i+1)), so the
+// columns can run as a pipeline. Columns 2 and up are split into stages of columnsPerStage, each
+// with its own thread, which steps its columns through every chunk the same way
+// findAndPrintZeros() does. The last column of a stage passes each chunk's contents on to the
+// next stage, which does the shifted copy into its first column itself (so every ring is only ever
+// touched by one thread). Every column also passes its contents for each chunk to the main thread,
+// which ORs them into the aggregate and prints the zeros.
+//
+// A column's currentVal is always chunk aligned (columns start at a chunk boundary and step a
+// whole chunk), so a chunk's number is all a receiver needs to know to place it.
+
+const int MAX_PIPELINE_COLUMNS = 40; // one more than threePowers allows
+
+struct pipelineColumn {
+	struct expansionRegisterColumn col;
+	uint64_t startChunk;
+	struct chunkQueue toAggregate; // the column's contents for each chunk from startChunk on
+};
+
+struct pipelineStage {
+	int firstColumn;
+	uint64_t firstChunk;
+	
+	// Column firstColumn - 1's contents for each chunk from firstChunk on (the chunk firstColumn
+	// was created at). Unused by the first stage.
+	struct chunkQueue fromPreviousStage;
+	
+	thread worker;
+};
+
+struct columnPipeline {
+	uint64_t startSize;
+	int columnsPerStage;
+	
+	// Columns are only added by the stage holding the column before, and published through
+	// columnCount, so that the main thread knows whether to wait for one
+	struct pipelineColumn *columns[MAX_PIPELINE_COLUMNS];
+	atomic<int> columnCount;
+	
+	struct pipelineStage *stages[MAX_PIPELINE_COLUMNS];
+};
+
+int getStageNum(struct columnPipeline *pipeline, int colNum) {
+	return (colNum - 2) / pipeline->columnsPerStage;
+}
+
+void runPipelineStage(struct columnPipeline *pipeline, struct pipelineStage *stage);
+
+// Adds column colNum (which doesn't exist yet) starting at startVal, and a stage for it if it's the
+// first of one. Called while column colNum - 1 is on the chunk numbered chunkNum.
+void addPipelineColumn(struct columnPipeline *pipeline, int colNum, uint64_t startVal, uint64_t chunkNum) {
+	if (colNum >= MAX_PIPELINE_COLUMNS) {
+		throw overflow_error("Error: the pipeline has run out of columns (3^" + to_string(colNum) + " doesn't fit in 64 bits)");
+	}
+	
+	struct pipelineColumn *column = new struct pipelineColumn;
+	column->col = createExpansionRegCol(pipeline->startSize, 0, startVal, 0);
+	column->startChunk = startVal / CHUNK_BITS;
+	initChunkQueue(&column->toAggregate);
+	pipeline->columns[colNum] = column;
+	
+	struct pipelineStage *stage = nullptr;
+	if ((colNum - 2) % pipeline->columnsPerStage == 0) {
+		stage = new struct pipelineStage;
+		stage->firstColumn = colNum;
+		stage->firstChunk = chunkNum;
+		initChunkQueue(&stage->fromPreviousStage);
+		pipeline->stages[getStageNum(pipeline, colNum)] = stage;
+	}
+	
+	pipeline->columnCount.store(colNum + 1, memory_order_release);
+	
+	if (stage != nullptr) {
+		stage->worker = thread(runPipelineStage, pipeline, stage);
+	}
+}
+
+void runPipelineStage(struct columnPipeline *pipeline, struct pipelineStage *stage) {
+	int stageNum = getStageNum(pipeline, stage->firstColumn);
+	int stageEndColumn = stage->firstColumn + pipeline->columnsPerStage;
+	
+	// Only this thread adds columns up to stageEndColumn, once the first is there
+	int lastColumn = min(pipeline->columnCount.load(memory_order_acquire), stageEndColumn) - 1;
+	struct pipelineStage *nextStage = lastColumn == stageEndColumn - 1 ? pipeline->stages[stageNum + 1] : nullptr;
+	
+	for (uint64_t chunkNum = stage->firstChunk; true; chunkNum++) {
+		uint64_t curValue = chunkNum * CHUNK_BITS;
+		
+		if (stage->firstColumn > 2) {
+			uint64_t chunkContents = popChunk(&stage->fromPreviousStage);
+			if (chunkContents != 0) {
+				copyChunkAlong(
+					&pipeline->columns[stage->firstColumn]->col,
+					curValue + threeToThe(stage->firstColumn),
+					0,
+					chunkContents
+				);
 			}
 		}
-		else if (curValue % 5000 == 0) { // print progress every so often. Don't print too often or flush as either may slow things
-			cout << "\r" << "at: " << curValue;
+		
+		for (int i = stage->firstColumn; i <= lastColumn; i++) {
+			struct expansionRegisterColumn *currentCol = &pipeline->columns[i]->col;
+			if (!columnHasStarted(currentCol, i, curValue)) continue;
+			
+			uint64_t chunkContents = getCurrentChunkContents(currentCol);
+			
+			if (chunkContents != 0) { // otherwise no need to do any copying
+				uint64_t pow = threeToThe(i + 1);
+				
+				if (i == lastColumn && nextStage == nullptr) {
+					addPipelineColumn(pipeline, i + 1, currentCol->currentVal + pow - (currentCol->currentVal + pow) % CHUNK_BITS, chunkNum);
+					if (i + 1 < stageEndColumn) {
+						lastColumn++;
+					} else {
+						nextStage = pipeline->stages[stageNum + 1];
+					}
+				}
+				
+				if (i < lastColumn) {
+					copyChunkAlong(&pipeline->columns[i + 1]->col, currentCol->currentVal + pow, 0, chunkContents);
+				}
+				copyAlongToDoubleCurrentPos(currentCol, chunkContents);
+			}
+			
+			// once there's a next stage, it needs every chunk, so it knows when it's seen them all
+			if (i == stageEndColumn - 1 && nextStage != nullptr) {
+				pushChunk(&nextStage->fromPreviousStage, chunkContents);
+			}
+			
+			stepForwardChunk(currentCol);
+			pushChunk(&pipeline->columns[i]->toAggregate, chunkContents);
 		}
 	}
 }
 
-void printExpansionRegister(uint64_t startSize) {
+// The same output as findAndPrintZeros(), with the columns spread over threads as above. This
+// thread does the aggregating and printing.
+void findAndPrintZeros_pipelined(uint64_t startSize, int columnsPerStage) {
 	if (startSize < 1) {
 		throw out_of_range("startSize < 1");
 	}
+	if (columnsPerStage < 1) {
+		throw out_of_range("columnsPerStage < 1");
+	}
 	
 	vector<struct expansionRegisterColumn> expReg;
 	
 	initialiseExpRegFirstChunk(&expReg, startSize);
 	
+	struct columnPipeline *pipeline = new struct columnPipeline(); // stages[] must start out null
+	pipeline->startSize = startSize;
+	pipeline->columnsPerStage = columnsPerStage;
+	
+	// columns 0 and 1 are computed, so the pipeline starts at column 2
+	for (int i = 2; i < expReg.size(); i++) {
+		struct pipelineColumn *column = new struct pipelineColumn;
+		column->col = expReg[i];
+		column->startChunk = 0;
+		initChunkQueue(&column->toAggregate);
+		pipeline->columns[i] = column;
+		
+		if ((i - 2) % columnsPerStage == 0) {
+			struct pipelineStage *stage = new struct pipelineStage;
+			stage->firstColumn = i;
+			stage->firstChunk = 0;
+			initChunkQueue(&stage->fromPreviousStage);
+			pipeline->stages[getStageNum(pipeline, i)] = stage;
+		}
+	}
+	pipeline->columnCount.store(expReg.size());
+	
+	for (int i = 0; i <= getStageNum(pipeline, expReg.size() - 1); i++) {
+		pipeline->stages[i]->worker = thread(runPipelineStage, pipeline, pipeline->stages[i]);
+	}
+	
 	for (uint64_t curValue = 0; true; curValue += CHUNK_BITS) {
 		
-		vector<uint64_t> expansionRegPrint;
+		uint64_t chunkAggregate = getComputedChunkAggregate(curValue);
+		
+		// A column is always added before the one before it passes on the chunk it was added in,
+		// so by the time column i's chunk has been popped, columnCount covers column i + 1 if it
+		// has started. Columns start in order, so the first not to have started ends the chunk.
+		for (int i = 2; i < pipeline->columnCount.load(memory_order_acquire); i++) {
+			struct pipelineColumn *column = pipeline->columns[i];
+			if (column->startChunk > curValue / CHUNK_BITS) break;
+			
+			chunkAggregate |= popChunk(&column->toAggregate);
+		}
+		
+		printZerosInChunk(curValue, chunkAggregate);
+	}
+}
+
+// Each byte's bits as chars, so that 8 bits are formatted with one copy: highest bit first as '0'/'1'
+// for register rows, and lowest bit first as '-'/'#' for column chunks (as printUInt64Bits_cpu_reverse() does)
+struct bitCharsTable {
+	char highBitFirst[256][8];
+	char lowBitFirst[256][8];
+	
+	bitCharsTable() {
+		for (int byte = 0; byte < 256; byte++) {
+			for (int bit = 0; bit < 8; bit++) {
+				bool on = (byte >> bit) & 1;
+				highBitFirst[byte][7 - bit] = on ? '1' : '0';
+				lowBitFirst[byte][bit] = on ? '#' : '-';
+			}
+		}
+	}
+};
+
+const struct bitCharsTable BIT_CHARS;
+
+// Output is built up in a buffer and written in bulk, as a cout << per bit (and an endl, so a
+// flush, per line) kept the dumps to a few MB/s
+const uint64_t DUMP_BUFFER_BYTES = 1 << 22;
+
+struct dumpWriter {
+	ostream *out;
+	char *buffer;
+	uint64_t used;
+};
+
+struct dumpWriter createDumpWriter(ostream *out) {
+	struct dumpWriter writer;
+	writer.out = out;
+	writer.buffer = new char[DUMP_BUFFER_BYTES];
+	writer.used = 0;
+	return writer;
+}
+
+void flushDumpWriter(struct dumpWriter *writer) {
+	writer->out->write(writer->buffer, writer->used);
+	writer->out->flush();
+	writer->used = 0;
+}
+
+void destroyDumpWriter(struct dumpWriter *writer) {
+	flushDumpWriter(writer);
+	delete[] writer->buffer;
+}
+
+// Room for at least bytes more, which the caller fills and then adds to used
+char *reserveDumpBytes(struct dumpWriter *writer, uint64_t bytes) {
+	if (writer->used + bytes > DUMP_BUFFER_BYTES) {
+		flushDumpWriter(writer);
+	}
+	return writer->buffer + writer->used;
+}
+
+// One line, of whether each of the first columnCount columns reaches the value, the highest column
+// first. Formatted 8 columns at a time, so the last copy can run up to 7 bytes past the line,
+// before the newline's written over the first of them.
+void writeRegisterRow(struct dumpWriter *writer, uint64_t columnsReaching, int columnCount) {
+	char *dest = reserveDumpBytes(writer, columnCount + 8);
+	uint64_t highestFirst = columnsReaching << (64 - columnCount);
+	for (int done = 0; done < columnCount; done += 8) {
+		memcpy(dest + done, BIT_CHARS.highBitFirst[highestFirst >> 56], 8);
+		highestFirst <<= 8;
+	}
+	dest[columnCount] = '\n';
+	writer->used += columnCount + 1;
+}
+
+// One line of a chunk's 64 bits, the lowest (so the smallest value) first
+void writeChunkBits(struct dumpWriter *writer, uint64_t chunk) {
+	char *dest = reserveDumpBytes(writer, CHUNK_BITS + 1);
+	for (int byte = 0; byte < 8; byte++) {
+		memcpy(dest + byte * 8, BIT_CHARS.lowBitFirst[(chunk >> (byte * 8)) & 0xFF], 8);
+	}
+	dest[CHUNK_BITS] = '\n';
+	writer->used += CHUNK_BITS + 1;
+}
+
+// Writes the expansion register's row for each value in [from, to): either a line of '0'/'1' per
+// column, highest column first (the format of the expReg[k] sample files), or with binary, a
+// uint64_t per value (in the machine's byte order) with bit i ON if column i reaches the value.
+// Each chunk's columns are turned into per value rows with a 64x64 bit matrix transpose, rather than
+// a bit at a time.
+void dumpExpansionRegister(uint64_t startSize, uint64_t from, uint64_t to, bool binary, ostream &out) {
+	if (startSize < 1) {
+		throw out_of_range("startSize < 1");
+	}
+	
+	vector<struct expansionRegisterColumn> expReg;
+	
+	initialiseExpRegFirstChunk(&expReg, startSize);
+	
+	struct dumpWriter writer = createDumpWriter(&out);
+	
+	for (uint64_t curValue = 0; curValue < to; curValue += CHUNK_BITS) {
+		
+		uint64_t rows[CHUNK_BITS] = {}; // the column chunks, then once transposed, a row per value
 		
 		for (int i = 0; i < expReg.size(); i++) {
 			#define currentCol (&(expReg[i])) //can't store a pointer as it'll be invalidated if the vector grows (in copyAlongByPowerOfThree)
@@ -437,24 +837,38 @@ void printExpansionRegister(uint64_t startSize) {
 					copyAlongToDoubleCurrentPos(currentCol, chunkContents);
 				}
 				
-				expansionRegPrint.push_back(getCurrentChunkContents(currentCol));
+				rows[i] = getCurrentChunkContents(currentCol);
 				
 				stepForwardChunk(currentCol);
-			} else {
-				expansionRegPrint.push_back(0);
 			}
 			#undef currentCol
 		}
 		
-		for (int i = 0; i < CHUNK_BITS; i++) {
-			for (int j = expansionRegPrint.size() - 1; j >= 0; j--) {
-				uint64_t chunk = expansionRegPrint[j];
-				uint64_t bit = chunk & (1ULL << i);
-				cout << (bit != 0 ? "1" : "0");
+		if (curValue + CHUNK_BITS <= from) continue;
+		
+		if (expReg.size() > CHUNK_BITS) {
+			throw logic_error("Error: more columns than fit in a row");
+		}
+		transposeBitMatrix64(rows);
+		
+		uint64_t firstBit = from > curValue ? from - curValue : 0;
+		uint64_t endBit = min(to - curValue, (uint64_t)CHUNK_BITS);
+		if (binary) {
+			uint64_t bytes = (endBit - firstBit) * sizeof(uint64_t);
+			memcpy(reserveDumpBytes(&writer, bytes), rows + firstBit, bytes);
+			writer.used += bytes;
+		} else {
+			for (uint64_t bit = firstBit; bit < endBit; bit++) {
+				writeRegisterRow(&writer, rows[bit], expReg.size());
 			}
-			cout << endl;
 		}
 	}
+	
+	destroyDumpWriter(&writer);
+}
+
+void printExpansionRegister(uint64_t startSize) {
+	dumpExpansionRegister(startSize, 0, UINT64_MAX, false, cout);
 }
 
 void printExpansionRegColumn(uint64_t startSize, int printColumn) {
@@ -466,6 +880,8 @@ void printExpansionRegColumn(uint64_t startSize, int printColumn) {
 	
 	initialiseExpRegFirstChunk(&expReg, startSize);
 	
+	struct dumpWriter writer = createDumpWriter(&cout);
+	
 	for (uint64_t curValue = 0; true; curValue += CHUNK_BITS) {
 		for (int i = 0; i < expReg.size(); i++) {
 			#define currentCol (&(expReg[i])) //can't store a pointer as it'll be invalidated if the vector grows (in copyAlongByPowerOfThree)
@@ -478,9 +894,7 @@ void printExpansionRegColumn(uint64_t startSize, int printColumn) {
 				}
 				
 				if (i == printColumn) {
-					printUInt64Bits_cpu_reverse(getCurrentChunkContents(currentCol));
-					//cout << " @ " << (curValue / CHUNK_BITS) << endl;
-					cout << endl;
+					writeChunkBits(&writer, getCurrentChunkContents(currentCol));
 				}
 				
 				stepForwardChunk(&expReg[i]);
@@ -505,12 +919,26 @@ int main(int argc, char *argv[]) {
 	
 	uint64_t startSize = strtoull(argv[1], nullptr, 10);
 	
+	// a.out startSize dump from to [binary]: the expansion register's rows for [from, to) on stdout
+	// (see dumpExpansionRegister()), with nothing else printed
+	if (argc >= 5 && strcmp(argv[2], "dump") == 0) {
+		bool binary = argc >= 6 && strcmp(argv[5], "binary") == 0;
+		dumpExpansionRegister(startSize, strtoull(argv[3], nullptr, 10), strtoull(argv[4], nullptr, 10), binary, cout);
+		return 0;
+	}
+	
 	auto start = chrono::system_clock::now();
 	time_t start_time = chrono::system_clock::to_time_t(start);
 	cout << "Started at: " << ctime(&start_time); // ctime() adds a newline
 	cout << endl;
 	
-	findAndPrintZeros(startSize);
+	// a.out startSize [columnsPerThread]: with columnsPerThread, columns 2 and up are pipelined across
+	// threads, that many to a thread
+	if (argc >= 3) {
+		findAndPrintZeros_pipelined(startSize, atoi(argv[2]));
+	} else {
+		findAndPrintZeros(startSize);
+	}
 	//printExpansionRegister(startSize);
 	//printExpansionRegColumn(startSize, 6);
 }
\ No newline at end of file